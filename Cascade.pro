@@ -63,6 +63,7 @@ SOURCES += \
     src/docking/linux/FloatingWidgetTitleBar.cpp \
     src/inputhandler.cpp \
     src/isfmanager.cpp \
+    src/isfshadercache.cpp \
     src/log.cpp \
     src/main.cpp \
     src/mainmenu.cpp \
@@ -101,11 +102,31 @@ SOURCES += \
     src/properties/titlepropertyview.cpp \
     src/propertiesheading.cpp \
     src/propertiesview.cpp \
+    src/renderer/barrierplanner.cpp \
+    src/renderer/colorlut.cpp \
+    src/renderer/colorprocessorcache.cpp \
+    src/renderer/colorspacelut.cpp \
     src/renderer/cscommandbuffer.cpp \
+    src/renderer/csframegraph.cpp \
     src/renderer/csimage.cpp \
+    src/renderer/csimagecache.cpp \
+    src/renderer/csimagepool.cpp \
+    src/renderer/csmemoryallocator.cpp \
     src/renderer/cssettingsbuffer.cpp \
+    src/renderer/csstagingbuffer.cpp \
+    src/renderer/cstransientmemory.cpp \
+    src/renderer/imageupload.cpp \
+    src/renderer/pipelinecachefile.cpp \
+    src/renderer/pipelineregistry.cpp \
+    src/renderer/pointwisefusion.cpp \
+    src/renderer/rangeallocator.cpp \
+    src/renderer/renderjob.cpp \
     src/renderer/rendertask.cpp \
     src/renderer/rendertaskread.cpp \
+    src/renderer/renderthread.cpp \
+    src/renderer/spirvutility.cpp \
+    src/renderer/tiledwriter.cpp \
+    src/renderer/tileplanner.cpp \
     src/renderer/vulkanrenderer.cpp \
     src/rendermanager.cpp \
     src/shadercompiler/SpvShaderCompiler.cpp \
@@ -178,6 +199,7 @@ HEADERS += \
     src/global.h \
     src/inputhandler.h \
     src/isfmanager.h \
+    src/isfshadercache.h \
     src/log.h \
     src/mainmenu.h \
     src/mainwindow.h \
@@ -231,13 +253,34 @@ HEADERS += \
     src/properties/titlepropertyview.h \
     src/propertiesheading.h \
     src/propertiesview.h \
+    src/renderer/barrierplanner.h \
+    src/renderer/colorlut.h \
+    src/renderer/colorprocessorcache.h \
+    src/renderer/colorspacelut.h \
     src/renderer/cscommandbuffer.h \
+    src/renderer/csframegraph.h \
     src/renderer/csimage.h \
+    src/renderer/csimagecache.h \
+    src/renderer/csimagepool.h \
+    src/renderer/csmemoryallocator.h \
     src/renderer/cssettingsbuffer.h \
+    src/renderer/csstagingbuffer.h \
+    src/renderer/cstransientmemory.h \
+    src/renderer/imageupload.h \
+    src/renderer/pipelinecachefile.h \
+    src/renderer/pipelineregistry.h \
+    src/renderer/pointwisefusion.h \
+    src/renderer/rangeallocator.h \
+    src/renderer/renderbackend.h \
     src/renderer/renderconfig.h \
+    src/renderer/renderjob.h \
     src/renderer/rendertask.h \
     src/renderer/rendertaskread.h \
+    src/renderer/renderthread.h \
     src/renderer/renderutility.h \
+    src/renderer/spirvutility.h \
+    src/renderer/tiledwriter.h \
+    src/renderer/tileplanner.h \
     src/renderer/vulkanhppinclude.h \
     src/renderer/vulkanrenderer.h \
     src/rendermanager.h \
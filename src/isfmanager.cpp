@@ -23,10 +23,26 @@
 #include <QJsonObject>
 #include <QJsonArray>
 
+// Prevent tbb emit() from clashing with Qt
+#if defined(emit)
+    #undef emit
+    #include <tbb/parallel_for.h>
+    #include <tbb/task_arena.h>
+    #define emit
+#else
+    #include <tbb/parallel_for.h>
+    #include <tbb/task_arena.h>
+#endif // defined(emit)
+
 #include "log.h"
+#include "renderer/renderconfig.h"
 
 namespace Cascade {
 
+// Increase when convertISFShaderToCompute() changes,
+// so the shaders are compiled again instead of read from the cache
+static const int converterVersion = 1;
+
 ISFManager& ISFManager::getInstance()
 {
     static ISFManager instance;
@@ -34,9 +50,22 @@ ISFManager& ISFManager::getInstance()
     return instance;
 }
 
-const std::vector<unsigned int>& ISFManager::getShaderCode(const QString& nodeName)
+ISFManager::~ISFManager()
 {
-    return mIsfShaderCode.at(nodeName);
+    mStopping = true;
+
+    if (mBackgroundThread.joinable())
+        mBackgroundThread.join();
+}
+
+std::shared_future<std::vector<unsigned int>> ISFManager::getShaderCode(const QString& nodeName)
+{
+    Shader& shader = *mIsfShaders.at(nodeName);
+
+    // Not waiting for the background thread to get to it
+    compile(shader);
+
+    return shader.result;
 }
 
 const std::set<QString>& ISFManager::getCategories() const
@@ -60,8 +89,11 @@ void ISFManager::setUp()
     dir.setNameFilters(QStringList("*.fs"));
     dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
 
-    int success = 0;
-    int failure = 0;
+    mCache = std::make_unique<ISFShaderCache>(Renderer::pipelineCacheDir + "/isf");
+
+    const QString compilerVersion = QString::fromStdString(SpvCompiler::getVersion());
+
+    int cached = 0;
 
     QStringList fileList = dir.entryList();
     for (int i = 0; i < fileList.count(); ++i)
@@ -73,52 +105,108 @@ void ISFManager::setUp()
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
         {
             CS_LOG_WARNING("Could not read ISF shader file.");
+            continue;
         }
-        else
+
+        auto shader = std::make_unique<Shader>();
+        shader->name = "ISF " + fileName.split(".").first();
+        shader->result = shader->promise.get_future().share();
+
+        QByteArray source = file.readAll();
+        shader->key = ISFShaderCache::getKey(source, converterVersion, compilerVersion);
+
+        ISFShaderCache::Entry entry;
+        if (mCache->load(shader->key, entry))
         {
-            QString name = "ISF " + fileName.split(".").first();
+            cached++;
 
-            QString contents;
-            contents = file.readAll();
+            shader->properties = entry.properties;
+            shader->claimed.test_and_set();
+            shader->promise.set_value(std::move(entry.spirV));
+        }
+        else
+        {
+            // Only the header is needed now, the rest is compiled later
+            QString contents = source;
             QStringList split = contents.split("*/");
             QString json = split.first();
             json.remove(0, 2);
 
-            QByteArray shaderData = json.toUtf8();
-            QJsonDocument jsonData(QJsonDocument::fromJson(shaderData));
+            shader->properties = QJsonDocument::fromJson(json.toUtf8());
+            shader->code = split.last();
+        }
 
-            // Convert and compile shader
-            QString shader = convertISFShaderToCompute(split.last(), jsonData);
+        // Populate categories
+        QJsonObject propObject = shader->properties.object();
+        QJsonArray categoriesArray = propObject.value("CATEGORIES").toArray();
+        QString categoryName = categoriesArray.first().toString();
+        mIsfNodeCategories.insert(categoryName);
+        mIsfCategoryPerNode[shader->name] = categoryName;
 
-            //if (name == "ISF VHS Glitch")
-                //CS_LOG_INFO(shader);
+        // Create properties for the creation of the node
+        //mIsfNodeProperties[name] = createISFNodeProperties(propObject, name);
 
-            if (mCompiler.compileGLSLFromCode(shader.toLocal8Bit().data(), "comp"))
-            {
-                success++;
+        mIsfProperties[shader->name] = shader->properties;
+        mIsfShaders[shader->name] = std::move(shader);
+    }
+    CS_LOG_INFO("Loaded ISF shaders from cache:" + QString::number(cached));
 
-                // Populate categories
-                QJsonObject propObject = jsonData.object();
-                QJsonArray categoriesArray = propObject.value("CATEGORIES").toArray();
-                QString categoryName = categoriesArray.first().toString();
-                mIsfNodeCategories.insert(categoryName);
-                mIsfCategoryPerNode[name] = categoryName;
+    if (cached < static_cast<int>(mIsfShaders.size()))
+        mBackgroundThread = std::thread(&ISFManager::compileInBackground, this);
+}
 
-                // Create properties for the creation of the node
-                //mIsfNodeProperties[name] = createISFNodeProperties(propObject, name);
+void ISFManager::compile(Shader& shader)
+{
+    if (shader.claimed.test_and_set())
+        return;
 
-                this->mIsfShaderCode[name] = mCompiler.getSpirV();
-            }
-            else
-            {
-                CS_LOG_INFO("Compilation failed for:" + name);
-                CS_LOG_WARNING(QString::fromStdString(mCompiler.getError()));
-                failure++;
-            }
-        }
+    // Convert and compile shader
+    QString code = convertISFShaderToCompute(shader.code, shader.properties);
+
+    //if (shader.name == "ISF VHS Glitch")
+        //CS_LOG_INFO(code);
+
+    // One compiler per call, so shaders can be compiled in parallel
+    SpvCompiler compiler;
+
+    if (!compiler.compileGLSLFromCode(code.toLocal8Bit().data(), "comp"))
+    {
+        CS_LOG_INFO("Compilation failed for:" + shader.name);
+        CS_LOG_WARNING(QString::fromStdString(compiler.getError()));
+        mNumFailed++;
+
+        shader.promise.set_value({});
+        return;
     }
-    CS_LOG_INFO("Successfully compiled ISF shaders:" + QString::number(success));
-    CS_LOG_WARNING("Compilation failed for:" + QString::number(failure));
+
+    ISFShaderCache::Entry entry { shader.properties, compiler.getSpirV() };
+
+    if (!mCache->store(shader.key, entry))
+        CS_LOG_WARNING("Could not cache ISF shader:" + shader.name);
+
+    shader.promise.set_value(std::move(entry.spirV));
+}
+
+void ISFManager::compileInBackground()
+{
+    std::vector<Shader*> shaders;
+    for (auto& [name, shader] : mIsfShaders)
+        shaders.push_back(shader.get());
+
+    // Leaves a core to the GUI and the render thread
+    tbb::task_arena arena(std::max(1, tbb::this_task_arena::max_concurrency() - 1));
+    arena.execute([this, &shaders]()
+    {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, shaders.size()),
+            [this, &shaders](const tbb::blocked_range<size_t>& r)
+        {
+            for (size_t i = r.begin(); i != r.end() && !mStopping; ++i)
+                compile(*shaders[i]);
+        });
+    });
+
+    if (!mStopping)
+        CS_LOG_INFO("Compiled ISF shaders, failed:" + QString::number(mNumFailed));
 }
 
 //NodeInitProperties ISFManager::createISFNodeProperties(
@@ -20,11 +20,16 @@
 #ifndef ISFMANAGER_H
 #define ISFMANAGER_H
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <set>
+#include <thread>
 
 #include <QObject>
 #include <QJsonDocument>
 
+#include "isfshadercache.h"
 #include "shadercompiler/SpvShaderCompiler.h"
 //#include "nodegraph/nodedefinitions.h"
 
@@ -39,9 +44,16 @@ public:
     ISFManager(ISFManager const&) = delete;
     void operator=(ISFManager const&) = delete;
 
+    ~ISFManager();
+
+    // Reads the shader library, shaders that are not in the
+    // cache are compiled in the background afterwards
     void setUp();
 
-    const std::vector<unsigned int>& getShaderCode(const QString& nodeName);
+    // Compiles the shader right away if that has not started yet,
+    // otherwise the result may still be pending.
+    // Empty if the shader could not be compiled.
+    std::shared_future<std::vector<unsigned int>> getShaderCode(const QString& nodeName);
     const std::set<QString>& getCategories() const;
    // const std::map<QString, NodeInitProperties>& getNodeProperties() const;
     QString getCategoryPerNode(const QString& name) const;
@@ -49,6 +61,23 @@ public:
 private:
     ISFManager() {}
 
+    struct Shader
+    {
+        QString name;
+        QByteArray key;
+        QString code;
+        QJsonDocument properties;
+
+        // Set by whoever compiles the shader first
+        std::atomic_flag claimed = ATOMIC_FLAG_INIT;
+        std::promise<std::vector<unsigned int>> promise;
+        std::shared_future<std::vector<unsigned int>> result;
+    };
+
+    void compile(Shader& shader);
+
+    void compileInBackground();
+
     QString convertISFShaderToCompute(
             QString& shader,
             const QJsonDocument& properties);
@@ -65,13 +94,17 @@ private:
 
     int getIndexFromArray(const QJsonArray& array, const QString& value) const;
 
-    SpvCompiler mCompiler;
+    std::unique_ptr<ISFShaderCache> mCache;
 
     std::map<QString, QJsonDocument> mIsfProperties;
-    std::map<QString, std::vector<unsigned int>> mIsfShaderCode;
+    std::map<QString, std::unique_ptr<Shader>> mIsfShaders;
     std::set<QString> mIsfNodeCategories;
     //std::map<QString, NodeInitProperties> mIsfNodeProperties;
     std::map<QString, QString> mIsfCategoryPerNode;
+
+    std::thread mBackgroundThread;
+    std::atomic<bool> mStopping { false };
+    std::atomic<int> mNumFailed { 0 };
 };
 
 } // namespace Cascade
@@ -0,0 +1,113 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "isfshadercache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+namespace Cascade {
+
+// Start of the files and of valid SPIR-V
+static const quint32 fileMagic  = 0x43534953; // "CSIS"
+static const quint32 fileFormat = 1;
+static const unsigned int spirVMagic = 0x07230203;
+
+ISFShaderCache::ISFShaderCache(const QString& dir)
+    : mDir(dir)
+{}
+
+QByteArray ISFShaderCache::getKey(
+        const QByteArray& source,
+        const int converterVersion,
+        const QString& compilerVersion)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(source);
+    hash.addData("converter:" + QByteArray::number(converterVersion));
+    hash.addData("compiler:" + compilerVersion.toUtf8());
+
+    return hash.result();
+}
+
+bool ISFShaderCache::load(const QByteArray& key, Entry& entry) const
+{
+    QFile file(getPath(key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+
+    quint32 magic  = 0;
+    quint32 format = 0;
+    QByteArray properties;
+    QByteArray code;
+    QByteArray checksum;
+    in >> magic >> format >> properties >> code >> checksum;
+
+    if (in.status() != QDataStream::Ok || magic != fileMagic || format != fileFormat)
+        return false;
+
+    if (QCryptographicHash::hash(properties + code, QCryptographicHash::Sha1) != checksum)
+        return false;
+
+    if (code.size() < 4 || code.size() % sizeof(unsigned int) != 0)
+        return false;
+
+    std::vector<unsigned int> spirV(code.size() / sizeof(unsigned int));
+    memcpy(spirV.data(), code.constData(), code.size());
+    if (spirV.front() != spirVMagic)
+        return false;
+
+    entry.properties = QJsonDocument::fromJson(properties);
+    entry.spirV      = std::move(spirV);
+
+    return true;
+}
+
+bool ISFShaderCache::store(const QByteArray& key, const Entry& entry) const
+{
+    const QByteArray properties = entry.properties.toJson(QJsonDocument::Compact);
+    const QByteArray code(
+            reinterpret_cast<const char*>(entry.spirV.data()),
+            static_cast<int>(entry.spirV.size() * sizeof(unsigned int)));
+
+    QDir().mkpath(mDir);
+
+    // Another instance reading the file never sees half of it
+    QSaveFile file(getPath(key));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out << fileMagic << fileFormat << properties << code
+        << QCryptographicHash::hash(properties + code, QCryptographicHash::Sha1);
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+QString ISFShaderCache::getPath(const QByteArray& key) const
+{
+    return mDir + "/" + QString::fromLatin1(key.toHex()) + ".spv";
+}
+
+} // namespace Cascade
@@ -0,0 +1,63 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ISFSHADERCACHE_H
+#define ISFSHADERCACHE_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QString>
+
+namespace Cascade {
+
+// Compiled ISF shaders kept on disk, so a shader is only compiled again
+// when its file, the conversion to a compute shader or the compiler changes
+class ISFShaderCache
+{
+public:
+    struct Entry
+    {
+        // The JSON header of the ISF file
+        QJsonDocument properties;
+        std::vector<unsigned int> spirV;
+    };
+
+    explicit ISFShaderCache(const QString& dir);
+
+    // Identifies the compiled code of an ISF file
+    static QByteArray getKey(
+            const QByteArray& source,
+            const int converterVersion,
+            const QString& compilerVersion);
+
+    // False if there is no entry for the key or it is damaged
+    bool load(const QByteArray& key, Entry& entry) const;
+    bool store(const QByteArray& key, const Entry& entry) const;
+
+private:
+    QString getPath(const QByteArray& key) const;
+
+    QString mDir;
+};
+
+} // namespace Cascade
+
+#endif // ISFSHADERCACHE_H
@@ -32,6 +32,7 @@ Q_LOGGING_CATEGORY(lcVk, "qt.vulkan")
 std::shared_ptr<Log> Log::sLogger;
 QFile Log::sOutFile;
 QTextStream Log::sStream;
+std::mutex Log::sMutex;
 
 void Log::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
 {
@@ -93,11 +94,15 @@ void Log::fatal(const QString& s)
 
 void Log::console(const QString& s)
 {
+    std::lock_guard<std::mutex> lock(sMutex);
+
     std::cout << s.toStdString() << std::endl;
 }
 
 void Log::writeToFile(const QString& s)
 {
+    std::lock_guard<std::mutex> lock(sMutex);
+
     sStream << s << "\n";
     sStream.flush();
 }
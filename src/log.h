@@ -21,6 +21,7 @@
 #define LOG_H
 
 #include <memory>
+#include <mutex>
 
 #include <QString>
 #include <QFile>
@@ -58,6 +59,9 @@ private:
 
     static QFile sOutFile;
     static QTextStream sStream;
+
+    // Messages come from the GUI and the render thread
+    static std::mutex sMutex;
 };
 
 } // namespace Cascade
@@ -136,6 +136,13 @@ MainWindow::MainWindow(QWidget* parent)
         this,
         &MainWindow::handleDeviceLost);
 
+    // Only the visible part of the viewed node is rendered
+    connect(
+        mVulkanView->getVulkanWindow(),
+        &VulkanWindow::viewChanged,
+        mNodeGraph,
+        &NodeGraphView::requestDisplay);
+
     // Outgoing
     //    connect(this, &MainWindow::requestShutdown,
     //            mNodeGraph, &NodeGraph::handleShutdownRequest);
@@ -158,7 +165,7 @@ void MainWindow::handleRendererHasBeenCreated()
     // We are waiting for the renderer to be fully
     // initialized here before using it
     mRenderManager = &RenderManager::getInstance();
-    //mRenderManager->setUp(mVulkanView->getVulkanWindow()->getRenderer(), mNodeGraph);
+    mRenderManager->setUp(mVulkanView->getVulkanWindow()->getRenderer(), mNodeGraph);
 
     this->statusBar()->showMessage(
         "GPU: " + mVulkanView->getVulkanWindow()->getRenderer()->getGpuName());
@@ -229,6 +236,8 @@ void MainWindow::closeEvent(QCloseEvent* event)
 {
     emit requestShutdown();
 
+    RenderManager::getInstance().shutdown();
+
     mVulkanView->getVulkanWindow()->getRenderer()->shutdown();
 
     QMainWindow::closeEvent(event);
@@ -1,6 +1,8 @@
 #ifndef MULTITHREADING_H
 #define MULTITHREADING_H
 
+#include <algorithm>
+
 #include <QString>
 
 #include <OpenColorIO/OpenColorIO.h>
@@ -42,40 +44,29 @@ void parallelArrayCopy(const float* src, float* dst, size_t width, size_t height
 
 }
 
-void applyColorToScanline(
-        OCIO::ConstCPUProcessorRcPtr processor,
-        float* pStart,
-        int idx,
-        int lineWidth)
-{
-    OCIO::PackedImageDesc desc(
-                pStart + idx * lineWidth * 4,
-                lineWidth,
-                1,
-                4);
-    processor->apply(desc);
-}
+// Rows are converted in chunks of about this many bytes, big enough for
+// the overhead of a call to disappear and small enough to stay in the cache
+inline constexpr size_t colorChunkSize = 256 * 1024;
 
-void parallelApplyColorSpace(
-        OCIO::ConstConfigRcPtr ocioConfig,
-        const QString& sourceColor,
-        const QString& dstColor,
+inline void parallelApplyColorSpace(
+        OCIO::ConstCPUProcessorRcPtr processor,
         float* pStart,
         int width,
         int height)
 {
-    OCIO::ConstProcessorRcPtr processor = ocioConfig->getProcessor(
-                sourceColor.toLocal8Bit(), dstColor.toLocal8Bit());
-
-    OCIO::ConstCPUProcessorRcPtr cpuProcessor = processor->getOptimizedCPUProcessor(OCIO::OPTIMIZATION_DEFAULT);
+    const size_t rowSize      = static_cast<size_t>(width) * 4 * sizeof(float);
+    const size_t rowsPerChunk = std::max<size_t>(1, colorChunkSize / rowSize);
 
-    parallel_for(blocked_range<size_t>(0, height),
+    parallel_for(blocked_range<size_t>(0, height, rowsPerChunk),
         [=](const tbb::blocked_range<size_t>& r)
     {
-        for(size_t i = r.begin(); i!=r.end(); ++i)
-
-            applyColorToScanline(cpuProcessor, pStart, i, width);
-    });
+        OCIO::PackedImageDesc desc(
+                    pStart + r.begin() * width * 4,
+                    width,
+                    r.size(),
+                    4);
+        processor->apply(desc);
+    }, tbb::simple_partitioner());
 }
 
 }
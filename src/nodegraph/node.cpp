@@ -57,8 +57,15 @@ Node::Node(std::unique_ptr<NodeDataModel>&& dataModel)
     mNodeGeometry.recalculateSize();
 
     // propagate data: model => node
-    //    connect(mNodeDataModel.get(), &NodeDataModel::dataUpdated,
-    //            this, &Node::onDataUpdated);
+    connect(mNodeDataModel.get(), &NodeDataModel::dataUpdated,
+            this, &Node::onDataUpdated);
+
+    // A changed property makes our result stale
+    for (auto& prop : mNodeDataModel->getPropertyModels())
+    {
+        connect(prop, &PropertyModel::valueChanged,
+                mNodeDataModel.get(), &NodeDataModel::invalidate);
+    }
 
     //    connect(mNodeDataModel.get(), &NodeDataModel::embeddedWidgetSizeUpdated,
     //            this, &Node::onNodeSizeUpdated );
@@ -228,16 +235,11 @@ bool Node::isLeaf() const
     return true;
 }
 
-void Node::view(const ViewerMode viewerMode)
+void Node::view( [[maybe_unused]] const ViewerMode viewerMode)
 {
     CS_LOG_INFO("Viewing");
 
     setIsViewed(true);
-
-    if (viewerMode == ViewerMode::Result)
-    {
-        //render();
-    }
 }
 
 bool Node::getIsViewed() const
@@ -252,9 +254,37 @@ void Node::setIsViewed(const bool viewed)
     mNodeGraphicsObject->update();
 }
 
-void Node::render()
+RenderTask* Node::prepareRenderTask()
 {
-    mNodeDataModel->getRenderTask()->execute();
+    auto task = mNodeDataModel->getRenderTask();
+
+    // Nothing to compute for this node
+    if (!task)
+        return nullptr;
+
+    std::vector<RenderTask*> inputs;
+    for (unsigned int i = 0; i < mNodeDataModel->nPorts(PortType::In); ++i)
+    {
+        RenderTask* input = nullptr;
+
+        auto connections = nodeState().connections(PortType::In, i);
+        if (!connections.empty())
+        {
+            auto upstream = connections.begin()->second->getNode(PortType::Out);
+            input         = upstream->nodeDataModel()->getRenderTask();
+        }
+        inputs.push_back(input);
+    }
+    task->setInputs(inputs);
+
+    task->setPrecision(mNodeDataModel->precision());
+
+    auto data = mNodeDataModel->getPropertyData();
+
+    task->updateHash(mNodeDataModel->name(), data);
+    task->initialize(data);
+
+    return task;
 }
 
 void Node::propagateData(
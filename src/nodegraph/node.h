@@ -108,7 +108,9 @@ public:
 
     void setIsViewed(const bool viewed);
 
-    void render();
+    // Sets up the render task of this node with the tasks of the
+    // nodes above as inputs. Returns nullptr if there is nothing to render.
+    RenderTask* prepareRenderTask();
 
 public Q_SLOTS: // data propagation
     /// Propagates incoming data to the underlying model.
@@ -32,6 +32,7 @@
 
 using Cascade::Properties::PropertyModel;
 
+using Cascade::Renderer::ImagePrecision;
 using Cascade::Renderer::RenderTask;
 
 namespace Cascade::NodeGraph
@@ -68,6 +69,10 @@ public:
     std::vector<QString> mInPorts;
     std::vector<QString> mOutPorts;
 
+    // Nodes that need full float even if the project is set to
+    // half precision override this
+    ImagePrecision mPrecision = ImagePrecision::eDefault;
+
     std::vector<std::unique_ptr<PropertyModel>> mProperties;
 };
 } // namespace Cascade::NodeGraph
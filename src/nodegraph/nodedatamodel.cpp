@@ -55,3 +55,14 @@ void NodeDataModel::setNodeStyle(NodeStyle const& style)
 {
     mNodeStyle = style;
 }
+
+
+void NodeDataModel::invalidate()
+{
+    mIsDirty = true;
+
+    for (unsigned int i = 0; i < nPorts(PortType::Out); ++i)
+    {
+        Q_EMIT dataUpdated(i);
+    }
+}
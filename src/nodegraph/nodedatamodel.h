@@ -70,6 +70,11 @@ public:
         return mData.mName;
     }
 
+    ImagePrecision precision() const
+    {
+        return mData.mPrecision;
+    }
+
     /// Port caption is used in GUI to label individual ports
     virtual QString portCaption(PortType portType, PortIndex portIndex) const
     {
@@ -101,11 +106,32 @@ public:
         return views;
     }
 
+    std::vector<PropertyModel*> getPropertyModels()
+    {
+        std::vector<PropertyModel*> models;
+        for (auto& prop : mData.mProperties)
+        {
+            models.push_back(prop.get());
+        }
+        return models;
+    }
+
     RenderTask* getRenderTask()
     {
         return mRenderTask.get();
     };
 
+    /// A dirty node has to be rendered again before its result can be used
+    bool isDirty() const
+    {
+        return mIsDirty;
+    }
+
+    void setDirty(const bool dirty)
+    {
+        mIsDirty = dirty;
+    }
+
 public:
     QJsonObject save() const override;
 
@@ -157,8 +183,12 @@ public:
     void setNodeStyle(NodeStyle const& style);
 
 public:
-    /// Triggers the algorithm
-    virtual void setInData( [[maybe_unused]] std::shared_ptr<NodeData> nodeData, [[maybe_unused]] PortIndex port){};
+    /// Upstream data changed, our result is stale
+    virtual void setInData( [[maybe_unused]] std::shared_ptr<NodeData> nodeData, [[maybe_unused]] PortIndex port)
+    {
+        if (!mIsDirty)
+            invalidate();
+    };
 
     // Use this if portInConnectionPolicy returns ConnectionPolicy::Many
     virtual void setInData(
@@ -196,6 +226,9 @@ public:
     }
 
 public Q_SLOTS:
+    /// Marks the node dirty and notifies everything downstream
+    void invalidate();
+
     virtual void inputConnectionCreated(Connection const&) {}
 
     virtual void inputConnectionDeleted(Connection const&) {}
@@ -218,6 +251,8 @@ protected:
 
     std::unique_ptr<RenderTask> mRenderTask;
 
+    bool mIsDirty = true;
+
 private:
     NodeStyle mNodeStyle;
 };
@@ -19,6 +19,10 @@
 
 #include "nodegraphdatamodel.h"
 
+#include <algorithm>
+#include <functional>
+#include <set>
+
 namespace Cascade::NodeGraph
 {
 
@@ -40,6 +44,8 @@ NodeGraphDataModel::NodeGraphDataModel(
             this, &NodeGraphDataModel::sendConnectionCreatedToNodes);
     connect(this, &NodeGraphDataModel::connectionDeleted,
             this, &NodeGraphDataModel::sendConnectionDeletedToNodes);
+    connect(this, &NodeGraphDataModel::nodeCreated,
+            this, &NodeGraphDataModel::setupNodeSignals);
 }
 
 NodeGraphDataModel::~NodeGraphDataModel()
@@ -229,108 +235,130 @@ std::vector<Node*> NodeGraphDataModel::allNodes() const
 {
     std::vector<Node*> nodes;
 
-//    auto nodesMap = mData->getNodes();
+    auto& nodesMap = mData->getNodes();
 
-//    std::transform(nodesMap.begin(),
-//                   nodesMap.end(),
-//                   std::back_inserter(nodes),
-//                   [](std::pair<QUuid const, std::unique_ptr<Node>> const & p) { return p.second.get(); });
+    std::transform(nodesMap.begin(),
+                   nodesMap.end(),
+                   std::back_inserter(nodes),
+                   [](std::pair<QUuid const, std::unique_ptr<Node>> const & p) { return p.second.get(); });
 
     return nodes;
 }
 
 
-void NodeGraphDataModel::iterateOverNodes( [[maybe_unused]] std::function<void(Node*)> const& visitor)
+void NodeGraphDataModel::iterateOverNodes(std::function<void(Node*)> const& visitor)
+{
+    for (const auto& _node : mData->mNodes)
+    {
+        visitor(_node.second.get());
+    }
+}
+
+
+void NodeGraphDataModel::iterateOverNodeData(std::function<void(NodeDataModel*)> const& visitor)
 {
-//    for (const auto& _node : mNodes)
-//    {
-//        visitor(_node.second.get());
-//    }
+    for (const auto& _node : mData->mNodes)
+    {
+        visitor(_node.second->nodeDataModel());
+    }
 }
 
 
-void NodeGraphDataModel::iterateOverNodeData( [[maybe_unused]] std::function<void(NodeDataModel*)> const& visitor)
+void NodeGraphDataModel::iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const& visitor)
 {
-//    for (const auto& _node : mNodes)
-//    {
-//        visitor(_node.second->nodeDataModel());
-//    }
+    std::set<QUuid> visitedNodesSet;
+
+    //Iterate over root nodes
+    for (auto const &_node : mData->mNodes)
+    {
+        auto const &node = _node.second;
+
+        if (node->isRoot())
+        {
+            visitor(node->nodeDataModel());
+            visitedNodesSet.insert(node->id());
+        }
+    }
+
+    auto areNodeInputsVisitedBefore =
+        [&](Node &node)
+    {
+        for (auto& above : node.getNodesAbove())
+        {
+            if (visitedNodesSet.find(above->id()) == visitedNodesSet.end())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    //Iterate over dependent nodes
+    while (mData->mNodes.size() != visitedNodesSet.size())
+    {
+        for (auto const &_node : mData->mNodes)
+        {
+            auto const &node = _node.second;
+            if (visitedNodesSet.find(node->id()) != visitedNodesSet.end())
+                continue;
+
+            if (areNodeInputsVisitedBefore(*node))
+            {
+                visitor(node->nodeDataModel());
+                visitedNodesSet.insert(node->id());
+            }
+        }
+    }
 }
 
 
-void NodeGraphDataModel::iterateOverNodeDataDependentOrder( [[maybe_unused]] std::function<void(NodeDataModel*)> const& visitor)
+std::vector<Node*> NodeGraphDataModel::getUpstreamNodes(Node& node) const
 {
-//    std::set<QUuid> visitedNodesSet;
-
-//    //A leaf node is a node with no input ports, or all possible input ports empty
-//    auto isNodeLeaf =
-//        [](Node const &node, NodeDataModel const &model)
-//    {
-//        for (unsigned int i = 0; i < model.nPorts(PortType::In); ++i)
-//        {
-//            auto connections = node.nodeState().connections(PortType::In, i);
-//            if (!connections.empty())
-//            {
-//                return false;
-//            }
-//        }
-
-//        return true;
-//    };
-
-//    //Iterate over "leaf" nodes
-//    for (auto const &_node : mNodes)
-//    {
-//        auto const &node = _node.second;
-//        auto model       = node->nodeDataModel();
-
-//        if (isNodeLeaf(*node, *model))
-//        {
-//            visitor(model);
-//            visitedNodesSet.insert(node->id());
-//        }
-//    }
-
-//    auto areNodeInputsVisitedBefore =
-//        [&](Node const &node, NodeDataModel const &model)
-//    {
-//        for (size_t i = 0; i < model.nPorts(PortType::In); ++i)
-//        {
-//            auto connections = node.nodeState().connections(PortType::In, static_cast<PortIndex>(i));
-
-//            for (auto& conn : connections)
-//            {
-//                if (visitedNodesSet.find(conn.second->getNode(PortType::Out)->id()) == visitedNodesSet.end())
-//                {
-//                    return false;
-//                }
-//            }
-//        }
-
-//        return true;
-//    };
-
-//    //Iterate over dependent nodes
-//    while (mNodes.size() != visitedNodesSet.size())
-//    {
-//        for (auto const &_node : mNodes)
-//        {
-//            auto const &node = _node.second;
-//            if (visitedNodesSet.find(node->id()) != visitedNodesSet.end())
-//                continue;
-
-//            auto model = node->nodeDataModel();
-
-//            if (areNodeInputsVisitedBefore(*node, *model))
-//            {
-//                visitor(model);
-//                visitedNodesSet.insert(node->id());
-//            }
-//        }
-//    }
+    std::vector<Node*> nodes;
+    std::set<Node*> visited;
+
+    // Depth first, a node is added after all of its inputs
+    std::function<void(Node*)> visit = [&](Node* n)
+    {
+        if (!visited.insert(n).second)
+            return;
+
+        auto model = n->nodeDataModel();
+        for (unsigned int i = 0; i < model->nPorts(PortType::In); ++i)
+        {
+            for (auto& connection : n->nodeState().connections(PortType::In, i))
+            {
+                visit(connection.second->getNode(PortType::Out));
+            }
+        }
+        nodes.push_back(n);
+    };
+    visit(&node);
+
+    return nodes;
 }
 
 
+std::vector<Node*> NodeGraphDataModel::evaluate(Node& node)
+{
+    std::vector<Node*> preparedNodes;
+
+    for (auto& n : getUpstreamNodes(node))
+    {
+        auto model = n->nodeDataModel();
+
+        if (!model->isDirty())
+            continue;
+
+        n->prepareRenderTask();
+        model->setDirty(false);
+        preparedNodes.push_back(n);
+    }
+
+    return preparedNodes;
+}
+
 QPointF NodeGraphDataModel::getNodePosition(const Node& node) const
 {
     return node.nodeGraphicsObject().pos();
@@ -343,6 +371,23 @@ void NodeGraphDataModel::setNodePosition(Node& node, const QPointF& pos) const
     node.nodeGraphicsObject().moveConnections();
 }
 
+void NodeGraphDataModel::setupNodeSignals(Node& n)
+{
+    connect(n.nodeDataModel(), &NodeDataModel::dataUpdated,
+            this, [this, &n]([[maybe_unused]] PortIndex index)
+            {
+                emit nodeDataUpdated(n);
+            });
+
+    for (auto& prop : n.nodeDataModel()->getPropertyModels())
+    {
+        connect(prop, &PropertyModel::editingStarted,
+                this, [this, &n]() { emit nodeEditingStarted(n); });
+        connect(prop, &PropertyModel::editingFinished,
+                this, [this, &n]() { emit nodeEditingFinished(n); });
+    }
+}
+
 void NodeGraphDataModel::setupConnectionSignals(Connection const& c)
 {
     connect(&c, &Connection::connectionMadeIncomplete,
@@ -83,6 +83,14 @@ public:
 
     std::vector<Node*> allNodes() const;
 
+    // The node and everything it depends on, inputs before the nodes using them
+    std::vector<Node*> getUpstreamNodes(Node& node) const;
+
+    // Prepares the render tasks of all dirty nodes the given node depends on,
+    // and of the node itself. Returns those nodes, inputs before the nodes using them.
+    // Executing the tasks is up to the caller.
+    std::vector<Node*> evaluate(Node& node);
+
 private:
     std::unique_ptr<DataModelRegistry> registerDataModels()
     {
@@ -109,7 +117,16 @@ signals:
 
     void nodeDeleted(Cascade::NodeGraph::Node &n);
 
+    void nodeDataUpdated(Cascade::NodeGraph::Node &n);
+
+    // A property of the node is being dragged
+    void nodeEditingStarted(Cascade::NodeGraph::Node &n);
+
+    void nodeEditingFinished(Cascade::NodeGraph::Node &n);
+
 private slots:
+    void setupNodeSignals(Cascade::NodeGraph::Node& n);
+
     void setupConnectionSignals(Cascade::NodeGraph::Connection const& c);
 
     void sendConnectionCreatedToNodes(Cascade::NodeGraph::Connection const& c);
@@ -30,6 +30,7 @@
 
 #include <QtCore/QPointF>
 #include <QtCore/QRectF>
+#include <QtCore/QTimer>
 
 #include <QtWidgets>
 
@@ -84,6 +85,13 @@ NodeGraphView::NodeGraphView(QWidget* parent)
     connect(mScene, &NodeGraphScene::nodeDoubleClicked, this, &NodeGraphView::setActiveNode);
 }
 
+NodeGraphView::~NodeGraphView()
+{
+    // Tearing down the model emits signals we don't want to handle anymore
+    if (mModel)
+        disconnect(mModel.get(), nullptr, this, nullptr);
+}
+
 QAction* NodeGraphView::clearSelectionAction() const
 {
     return mClearSelectionAction;
@@ -121,6 +129,23 @@ NodeGraphDataModel* NodeGraphView::getModel() const
 void NodeGraphView::setModel(std::unique_ptr<NodeGraphDataModel> model)
 {
     mModel = std::move(model);
+
+    connect(mModel.get(), &NodeGraphDataModel::nodeDeleted,
+            this, &NodeGraphView::handleNodeDeleted);
+
+    // Any change in the graph can affect the viewed node. Nodes that
+    // are still up to date are skipped when evaluating, so this is cheap.
+    connect(mModel.get(), &NodeGraphDataModel::nodeDataUpdated,
+            this, &NodeGraphView::requestDisplay);
+    connect(mModel.get(), &NodeGraphDataModel::connectionCreated,
+            this, &NodeGraphView::requestDisplay);
+    connect(mModel.get(), &NodeGraphDataModel::connectionDeleted,
+            this, &NodeGraphView::requestDisplay);
+
+    connect(mModel.get(), &NodeGraphDataModel::nodeEditingStarted,
+            this, &NodeGraphView::editingStarted);
+    connect(mModel.get(), &NodeGraphDataModel::nodeEditingFinished,
+            this, &NodeGraphView::handleEditingFinished);
 }
 
 void NodeGraphView::contextMenuEvent(QContextMenuEvent* event)
@@ -214,6 +239,47 @@ void NodeGraphView::setViewedNode(Node* node)
     mViewedNode = node;
 
     node->view(mViewerMode);
+
+    emit nodeDisplayRequested(mViewedNode);
+}
+
+void NodeGraphView::handleNodeDeleted(Node& node)
+{
+    if (mActiveNode == &node)
+        setActiveNode(nullptr);
+
+    if (mViewedNode == &node)
+    {
+        mViewedNode = nullptr;
+
+        emit nodeDisplayRequested(nullptr);
+    }
+}
+
+void NodeGraphView::requestDisplay()
+{
+    if (!mViewedNode || mDisplayPending)
+        return;
+
+    // A single edit can update many nodes at once,
+    // only display the result when all of them are done
+    mDisplayPending = true;
+
+    QTimer::singleShot(0, this, [this]()
+    {
+        mDisplayPending = false;
+
+        if (mViewedNode)
+            emit nodeDisplayRequested(mViewedNode);
+    });
+}
+
+void NodeGraphView::handleEditingFinished()
+{
+    emit editingFinished();
+
+    // What is shown might have been a preview
+    requestDisplay();
 }
 
 void NodeGraphView::handleFrontViewRequested()
@@ -43,6 +43,8 @@ class NodeGraphView : public QGraphicsView
 public:
     NodeGraphView(QWidget* parent = Q_NULLPTR);
 
+    ~NodeGraphView();
+
     NodeGraphView(const NodeGraphView&) = delete;
     NodeGraphView operator=(const NodeGraphView&) = delete;
 
@@ -58,6 +60,13 @@ public:
 signals:
     void activeNodeChanged(Cascade::NodeGraph::Node* node);
 
+    // The viewed node or its inputs changed and it has to be shown again
+    void nodeDisplayRequested(Cascade::NodeGraph::Node* node);
+
+    // A property is being dragged, the displays in between can be previews
+    void editingStarted();
+    void editingFinished();
+
 public slots:
     void scaleUp();
 
@@ -77,6 +86,9 @@ public slots:
 
     void handleResultViewRequested();
 
+    // Displays the viewed node again once the current event is handled
+    void requestDisplay();
+
 protected:
     void contextMenuEvent(QContextMenuEvent* event) override;
 
@@ -99,6 +111,11 @@ protected:
 protected:
     NodeGraphScene* scene();
 
+private slots:
+    void handleNodeDeleted(Cascade::NodeGraph::Node& node);
+
+    void handleEditingFinished();
+
 private:
     std::unique_ptr<NodeGraphDataModel> mModel;
 
@@ -114,6 +131,8 @@ private:
 
     Node* mActiveNode = nullptr;
     Node* mViewedNode = nullptr;
+
+    bool mDisplayPending = false;
 };
 
 } // namespace Cascade::NodeGraph
@@ -75,6 +75,13 @@ void PreferencesManager::loadPreferences()
     QJsonObject jsonProject = prefsDocument.object();
     QJsonArray jsonPrefs = jsonProject.value("prefs").toArray();
     QJsonObject jsonGeneralHeading = jsonPrefs.at(0).toObject();
+    QJsonArray generalSettings = jsonGeneralHeading.value("general").toArray();
+
+    foreach (auto value, generalSettings)
+    {
+        auto obj = value.toObject();
+        mGeneral[obj["setting"].toString()] = obj["value"].toString();
+    }
 
     QJsonObject jsonKeysHeading = jsonPrefs.at(1).toObject();
     QJsonArray jsonKeysArray = jsonKeysHeading.value("keys").toArray();
@@ -112,4 +119,15 @@ const std::vector<KeysCategory>& PreferencesManager::getKeys()
     return mKeyCategories;
 }
 
+QString PreferencesManager::getGeneralPreference(
+        const QString& setting,
+        const QString& defaultValue) const
+{
+    auto it = mGeneral.find(setting);
+    if (it == mGeneral.end())
+        return defaultValue;
+
+    return it->second;
+}
+
 } // namespace Cascade
@@ -20,6 +20,8 @@
 #ifndef PREFERENCESMANAGER_H
 #define PREFERENCESMANAGER_H
 
+#include <map>
+
 #include <QObject>
 #include <QJsonArray>
 
@@ -45,6 +47,11 @@ public:
 
     const std::vector<KeysCategory>& getKeys();
 
+    // Returns defaultValue if the setting is not in the preferences file
+    QString getGeneralPreference(
+            const QString& setting,
+            const QString& defaultValue = "") const;
+
 private:
     PreferencesManager() {}
 
@@ -54,6 +61,7 @@ private:
             const QJsonArray& arr);
 
     std::vector<KeysCategory> mKeyCategories;
+    std::map<QString, QString> mGeneral;
 };
 
 } // namespace Cascade
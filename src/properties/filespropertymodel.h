@@ -53,11 +53,14 @@ public:
     void addEntries(const QStringList& entries)
     {
         mData->append(entries);
+
+        emit valueChanged();
     }
 
     void removeEntry(const int index)
     {
-        mData->getFiles()->removeRows(index, 1);
+        if (mData->getFiles()->removeRows(index, 1))
+            emit valueChanged();
     }
 
     int numEntries()
@@ -52,7 +52,12 @@ public:
 
     void setValue(const int value)
     {
+        if (value == mData->getValue())
+            return;
+
         mData->setValue(value);
+
+        emit valueChanged();
     }
 
 private:
@@ -50,6 +50,16 @@ void IntPropertyView::setModel(IntPropertyModel* model)
         mModel->getData()->getMax(),
         mModel->getData()->getStep(),
         mModel->getData()->getValue());
+
+    connect(mSlider, &Slider::valueChanged,
+            this, [this]()
+            {
+                mModel->setValue(static_cast<int>(mSlider->getValue()));
+            });
+    connect(mSlider, &Slider::dragStarted,
+            mModel, &PropertyModel::editingStarted);
+    connect(mSlider, &Slider::dragFinished,
+            mModel, &PropertyModel::editingFinished);
 }
 
 } // namespace Cascade::Properties
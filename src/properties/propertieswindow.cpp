@@ -55,6 +55,12 @@ void PropertiesWindow::clear()
 
 void PropertiesWindow::handleActiveNodeChanged(Node* node)
 {
+    if (!node)
+    {
+        clear();
+        return;
+    }
+
     setPropertyWidget(node->propertyWidget());
 }
 
@@ -20,6 +20,7 @@
 #ifndef PROPERTYDATA_H
 #define PROPERTYDATA_H
 
+#include <QByteArray>
 #include <QString>
 #include <QStringListModel>
 
@@ -27,7 +28,17 @@ namespace Cascade::Properties
 {
 
 class PropertyData
-{};
+{
+public:
+    virtual ~PropertyData() = default;
+
+    // The value as bytes, used to identify render results.
+    // Data that doesn't change the image returns nothing.
+    virtual QByteArray serialize() const
+    {
+        return QByteArray();
+    }
+};
 
 class TitlePropertyData : public PropertyData
 {
@@ -91,6 +102,11 @@ public:
         mValue = value;
     }
 
+    QByteArray serialize() const override
+    {
+        return QByteArray::number(mValue);
+    }
+
 private:
     QString mName;
     int mMin;
@@ -112,6 +128,11 @@ public:
         return mFiles;
     }
 
+    QByteArray serialize() const override
+    {
+        return mFiles->stringList().join('\n').toUtf8();
+    }
+
     void append(const QStringList& files)
     {
         for (auto& file : files)
@@ -37,6 +37,15 @@ class PropertyModel : public QObject
 public:
     virtual PropertyData* getData() = 0;
     virtual PropertyView* getView() = 0;
+
+signals:
+    // Emitted whenever the value held by the PropertyData changes
+    void valueChanged();
+
+    // The value is being dragged, the changes in between
+    // only need a preview until editingFinished()
+    void editingStarted();
+    void editingFinished();
 };
 
 } // namespace Cascade::Properties
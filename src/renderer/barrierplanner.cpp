@@ -0,0 +1,120 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "barrierplanner.h"
+
+namespace Cascade::Renderer {
+
+int BarrierPlanner::addImage(const ImageAccess initial)
+{
+    mAccess.push_back(initial);
+
+    return static_cast<int>(mAccess.size()) - 1;
+}
+
+std::vector<ImageTransition> BarrierPlanner::addPass(
+    const std::vector<std::pair<int, ImageAccess>>& accesses)
+{
+    // Merge multiple uses of the same image first
+    std::vector<std::pair<int, ImageAccess>> merged;
+    for (auto& [image, access] : accesses)
+    {
+        bool found = false;
+        for (auto& m : merged)
+        {
+            if (m.first == image)
+            {
+                if (isWrite(access))
+                    m.second = access;
+                found = true;
+            }
+        }
+        if (!found)
+            merged.push_back({ image, access });
+    }
+
+    std::vector<ImageTransition> transitions;
+    for (auto& [image, access] : merged)
+    {
+        if (needsTransition(mAccess.at(image), access))
+            transitions.push_back({ image, mAccess.at(image), access });
+
+        mAccess.at(image) = access;
+    }
+
+    return transitions;
+}
+
+std::vector<ImageTransition> BarrierPlanner::finish(const ImageAccess final)
+{
+    std::vector<ImageTransition> transitions;
+    for (int i = 0; i < getNumImages(); ++i)
+    {
+        // Images no pass has used yet are left alone
+        if (mAccess.at(i) != final && mAccess.at(i) != ImageAccess::eUndefined)
+        {
+            transitions.push_back({ i, mAccess.at(i), final });
+            mAccess.at(i) = final;
+        }
+    }
+
+    return transitions;
+}
+
+ImageAccess BarrierPlanner::getAccess(const int image) const
+{
+    return mAccess.at(image);
+}
+
+int BarrierPlanner::getNumImages() const
+{
+    return static_cast<int>(mAccess.size());
+}
+
+void BarrierPlanner::reset()
+{
+    mAccess.clear();
+}
+
+bool BarrierPlanner::isWrite(const ImageAccess access)
+{
+    return access == ImageAccess::eTransferWrite || access == ImageAccess::eShaderWrite;
+}
+
+bool BarrierPlanner::hasSameLayout(const ImageAccess a, const ImageAccess b)
+{
+    auto isShader = [](ImageAccess access)
+    { return access == ImageAccess::eShaderRead || access == ImageAccess::eShaderWrite; };
+
+    return a == b || (isShader(a) && isShader(b));
+}
+
+bool BarrierPlanner::needsTransition(const ImageAccess from, const ImageAccess to)
+{
+    if (from == ImageAccess::eUndefined)
+        return true;
+
+    if (!hasSameLayout(from, to))
+        return true;
+
+    // Read after write, write after write and write after read
+    return isWrite(from) || isWrite(to);
+}
+
+} // end namespace Cascade::Renderer
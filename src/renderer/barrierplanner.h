@@ -0,0 +1,83 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BARRIERPLANNER_H
+#define BARRIERPLANNER_H
+
+#include <utility>
+#include <vector>
+
+namespace Cascade::Renderer {
+
+// How a pass uses an image
+enum class ImageAccess
+{
+    eUndefined, // Nothing known, the content may be discarded
+    eTransferRead,
+    eTransferWrite,
+    eShaderRead,
+    eShaderWrite,
+    eSampled // Read by the viewer, the state results are kept in
+};
+
+struct ImageTransition
+{
+    int image;
+    ImageAccess from;
+    ImageAccess to;
+};
+
+// Works out which barriers a sequence of passes needs from what
+// each pass reads and writes. A barrier is only planned for a layout
+// change or when a write is involved, reads after reads need none.
+class BarrierPlanner
+{
+public:
+    // Returns the id the passes refer to the image with
+    int addImage(const ImageAccess initial);
+
+    // Returns the transitions that have to happen before the pass.
+    // An image that is used twice by a pass counts as written if
+    // either use writes it.
+    std::vector<ImageTransition> addPass(
+        const std::vector<std::pair<int, ImageAccess>>& accesses);
+
+    // Returns the transitions that leave all used images in the given state
+    std::vector<ImageTransition> finish(const ImageAccess final);
+
+    ImageAccess getAccess(const int image) const;
+
+    int getNumImages() const;
+
+    void reset();
+
+    static bool isWrite(const ImageAccess access);
+
+    // Shader reads and writes share the general layout
+    static bool hasSameLayout(const ImageAccess a, const ImageAccess b);
+
+    static bool needsTransition(const ImageAccess from, const ImageAccess to);
+
+private:
+    std::vector<ImageAccess> mAccess;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // BARRIERPLANNER_H
@@ -0,0 +1,176 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "colorlut.h"
+
+#include <QCryptographicHash>
+
+namespace Cascade::Renderer
+{
+
+// Maps between linear values and the coordinates of the LUT, and looks up
+// a color with tetrahedral interpolation between the eight texels around it
+static QString generateLutCode(const int lutSize)
+{
+    return
+        "const int lutSize = " + QString::number(lutSize) + ";\n"
+        "const float lutMinStop = -8.0;\n"
+        "const float lutMaxStop = 8.0;\n"
+        "\n"
+        "vec3 toLut(vec3 color)\n"
+        "{\n"
+        "    vec3 stops = log2(max(color, vec3(0.0)) + exp2(lutMinStop));\n"
+        "    return clamp((stops - lutMinStop) / (lutMaxStop - lutMinStop), 0.0, 1.0);\n"
+        "}\n"
+        "\n"
+        "vec3 fromLut(vec3 coords)\n"
+        "{\n"
+        "    return exp2(coords * (lutMaxStop - lutMinStop) + lutMinStop) - exp2(lutMinStop);\n"
+        "}\n"
+        "\n"
+        "vec3 lutTexel(ivec3 index)\n"
+        "{\n"
+        "    return imageLoad(inputFront, ivec2(index.r + index.g * lutSize, index.b)).rgb;\n"
+        "}\n"
+        "\n"
+        "vec3 applyLut(vec3 color)\n"
+        "{\n"
+        "    vec3 position = toLut(color) * float(lutSize - 1);\n"
+        "    ivec3 base    = min(ivec3(position), ivec3(lutSize - 2));\n"
+        "    vec3 f        = position - vec3(base);\n"
+        "\n"
+        "    // The corners of the tetrahedron the color is in, along\n"
+        "    // the axes from the biggest fraction to the smallest\n"
+        "    ivec3 first;\n"
+        "    ivec3 second;\n"
+        "    vec3 w;\n"
+        "    if (f.r >= f.g)\n"
+        "    {\n"
+        "        if (f.g >= f.b)\n"
+        "        { first = ivec3(1, 0, 0); second = ivec3(1, 1, 0); w = f.rgb; }\n"
+        "        else if (f.r >= f.b)\n"
+        "        { first = ivec3(1, 0, 0); second = ivec3(1, 0, 1); w = f.rbg; }\n"
+        "        else\n"
+        "        { first = ivec3(0, 0, 1); second = ivec3(1, 0, 1); w = f.brg; }\n"
+        "    }\n"
+        "    else\n"
+        "    {\n"
+        "        if (f.b >= f.g)\n"
+        "        { first = ivec3(0, 0, 1); second = ivec3(0, 1, 1); w = f.bgr; }\n"
+        "        else if (f.b >= f.r)\n"
+        "        { first = ivec3(0, 1, 0); second = ivec3(0, 1, 1); w = f.gbr; }\n"
+        "        else\n"
+        "        { first = ivec3(0, 1, 0); second = ivec3(1, 1, 0); w = f.grb; }\n"
+        "    }\n"
+        "\n"
+        "    return (1.0 - w.x) * lutTexel(base) +\n"
+        "           (w.x - w.y) * lutTexel(base + first) +\n"
+        "           (w.y - w.z) * lutTexel(base + second) +\n"
+        "           w.z * lutTexel(base + ivec3(1));\n"
+        "}\n"
+        "\n";
+}
+
+bool isColorChain(const PointwiseChain& chain)
+{
+    for (auto& task : chain)
+    {
+        if (!task->isColorTransform())
+            return false;
+    }
+    return !chain.empty();
+}
+
+QByteArray getColorLutKey(const PointwiseChain& chain, const int lutSize)
+{
+    const std::vector<float> settings = getFusedSettings(chain);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData("lut:" + QByteArray::number(lutSize));
+    hash.addData(getFusedSignature(chain));
+    hash.addData(
+        reinterpret_cast<const char*>(settings.data()),
+        static_cast<int>(settings.size() * sizeof(float)));
+
+    return hash.result();
+}
+
+QString generateLutBakeShader(const PointwiseChain& chain, const int lutSize)
+{
+    return generateShaderHeader() + generateChainCode(chain) + generateLutCode(lutSize) +
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "    if (pixelCoords.x >= lutSize * lutSize || pixelCoords.y >= lutSize)\n"
+        "        return;\n"
+        "\n"
+        "    ivec3 index = ivec3(pixelCoords.x % lutSize, pixelCoords.x / lutSize, pixelCoords.y);\n"
+        "    vec3 color  = fromLut(vec3(index) / float(lutSize - 1));\n"
+        "\n"
+        "    imageStore(outputImage, pixelCoords, vec4(applyChain(vec4(color, 1.0)).rgb, 1.0));\n"
+        "}\n";
+}
+
+QString generateLutApplyShader(const int lutSize)
+{
+    return generateShaderHeader() + generateLutCode(lutSize) +
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    vec4 pixel = imageLoad(inputBack, pixelCoords);\n"
+        "\n"
+        "    imageStore(outputImage, pixelCoords, vec4(applyLut(pixel.rgb), pixel.a));\n"
+        "}\n";
+}
+
+QString generateLutErrorShader(const PointwiseChain& chain, const int lutSize)
+{
+    const int probesPerAxis = 16;
+    static_assert(
+        probesPerAxis * probesPerAxis * probesPerAxis == lutErrorImageSize * lutErrorImageSize);
+
+    return generateShaderHeader() + generateChainCode(chain) + generateLutCode(lutSize) +
+        "const int probesPerAxis = " + QString::number(probesPerAxis) + ";\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "    if (pixelCoords.x >= " + QString::number(lutErrorImageSize) +
+        " || pixelCoords.y >= " + QString::number(lutErrorImageSize) + ")\n"
+        "        return;\n"
+        "\n"
+        "    int i          = pixelCoords.x + pixelCoords.y * " +
+        QString::number(lutErrorImageSize) + ";\n"
+        "    ivec3 probe    = ivec3(i % probesPerAxis, (i / probesPerAxis) % probesPerAxis,\n"
+        "                           i / (probesPerAxis * probesPerAxis));\n"
+        "\n"
+        "    // Half way between two texels is where the LUT is least exact\n"
+        "    vec3 cell   = (vec3(probe) + 0.5) * float(lutSize - 1) / float(probesPerAxis);\n"
+        "    vec3 coords = (floor(cell) + 0.5) / float(lutSize - 1);\n"
+        "    vec3 color  = fromLut(coords);\n"
+        "\n"
+        "    vec3 exact  = applyChain(vec4(color, 1.0)).rgb;\n"
+        "    vec3 error  = abs(applyLut(color) - exact) / max(abs(exact), vec3(1.0));\n"
+        "\n"
+        "    imageStore(outputImage, pixelCoords, vec4(error, 1.0));\n"
+        "}\n";
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,59 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef COLORLUT_H
+#define COLORLUT_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "pointwisefusion.h"
+
+namespace Cascade::Renderer
+{
+
+// A chain of color transforms is sampled into a 3D LUT on the device and
+// applied to the image with one tetrahedral lookup per pixel.
+// The LUT covers the values from 2^-8 to 2^8 on a log2 scale, negative
+// values are clamped to 0. It is stored as a 2D image of size*size by size
+// texels, red goes along x within a slice, green picks the slice, blue is y.
+
+// Whether all tasks of the chain are color transforms
+bool isColorChain(const PointwiseChain& chain);
+
+// Identifies the LUT of a chain with its settings
+QByteArray getColorLutKey(const PointwiseChain& chain, const int lutSize);
+
+// Writes the LUT of the chain to the output image
+QString generateLutBakeShader(const PointwiseChain& chain, const int lutSize);
+
+// Applies the LUT on the front input to the back input
+QString generateLutApplyShader(const int lutSize);
+
+// Compares the LUT on the front input to the chain at the points furthest
+// from the texels. Writes the difference of one point per pixel, relative
+// to the exact value where that is above 1, to an image of
+// lutErrorImageSize by lutErrorImageSize pixels.
+QString generateLutErrorShader(const PointwiseChain& chain, const int lutSize);
+
+inline constexpr int lutErrorImageSize = 64;
+
+} // namespace Cascade::Renderer
+
+#endif // COLORLUT_H
@@ -0,0 +1,78 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "colorprocessorcache.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer {
+
+OCIO::ConstCPUProcessorRcPtr ColorProcessorCache::get(
+        const OCIO::ConstConfigRcPtr& config,
+        const QString& from,
+        const QString& to,
+        const OCIO::OptimizationFlags optimization)
+{
+    if (!config)
+        return nullptr;
+
+    // A reloaded config gets processors of its own
+    const QByteArray key =
+            QByteArray(config->getCacheID()) + '\n' +
+            from.toUtf8() + '\n' +
+            to.toUtf8() + '\n' +
+            QByteArray::number(static_cast<qulonglong>(optimization));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mProcessors.find(key);
+    if (it != mProcessors.end())
+        return it->second;
+
+    try
+    {
+        OCIO::ConstProcessorRcPtr processor =
+                config->getProcessor(from.toLocal8Bit(), to.toLocal8Bit());
+
+        return mProcessors[key] = processor->getOptimizedCPUProcessor(optimization);
+    }
+    catch (OCIO::Exception& exception)
+    {
+        CS_LOG_WARNING("OpenColorIO Error: " + QString(exception.what()));
+    }
+
+    // Not tried again for every image
+    return mProcessors[key] = nullptr;
+}
+
+int ColorProcessorCache::getSize() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return static_cast<int>(mProcessors.size());
+}
+
+void ColorProcessorCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mProcessors.clear();
+}
+
+} // end namespace Cascade::Renderer
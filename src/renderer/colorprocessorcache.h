@@ -0,0 +1,62 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef COLORPROCESSORCACHE_H
+#define COLORPROCESSORCACHE_H
+
+#include <map>
+#include <mutex>
+
+#include <QByteArray>
+#include <QString>
+
+#include <OpenColorIO/OpenColorIO.h>
+
+namespace OCIO = OCIO_NAMESPACE;
+
+namespace Cascade::Renderer {
+
+// The CPU processors of the color space conversions, built once for each
+// config, pair of color spaces and optimization level. Building one parses
+// the transforms and LUT files of the config, which took longer than
+// converting a small image.
+class ColorProcessorCache
+{
+public:
+    // nullptr if there is no config or it can't convert
+    // between the color spaces, the reason is logged
+    OCIO::ConstCPUProcessorRcPtr get(
+            const OCIO::ConstConfigRcPtr& config,
+            const QString& from,
+            const QString& to,
+            const OCIO::OptimizationFlags optimization);
+
+    int getSize() const;
+
+    void clear();
+
+private:
+    std::map<QByteArray, OCIO::ConstCPUProcessorRcPtr> mProcessors;
+
+    mutable std::mutex mMutex;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // COLORPROCESSORCACHE_H
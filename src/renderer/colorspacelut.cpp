@@ -0,0 +1,190 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "colorspacelut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pointwisefusion.h"
+
+namespace Cascade::Renderer
+{
+
+// Value of the texel at the position, like the shader maps it back
+static float getDomainValue(const ColorSpaceLutDomain& domain, const float position)
+{
+    const float x = domain.min + position * (domain.max - domain.min);
+
+    return domain.isLog ? std::exp2(x) : x;
+}
+
+static float lookUp(
+    const std::vector<float>& lut,
+    const ColorSpaceLutDomain& domain,
+    const float value,
+    const int channel)
+{
+    const int lutSize = static_cast<int>(lut.size() / 4);
+
+    const float x = domain.isLog ? std::log2(std::max(value, std::exp2(domain.min))) : value;
+    const float position =
+        std::clamp((x - domain.min) / (domain.max - domain.min), 0.0f, 1.0f) * (lutSize - 1);
+
+    const int index = std::min(static_cast<int>(position), lutSize - 2);
+    const float f   = position - index;
+
+    return lut[index * 4 + channel] * (1.0f - f) + lut[(index + 1) * 4 + channel] * f;
+}
+
+std::vector<float> bakeColorSpaceLut(
+    const ColorTransform& transform,
+    const ColorSpaceLutDomain& domain,
+    const int lutSize)
+{
+    std::vector<float> lut(static_cast<size_t>(lutSize) * 4);
+    for (int i = 0; i < lutSize; ++i)
+    {
+        const float value = getDomainValue(domain, static_cast<float>(i) / (lutSize - 1));
+
+        std::fill(lut.begin() + i * 4, lut.begin() + i * 4 + 3, value);
+        lut[i * 4 + 3] = 1.0f;
+    }
+    transform(lut.data(), lutSize);
+
+    return lut;
+}
+
+float getColorSpaceLutError(
+    const std::vector<float>& lut,
+    const ColorTransform& transform,
+    const ColorSpaceLutDomain& domain)
+{
+    const int lutSize   = static_cast<int>(lut.size() / 4);
+    const int numPoints = lutSize - 1;
+
+    // The LUT clamps these, images can still have them
+    std::vector<float> outside;
+    if (domain.isLog)
+    {
+        outside = { -1.0f, 0.0f, std::exp2(domain.max + 1.0f), std::exp2(domain.max + 4.0f) };
+    }
+    else
+    {
+        const float range = domain.max - domain.min;
+        outside = {
+            domain.min - range, domain.min - range * 0.25f,
+            domain.max + range * 0.25f, domain.max + range };
+    }
+    const int numProbes = numPoints + static_cast<int>(outside.size());
+
+    // Each channel goes through all the points between the
+    // texels, green and blue a third and two thirds ahead
+    std::vector<float> pixels(static_cast<size_t>(numProbes) * 4);
+    for (int i = 0; i < numPoints; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const int point   = (i + c * numPoints / 3) % numPoints;
+            pixels[i * 4 + c] = getDomainValue(domain, (point + 0.5f) / numPoints);
+        }
+        pixels[i * 4 + 3] = 1.0f;
+    }
+    for (size_t j = 0; j < outside.size(); ++j)
+    {
+        float* pixel = &pixels[(numPoints + j) * 4];
+        std::fill(pixel, pixel + 3, outside[j]);
+        pixel[3] = 1.0f;
+    }
+
+    std::vector<float> exact = pixels;
+    transform(exact.data(), numProbes);
+
+    float error = 0.0f;
+    for (int i = 0; i < numProbes; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const float expected = exact[i * 4 + c];
+
+            float difference = std::abs(lookUp(lut, domain, pixels[i * 4 + c], c) - expected);
+            if (std::abs(expected) > 1.0f)
+                difference /= std::abs(expected);
+
+            // NaN counts as too far off
+            if (std::isnan(difference))
+                return std::numeric_limits<float>::infinity();
+
+            error = std::max(error, difference);
+        }
+    }
+    return error;
+}
+
+QString generateColorSpaceLutCode(const ColorSpaceLutDomain& domain, const int lutSize)
+{
+    const QString position = domain.isLog ? "log2(max(value, exp2(colorSpaceLutMin)))" : "value";
+
+    return
+        "const int colorSpaceLutSize = " + QString::number(lutSize) + ";\n"
+        "const float colorSpaceLutMin = " + QString::number(domain.min, 'g', 9) + ";\n"
+        "const float colorSpaceLutMax = " + QString::number(domain.max, 'g', 9) + ";\n"
+        "\n"
+        "float colorSpaceLutLookup(float value, int channel)\n"
+        "{\n"
+        "    float x        = " + position + ";\n"
+        "    float position = clamp((x - colorSpaceLutMin) / (colorSpaceLutMax - colorSpaceLutMin),\n"
+        "                           0.0, 1.0) * float(colorSpaceLutSize - 1);\n"
+        "    int index      = min(int(position), colorSpaceLutSize - 2);\n"
+        "\n"
+        "    return mix(imageLoad(inputFront, ivec2(index, 0))[channel],\n"
+        "               imageLoad(inputFront, ivec2(index + 1, 0))[channel],\n"
+        "               position - float(index));\n"
+        "}\n"
+        "\n"
+        "vec3 convertColorSpace(vec3 color)\n"
+        "{\n"
+        "    return vec3(colorSpaceLutLookup(color.r, 0),\n"
+        "                colorSpaceLutLookup(color.g, 1),\n"
+        "                colorSpaceLutLookup(color.b, 2));\n"
+        "}\n"
+        "\n";
+}
+
+QString generateColorSpaceLutShader(const ColorSpaceLutDomain& domain, const int lutSize)
+{
+    return generateShaderHeader() + generateColorSpaceLutCode(domain, lutSize) +
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    vec4 pixel = imageLoad(inputBack, pixelCoords);\n"
+        "\n"
+        "    imageStore(outputImage, pixelCoords, vec4(convertColorSpace(pixel.rgb), pixel.a));\n"
+        "}\n";
+}
+
+QByteArray getColorSpaceLutSignature(const ColorSpaceLutDomain& domain, const int lutSize)
+{
+    return QByteArray(domain.isLog ? "lg2:" : "uniform:") + QByteArray::number(domain.min, 'g', 9) +
+           ":" + QByteArray::number(domain.max, 'g', 9) + ":" + QByteArray::number(lutSize);
+}
+
+} // namespace Cascade::Renderer
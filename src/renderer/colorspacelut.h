@@ -0,0 +1,81 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef COLORSPACELUT_H
+#define COLORSPACELUT_H
+
+#include <functional>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+// A color space conversion sampled once per channel, for the transforms
+// where every output channel only depends on the same input channel, like
+// the 1D LUTs and exponents the color spaces are mostly defined with.
+// The samples are spread over the range of the source color space, evenly
+// or on a log2 scale, values outside of it are clamped.
+// The LUT is stored as an image of lutSize by 1 RGBA texels, alpha is unused.
+struct ColorSpaceLutDomain
+{
+    bool isLog = false;
+    // In stops for a log2 domain
+    float min  = 0.0f;
+    float max  = 1.0f;
+};
+
+// Converts numPixels tightly packed RGBA pixels in place
+using ColorTransform = std::function<void(float* pixels, const int numPixels)>;
+
+std::vector<float> bakeColorSpaceLut(
+    const ColorTransform& transform,
+    const ColorSpaceLutDomain& domain,
+    const int lutSize);
+
+// Largest difference between the LUT and the transform halfway between
+// the texels, for colors whose channels are at different positions so that
+// transforms mixing the channels stand out. Values outside of the domain
+// are probed as well, a transform that goes on past its ends is too far
+// off there. Relative to the exact value where that is above 1.
+float getColorSpaceLutError(
+    const std::vector<float>& lut,
+    const ColorTransform& transform,
+    const ColorSpaceLutDomain& domain);
+
+// Defines vec3 convertColorSpace(vec3 color), which
+// looks the color up in the LUT bound as inputFront
+QString generateColorSpaceLutCode(const ColorSpaceLutDomain& domain, const int lutSize);
+
+// Applies the LUT on the front input to the back input
+QString generateColorSpaceLutShader(const ColorSpaceLutDomain& domain, const int lutSize);
+
+// Identifies the generated shaders of a domain
+QByteArray getColorSpaceLutSignature(const ColorSpaceLutDomain& domain, const int lutSize);
+
+inline constexpr int colorSpaceLutSize = 4096;
+
+// Conversions whose LUT is further off than this stay on the CPU
+inline constexpr float colorSpaceLutTolerance = 1e-4f;
+
+} // namespace Cascade::Renderer
+
+#endif // COLORSPACELUT_H
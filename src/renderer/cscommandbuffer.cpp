@@ -21,16 +21,19 @@
 
 #include "../log.h"
 #include "renderconfig.h"
+#include "renderutility.h"
 
 namespace Cascade::Renderer {
 
 CsCommandBuffer::CsCommandBuffer(
         const vk::Device* d,
         const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
         vk::PipelineLayout* pipelineLayout,
         vk::DescriptorSet* descriptorSet) :
     device(d),
     physicalDevice(pd),
+    mAllocator(allocator),
     mComputePipelineLayout(pipelineLayout),
     mComputeDescriptorSet(descriptorSet)
 {
@@ -70,18 +73,16 @@ void CsCommandBuffer::createComputeCommandPool()
 
 void CsCommandBuffer::createComputeCommandBuffers()
 {
-    // Create the command buffer for loading an image from disk
     vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
                 *mComputeCommandPool,
                 vk::CommandBufferLevel::ePrimary,
-                3);
+                2);
 
     std::vector<vk::UniqueCommandBuffer> buffers = device->allocateCommandBuffersUnique(
                 commandBufferAllocateInfo).value;
 
-    mCommandBufferImageLoad = vk::UniqueCommandBuffer(std::move(buffers.at(0)));
-    mCommandBufferGeneric = vk::UniqueCommandBuffer(std::move(buffers.at(1)));
-    mCommandBufferImageSave = vk::UniqueCommandBuffer(std::move(buffers.at(2)));
+    mCommandBufferGeneric = vk::UniqueCommandBuffer(std::move(buffers.at(0)));
+    mCommandBufferImageSave = vk::UniqueCommandBuffer(std::move(buffers.at(1)));
 
     // Fence for compute CB sync
     vk::FenceCreateInfo fenceCreateInfo(
@@ -96,7 +97,8 @@ void CsCommandBuffer::recordGeneric(
         CsImage *const outputImage,
         vk::Pipeline &pl,
         int numShaderPasses,
-        int currentShaderPass)
+        int currentShaderPass,
+        const QRegion& region)
 {
     auto result = mComputeQueue.waitIdle();
 
@@ -128,11 +130,8 @@ void CsCommandBuffer::recordGeneric(
                 *mComputePipelineLayout,
                 0,
                 *mComputeDescriptorSet,
-                {});
-    mCommandBufferGeneric->dispatch(
-                outputImage->getWidth() / 16 + 1,
-                outputImage->getHeight() / 16 + 1,
-                1);
+                uint32_t(0));
+    dispatchRegion(*mCommandBufferGeneric, region);
 
     // Layout transitions after compute stage
     inputImageBack->transitionLayoutTo(
@@ -158,73 +157,7 @@ void CsCommandBuffer::recordGeneric(
     Q_UNUSED(result);
 }
 
-void CsCommandBuffer::recordImageLoad(
-        CsImage* const loadImage,
-        CsImage* const tmpImage,
-        CsImage* const renderTarget,
-        vk::Pipeline* const readNodePipeline)
-{
-     [[maybe_unused]] auto result = mComputeQueue.waitIdle();
-
-    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
-
-    result = mCommandBufferImageLoad->begin(cmdBufferBeginInfo);
-
-    loadImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eTransferSrcOptimal);
-
-    tmpImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eTransferDstOptimal);
-
-    vk::ImageCopy copyInfo;
-    copyInfo.srcSubresource.aspectMask  = vk::ImageAspectFlagBits::eColor;
-    copyInfo.srcSubresource.layerCount  = 1;
-    copyInfo.dstSubresource.aspectMask  = vk::ImageAspectFlagBits::eColor;
-    copyInfo.dstSubresource.layerCount  = 1;
-    copyInfo.extent.width               = loadImage->getWidth();
-    copyInfo.extent.height              = loadImage->getHeight();
-    copyInfo.extent.depth               = 1;
-
-    mCommandBufferImageLoad->copyImage(
-                *loadImage->getImage(),
-                vk::ImageLayout::eTransferSrcOptimal,
-                *tmpImage->getImage(),
-                vk::ImageLayout::eTransferDstOptimal,
-                1,
-                &copyInfo);
-
-    tmpImage->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eGeneral);
-
-    renderTarget->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eGeneral);
-
-    mCommandBufferImageLoad->bindPipeline(
-                vk::PipelineBindPoint::eCompute,
-                *readNodePipeline);
-    mCommandBufferImageLoad->bindDescriptorSets(
-                vk::PipelineBindPoint::eCompute,
-                *mComputePipelineLayout,
-                0,
-                *mComputeDescriptorSet,
-                {});
-    mCommandBufferImageLoad->dispatch(
-                loadImage->getWidth() / 16 + 1,
-                loadImage->getHeight() / 16 + 1,
-                1);
-
-    renderTarget->transitionLayoutTo(
-                mCommandBufferImageLoad,
-                vk::ImageLayout::eShaderReadOnlyOptimal);
-
-    result = mCommandBufferImageLoad->end();
-}
-
-vk::DeviceMemory* CsCommandBuffer::recordImageSave(
+const void* CsCommandBuffer::recordImageSave(
         CsImage *const inputImage)
 {
     CS_LOG_INFO("Copying image GPU-->CPU.");
@@ -232,15 +165,19 @@ vk::DeviceMemory* CsCommandBuffer::recordImageSave(
     // This is for outputting an image to the CPU
     auto result = mComputeQueue.waitIdle();
 
-    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
+    auto outputImageSize = QSize(inputImage->getWidth(), inputImage->getHeight());
 
-    result = mCommandBufferImageSave->begin(cmdBufferBeginInfo);
+    vk::DeviceSize bufferSize = static_cast<vk::DeviceSize>(outputImageSize.width()) *
+                                outputImageSize.height() *
+                                getBytesPerPixel(inputImage->getFormat());
 
-    auto outputImageSize = QSize(inputImage->getWidth(), inputImage->getHeight());
+    // Nothing is recorded, so nothing must be submitted
+    if (!createBuffer(mOutputStagingBuffer, mOutputStagingAllocation, bufferSize))
+        return nullptr;
 
-    vk::DeviceSize bufferSize = outputImageSize.width() * outputImageSize.height() * 16; // 4 channels * 4 bytes
+    vk::CommandBufferBeginInfo cmdBufferBeginInfo;
 
-    createBuffer(mOutputStagingBuffer, mOutputStagingBufferMemory, bufferSize);
+    result = mCommandBufferImageSave->begin(cmdBufferBeginInfo);
 
     inputImage->transitionLayoutTo(
                 mCommandBufferImageSave,
@@ -276,7 +213,7 @@ vk::DeviceMemory* CsCommandBuffer::recordImageSave(
     result = mCommandBufferImageSave->end();
     Q_UNUSED(result);
 
-    return &mOutputStagingBufferMemory.get();
+    return mOutputStagingAllocation.getMappedData();
 }
 
 void CsCommandBuffer::submitGeneric()
@@ -302,29 +239,11 @@ void CsCommandBuffer::submitGeneric()
                 *mFence);
     if (result != vk::Result::eSuccess)
         CS_LOG_WARNING("Problem submitting compute queue.");
-}
 
-void CsCommandBuffer::submitImageLoad()
-{
-    vk::Result result = device->waitForFences(1, &(*mFence), true, UINT64_MAX);
+    // The images used can be released as soon as this returns
+    result = device->waitForFences(1, &(*mFence), true, UINT64_MAX);
     if (result != vk::Result::eSuccess)
         CS_LOG_WARNING("Problem waiting for fence.");
-    result = device->resetFences(1, &(*mFence));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Could not reset fence.");
-
-    // Do the copy on the compute queue
-    vk::SubmitInfo computeSubmitInfo;
-    computeSubmitInfo.commandBufferCount = 1;
-
-    computeSubmitInfo.pCommandBuffers = &mCommandBufferImageLoad.get();
-
-    result = mComputeQueue.submit(
-                1,
-                &computeSubmitInfo,
-                *mFence);
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Problem submitting compute queue.");
 }
 
 void CsCommandBuffer::submitImageSave()
@@ -353,20 +272,17 @@ vk::Queue* CsCommandBuffer::getQueue()
     return &mComputeQueue;
 }
 
-vk::CommandBuffer* CsCommandBuffer::getGeneric()
+uint32_t CsCommandBuffer::getQueueFamilyIndex() const
 {
-    auto result = mComputeQueue.waitIdle();
-    Q_UNUSED(result);
-
-    return &(*mCommandBufferGeneric);
+    return computeFamilyIndex;
 }
 
-vk::CommandBuffer* CsCommandBuffer::getImageLoad()
+vk::CommandBuffer* CsCommandBuffer::getGeneric()
 {
     auto result = mComputeQueue.waitIdle();
     Q_UNUSED(result);
 
-    return &(*mCommandBufferImageLoad);
+    return &(*mCommandBufferGeneric);
 }
 
 vk::CommandBuffer* CsCommandBuffer::getImageSave()
@@ -374,9 +290,9 @@ vk::CommandBuffer* CsCommandBuffer::getImageSave()
     return &(*mCommandBufferImageSave);
 }
 
-void CsCommandBuffer::createBuffer(
+bool CsCommandBuffer::createBuffer(
         vk::UniqueBuffer& buffer,
-        vk::UniqueDeviceMemory& bufferMemory,
+        CsAllocation& allocation,
         vk::DeviceSize& size)
 {
     vk::BufferCreateInfo bufferInfo(
@@ -387,6 +303,10 @@ void CsCommandBuffer::createBuffer(
                     vk::BufferUsageFlagBits::eUniformBuffer),
                 vk::SharingMode::eExclusive);
 
+    // The previous buffer has to go before its memory is returned
+    buffer.reset();
+    allocation = CsAllocation();
+
     buffer = device->createBufferUnique(bufferInfo).value;
 
 #ifdef QT_DEBUG
@@ -402,42 +322,27 @@ void CsCommandBuffer::createBuffer(
 
     vk::MemoryRequirements memRequirements = device->getBufferMemoryRequirements(*buffer);
 
-    uint32_t memoryType = findMemoryType(
+    uint32_t memoryType = mAllocator->findMemoryIndex(
                 memRequirements.memoryTypeBits,
                 vk::MemoryPropertyFlags(
                     vk::MemoryPropertyFlagBits::eHostVisible |
                     vk::MemoryPropertyFlagBits::eHostCoherent));
 
-    vk::MemoryAllocateInfo allocInfo(memRequirements.size,
-                                     memoryType);
-
-    bufferMemory = device->allocateMemoryUnique(allocInfo).value;
-
-#ifdef QT_DEBUG
+    allocation = mAllocator->allocate(memRequirements, memoryType, true);
+    if (!allocation)
     {
-        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eDeviceMemory,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkDeviceMemory, *bufferMemory),
-                    "Output Staging Buffer Memory");
-        auto result = device->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
-        Q_UNUSED(result);
+        CS_LOG_WARNING("Could not allocate memory for output staging buffer.");
+        buffer.reset();
+        return false;
     }
-#endif
 
-    auto result = device->bindBufferMemory(*buffer, *bufferMemory, 0);
+    auto result = device->bindBufferMemory(
+                *buffer,
+                allocation.getMemory(),
+                allocation.getOffset());
     Q_UNUSED(result);
-}
 
-uint32_t CsCommandBuffer::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties)
-{
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice->getMemoryProperties();
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-    throw std::runtime_error("Failed to find suitable memory type!");
+    return true;
 }
 
 CsCommandBuffer::~CsCommandBuffer()
@@ -30,6 +30,7 @@ public:
     CsCommandBuffer(
             const vk::Device* d,
             const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
             vk::PipelineLayout* pipelineLayout,
             vk::DescriptorSet* descriptorSet);
 
@@ -39,24 +40,22 @@ public:
             CsImage* const outputImage,
             vk::Pipeline& pl,
             int numShaderPasses,
-            int currentShaderPass);
-    void recordImageLoad(
-            CsImage* const loadImage,
-            CsImage* const tmpImage,
-            CsImage* const renderTarget,
-            vk::Pipeline* const readNodePipeline);
-    vk::DeviceMemory* recordImageSave(
+            int currentShaderPass,
+            const QRegion& region);
+    // Returns the mapped staging memory the image is copied to,
+    // the pixels are in the format of the image. On nullptr
+    // nothing has been recorded and nothing must be submitted.
+    const void* recordImageSave(
             CsImage* const inputImage);
 
     void submitGeneric();
-    void submitImageLoad();
     void submitImageSave();
 
     ~CsCommandBuffer();
 
     vk::Queue* getQueue();
+    uint32_t getQueueFamilyIndex() const;
     vk::CommandBuffer* getGeneric();
-    vk::CommandBuffer* getImageLoad();
     vk::CommandBuffer* getImageSave();
 
 private:
@@ -64,24 +63,20 @@ private:
     void createComputeCommandPool();
     void createComputeCommandBuffers();
 
-    void createBuffer(
+    // False if there is no memory for it
+    bool createBuffer(
             vk::UniqueBuffer& buffer,
-            vk::UniqueDeviceMemory& bufferMemory,
+            CsAllocation& allocation,
             vk::DeviceSize& size);
 
-    uint32_t findMemoryType(
-            uint32_t typeFilter,
-            vk::MemoryPropertyFlags properties);
-
     const vk::Device* device;
     const vk::PhysicalDevice* physicalDevice;
+    CsMemoryAllocator* mAllocator;
     int computeFamilyIndex;
 
     vk::UniqueCommandPool mComputeCommandPool;
     // Command buffer for all shaders except IO
     vk::UniqueCommandBuffer mCommandBufferGeneric;
-    // Command buffer for loading images from disk
-    vk::UniqueCommandBuffer mCommandBufferImageLoad;
     // Command buffer for writing images to disk
     vk::UniqueCommandBuffer mCommandBufferImageSave;
 
@@ -93,8 +88,8 @@ private:
     vk::PipelineLayout* mComputePipelineLayout;
     vk::DescriptorSet* mComputeDescriptorSet;
 
+    CsAllocation mOutputStagingAllocation;
     vk::UniqueBuffer mOutputStagingBuffer;
-    vk::UniqueDeviceMemory mOutputStagingBufferMemory;
 };
 
 } // namespace Cascade::Renderer
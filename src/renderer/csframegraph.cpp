@@ -0,0 +1,678 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csframegraph.h"
+
+#include <algorithm>
+
+#include "../log.h"
+#include "renderconfig.h"
+#include "rendertask.h"
+#include "renderutility.h"
+
+namespace Cascade::Renderer {
+
+namespace
+{
+
+constexpr uint32_t descriptorSetsPerPool = 32;
+
+vk::ImageLayout getLayout(const ImageAccess access)
+{
+    switch (access)
+    {
+        case ImageAccess::eTransferRead:
+            return vk::ImageLayout::eTransferSrcOptimal;
+        case ImageAccess::eTransferWrite:
+            return vk::ImageLayout::eTransferDstOptimal;
+        case ImageAccess::eShaderRead:
+        case ImageAccess::eShaderWrite:
+            return vk::ImageLayout::eGeneral;
+        case ImageAccess::eSampled:
+            return vk::ImageLayout::eShaderReadOnlyOptimal;
+        default:
+            return vk::ImageLayout::eUndefined;
+    }
+}
+
+vk::PipelineStageFlags getStages(const ImageAccess access)
+{
+    switch (access)
+    {
+        case ImageAccess::eTransferRead:
+        case ImageAccess::eTransferWrite:
+            return vk::PipelineStageFlagBits::eTransfer;
+        case ImageAccess::eShaderRead:
+        case ImageAccess::eShaderWrite:
+            return vk::PipelineStageFlagBits::eComputeShader;
+        case ImageAccess::eSampled:
+            return vk::PipelineStageFlagBits::eComputeShader |
+                   vk::PipelineStageFlagBits::eFragmentShader;
+        default:
+            // An image can share memory with one used earlier in the
+            // same submission, so wait for whatever used it before
+            return vk::PipelineStageFlagBits::eTransfer |
+                   vk::PipelineStageFlagBits::eComputeShader;
+    }
+}
+
+vk::AccessFlags getAccessFlags(const ImageAccess access)
+{
+    switch (access)
+    {
+        case ImageAccess::eTransferRead:
+            return vk::AccessFlagBits::eTransferRead;
+        case ImageAccess::eTransferWrite:
+            return vk::AccessFlagBits::eTransferWrite;
+        case ImageAccess::eShaderRead:
+        case ImageAccess::eSampled:
+            return vk::AccessFlagBits::eShaderRead;
+        case ImageAccess::eShaderWrite:
+            return vk::AccessFlagBits::eShaderWrite;
+        default:
+            // The writes of an image that shared the memory
+            // before have to be available to the next access
+            return vk::AccessFlagBits::eShaderWrite |
+                   vk::AccessFlagBits::eTransferWrite;
+    }
+}
+
+} // namespace
+
+CsFrameGraph::CsFrameGraph(
+        vk::Device* d,
+        vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        vk::Queue queue,
+        const uint32_t queueFamilyIndex,
+        vk::DescriptorSetLayout descriptorSetLayout,
+        vk::PipelineLayout pipelineLayout) :
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mAllocator(allocator),
+    mQueue(queue),
+    mDescriptorSetLayout(descriptorSetLayout),
+    mPipelineLayout(pipelineLayout)
+{
+    vk::CommandPoolCreateInfo cmdPoolInfo(
+                { vk::CommandPoolCreateFlagBits::eResetCommandBuffer },
+                queueFamilyIndex);
+
+    mCommandPool = mDevice->createCommandPoolUnique(cmdPoolInfo).value;
+
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
+                *mCommandPool,
+                vk::CommandBufferLevel::ePrimary,
+                2);
+
+    auto commandBuffers = std::move(
+                mDevice->allocateCommandBuffersUnique(commandBufferAllocateInfo).value);
+    mCommandBuffer        = std::move(commandBuffers.at(0));
+    mFlushedCommandBuffer = std::move(commandBuffers.at(1));
+
+    mFence        = mDevice->createFenceUnique(vk::FenceCreateInfo()).value;
+    mFlushedFence = mDevice->createFenceUnique(vk::FenceCreateInfo()).value;
+
+    mStagingBuffer = std::make_unique<CsStagingBuffer>(mDevice, mAllocator, stagingBufferSize);
+
+    // Only the first half is used, the readbacks all finish with the job
+    mReadbackBuffer = std::make_unique<CsStagingBuffer>(
+                mDevice,
+                mAllocator,
+                readbackBufferSize * 2,
+                vk::BufferUsageFlagBits::eTransferDst);
+
+    CS_LOG_INFO("Created frame graph.");
+}
+
+void CsFrameGraph::begin()
+{
+    if (mIsRecording)
+        submit();
+
+    vk::CommandBufferBeginInfo cmdBufferBeginInfo(
+                vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+    [[maybe_unused]] auto result = mCommandBuffer->begin(cmdBufferBeginInfo);
+
+    mIsRecording = true;
+}
+
+bool CsFrameGraph::isRecording() const
+{
+    return mIsRecording;
+}
+
+bool CsFrameGraph::isUsing(const CsImage* image) const
+{
+    return mImageIds.find(image) != mImageIds.end();
+}
+
+void CsFrameGraph::addDispatch(
+        vk::Pipeline pipeline,
+        CsImage* const inputImageBack,
+        CsImage* const inputImageFront,
+        CsImage* const outputImage,
+        const std::vector<float>& settings,
+        const QRegion& region,
+        const bool pushSettings,
+        const int shaderPass)
+{
+    std::vector<std::pair<int, ImageAccess>> accesses =
+    {
+        { getImageId(inputImageBack), ImageAccess::eShaderRead },
+        { getImageId(outputImage), ImageAccess::eShaderWrite }
+    };
+    if (inputImageFront)
+        accesses.push_back({ getImageId(inputImageFront), ImageAccess::eShaderRead });
+
+    recordBarriers(mPlanner.addPass(accesses));
+
+    // The uniform buffer is bound either way, the layout has it,
+    // but shaders with push constants don't take a slot of it
+    uint32_t settingsOffset = 0;
+    CsSettingsBuffer* settingsBuffer = nullptr;
+    if (pushSettings)
+    {
+        if (mSettingsBuffers.empty())
+        {
+            mSettingsBuffers.push_back(std::make_unique<CsSettingsBuffer>(
+                        mDevice, mPhysicalDevice, mAllocator, settingsSlotsPerBuffer));
+        }
+        settingsBuffer = mSettingsBuffers.front().get();
+    }
+    else
+    {
+        DispatchInfo info;
+        info.hasMask    = inputImageFront ? 1.0f : 0.0f;
+        info.shaderPass = static_cast<float>(shaderPass);
+
+        settingsBuffer = writeSettings(settings, info, settingsOffset);
+    }
+
+    vk::DescriptorSet descriptorSet = allocateDescriptorSet();
+
+    vk::DescriptorImageInfo sourceInfoBack(
+                {},
+                *inputImageBack->getImageView(),
+                vk::ImageLayout::eGeneral);
+
+    vk::DescriptorImageInfo sourceInfoFront(
+                {},
+                inputImageFront ? *inputImageFront->getImageView() :
+                                  *inputImageBack->getImageView(),
+                vk::ImageLayout::eGeneral);
+
+    vk::DescriptorImageInfo destinationInfo(
+                {},
+                *outputImage->getImageView(),
+                vk::ImageLayout::eGeneral);
+
+    vk::DescriptorBufferInfo settingsBufferInfo(
+                *settingsBuffer->getBuffer(),
+                0,
+                CsSettingsBuffer::getRange());
+
+    std::vector<vk::WriteDescriptorSet> descWrite(4);
+
+    descWrite.at(0) = vk::WriteDescriptorSet(
+                descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageImage, &sourceInfoBack);
+    descWrite.at(1) = vk::WriteDescriptorSet(
+                descriptorSet, 1, 0, 1, vk::DescriptorType::eStorageImage, &sourceInfoFront);
+    descWrite.at(2) = vk::WriteDescriptorSet(
+                descriptorSet, 2, 0, 1, vk::DescriptorType::eStorageImage, &destinationInfo);
+    descWrite.at(3) = vk::WriteDescriptorSet(
+                descriptorSet, 3, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &settingsBufferInfo);
+
+    mDevice->updateDescriptorSets(descWrite, {});
+
+    mCommandBuffer->bindPipeline(
+                vk::PipelineBindPoint::eCompute,
+                pipeline);
+    mCommandBuffer->bindDescriptorSets(
+                vk::PipelineBindPoint::eCompute,
+                mPipelineLayout,
+                0,
+                descriptorSet,
+                settingsOffset);
+    if (pushSettings && !settings.empty())
+    {
+        const size_t numValues =
+                std::min(settings.size(), static_cast<size_t>(maxPushConstantSettings));
+        mCommandBuffer->pushConstants(
+                    mPipelineLayout,
+                    vk::ShaderStageFlagBits::eCompute,
+                    0,
+                    static_cast<uint32_t>(numValues * sizeof(float)),
+                    settings.data());
+    }
+    dispatchRegion(*mCommandBuffer, region);
+
+    mNumPasses++;
+}
+
+void CsFrameGraph::addCopy(
+        CsImage* const src,
+        CsImage* const dst)
+{
+    recordBarriers(mPlanner.addPass(
+    {
+        { getImageId(src), ImageAccess::eTransferRead },
+        { getImageId(dst), ImageAccess::eTransferWrite }
+    }));
+
+    vk::ImageCopy copyInfo;
+    copyInfo.srcSubresource.aspectMask  = vk::ImageAspectFlagBits::eColor;
+    copyInfo.srcSubresource.layerCount  = 1;
+    copyInfo.dstSubresource.aspectMask  = vk::ImageAspectFlagBits::eColor;
+    copyInfo.dstSubresource.layerCount  = 1;
+    copyInfo.extent.width               = src->getWidth();
+    copyInfo.extent.height              = src->getHeight();
+    copyInfo.extent.depth               = 1;
+
+    mCommandBuffer->copyImage(
+                *src->getImage(),
+                vk::ImageLayout::eTransferSrcOptimal,
+                *dst->getImage(),
+                vk::ImageLayout::eTransferDstOptimal,
+                1,
+                &copyInfo);
+
+    mNumPasses++;
+}
+
+bool CsFrameGraph::addUpload(
+        CsImage* const dst,
+        const int pixelSize,
+        const std::function<void(char* data, const int firstRow, const int numRows)>& write)
+{
+    const int width  = dst->getWidth();
+    const int height = dst->getHeight();
+
+    const vk::DeviceSize rowSize = static_cast<vk::DeviceSize>(width) * pixelSize;
+    const int rowsPerBand        = static_cast<int>(std::min(
+                static_cast<vk::DeviceSize>(height),
+                mStagingBuffer->getHalfSize() / rowSize));
+    if (rowsPerBand == 0)
+    {
+        CS_LOG_WARNING("Image is too wide for the staging buffer.");
+        return false;
+    }
+
+    // Later submissions are ordered after this barrier as well
+    recordBarriers(mPlanner.addPass({ { getImageId(dst), ImageAccess::eTransferWrite } }));
+
+    for (int firstRow = 0; firstRow < height; firstRow += rowsPerBand)
+    {
+        const int numRows = std::min(rowsPerBand, height - firstRow);
+
+        vk::DeviceSize offset = 0;
+        char* data = mStagingBuffer->allocate(rowSize * numRows, offset);
+        if (!data)
+        {
+            flush();
+            data = mStagingBuffer->allocate(rowSize * numRows, offset);
+        }
+        if (!data)
+            return false;
+
+        write(data, firstRow, numRows);
+
+        vk::BufferImageCopy copyInfo;
+        copyInfo.bufferOffset                = offset;
+        copyInfo.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        copyInfo.imageSubresource.layerCount = 1;
+        copyInfo.imageOffset                 = vk::Offset3D(0, firstRow, 0);
+        copyInfo.imageExtent                 = vk::Extent3D(width, numRows, 1);
+
+        mCommandBuffer->copyBufferToImage(
+                    mStagingBuffer->getBuffer(),
+                    *dst->getImage(),
+                    vk::ImageLayout::eTransferDstOptimal,
+                    copyInfo);
+    }
+
+    mNumPasses++;
+
+    return true;
+}
+
+void CsFrameGraph::flush()
+{
+    [[maybe_unused]] vk::Result result = mCommandBuffer->end();
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &mCommandBuffer.get();
+
+    result = mQueue.submit(1, &submitInfo, *mFence);
+    if (result != vk::Result::eSuccess)
+        CS_LOG_WARNING("Problem submitting frame graph.");
+
+    // The other command buffer and half of the staging
+    // buffer can be reused once their copies are done
+    if (mHasFlushed)
+        waitForFence(*mFlushedFence);
+
+    std::swap(mCommandBuffer, mFlushedCommandBuffer);
+    std::swap(mFence, mFlushedFence);
+    mHasFlushed = true;
+
+    mStagingBuffer->switchHalf();
+
+    vk::CommandBufferBeginInfo cmdBufferBeginInfo(
+                vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+    result = mCommandBuffer->begin(cmdBufferBeginInfo);
+}
+
+bool CsFrameGraph::waitForFence(vk::Fence fence)
+{
+    vk::Result result = mDevice->waitForFences(1, &fence, true, UINT64_MAX);
+    if (result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Problem waiting for fence.");
+        return false;
+    }
+    result = mDevice->resetFences(1, &fence);
+    if (result != vk::Result::eSuccess)
+        CS_LOG_WARNING("Could not reset fence.");
+
+    return true;
+}
+
+bool CsFrameGraph::addReadback(
+        CsImage* const src,
+        const std::function<void(const char* data)>& read)
+{
+    const vk::DeviceSize size =
+            static_cast<vk::DeviceSize>(src->getWidth()) * src->getHeight() *
+            getBytesPerPixel(src->getFormat());
+
+    vk::DeviceSize offset = 0;
+    const char* data = mReadbackBuffer->allocate(size, offset);
+    if (!data)
+    {
+        CS_LOG_WARNING("Image is too big for the readback buffer.");
+        return false;
+    }
+
+    recordBarriers(mPlanner.addPass({ { getImageId(src), ImageAccess::eTransferRead } }));
+
+    vk::BufferImageCopy copyInfo;
+    copyInfo.bufferOffset                = offset;
+    copyInfo.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    copyInfo.imageSubresource.layerCount = 1;
+    copyInfo.imageExtent                 = vk::Extent3D(src->getWidth(), src->getHeight(), 1);
+
+    mCommandBuffer->copyImageToBuffer(
+                *src->getImage(),
+                vk::ImageLayout::eTransferSrcOptimal,
+                mReadbackBuffer->getBuffer(),
+                copyInfo);
+
+    // The fence alone doesn't make the copy visible to the host
+    vk::BufferMemoryBarrier barrier(
+                vk::AccessFlagBits::eTransferWrite,
+                vk::AccessFlagBits::eHostRead,
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                mReadbackBuffer->getBuffer(),
+                offset,
+                size);
+    mCommandBuffer->pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eHost,
+                {},
+                {},
+                barrier,
+                {});
+
+    mReadbacks.push_back({ data, read });
+
+    mNumPasses++;
+
+    return true;
+}
+
+void CsFrameGraph::keepAlive(std::unique_ptr<CsImage> image)
+{
+    mTransientImages.push_back(std::move(image));
+}
+
+bool CsFrameGraph::submit()
+{
+    bool success = submitWithoutWaiting();
+
+    if (!wait())
+        success = false;
+
+    reset();
+
+    return success;
+}
+
+bool CsFrameGraph::submitWithoutWaiting()
+{
+    if (!mIsRecording)
+        return true;
+
+    recordBarriers(mPlanner.finish(ImageAccess::eSampled));
+
+    vk::Result result = mCommandBuffer->end();
+    mIsRecording = false;
+
+    // Everything was cached, nothing to do on the GPU
+    if (mNumPasses == 0)
+        return true;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &mCommandBuffer.get();
+
+    result = mQueue.submit(1, &submitInfo, *mFence);
+    if (result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Problem submitting frame graph.");
+        return false;
+    }
+    mIsSubmitted = true;
+
+    return true;
+}
+
+bool CsFrameGraph::wait()
+{
+    bool success = true;
+
+    if (mIsSubmitted && !waitForFence(*mFence))
+        success = false;
+    mIsSubmitted = false;
+
+    // Finished before the last submission, only the fence needs a reset
+    if (mHasFlushed && !waitForFence(*mFlushedFence))
+        success = false;
+    mHasFlushed = false;
+
+    if (success)
+    {
+        for (auto& [data, read] : mReadbacks)
+            read(data);
+    }
+    mReadbacks.clear();
+
+    return success;
+}
+
+int CsFrameGraph::getImageId(CsImage* const image)
+{
+    auto it = mImageIds.find(image);
+    if (it != mImageIds.end())
+        return it->second;
+
+    // Cached results are kept ready for sampling, anything
+    // else is treated as if its content was unknown
+    ImageAccess initial = ImageAccess::eUndefined;
+    if (image->getLayout() == vk::ImageLayout::eShaderReadOnlyOptimal)
+        initial = ImageAccess::eSampled;
+
+    int id = mPlanner.addImage(initial);
+    mImages.push_back(image);
+    mImageIds[image] = id;
+
+    return id;
+}
+
+void CsFrameGraph::recordBarriers(const std::vector<ImageTransition>& transitions)
+{
+    if (transitions.empty())
+        return;
+
+    vk::PipelineStageFlags srcStages;
+    vk::PipelineStageFlags dstStages;
+
+    std::vector<vk::ImageMemoryBarrier> barriers;
+    for (auto& transition : transitions)
+    {
+        CsImage* image = mImages.at(transition.image);
+
+        // The current layout of the image, also if it comes from outside the graph
+        vk::ImageMemoryBarrier barrier(
+                    getAccessFlags(transition.from),
+                    getAccessFlags(transition.to),
+                    image->getLayout(),
+                    getLayout(transition.to),
+                    VK_QUEUE_FAMILY_IGNORED,
+                    VK_QUEUE_FAMILY_IGNORED,
+                    *image->getImage(),
+                    vk::ImageSubresourceRange(
+                        vk::ImageAspectFlagBits::eColor,
+                        0,
+                        1,
+                        0,
+                        1));
+        barriers.push_back(barrier);
+
+        srcStages |= getStages(transition.from);
+        dstStages |= getStages(transition.to);
+
+        image->setLayout(getLayout(transition.to));
+    }
+
+    // All transitions before a pass go into one barrier
+    mCommandBuffer->pipelineBarrier(
+                srcStages,
+                dstStages,
+                {},
+                {},
+                {},
+                barriers);
+}
+
+vk::DescriptorSet CsFrameGraph::allocateDescriptorSet()
+{
+    // Start a new pool when the current one is full
+    if (mNumSetsInPool == descriptorSetsPerPool)
+    {
+        mCurrentDescriptorPool++;
+        mNumSetsInPool = 0;
+    }
+
+    if (mCurrentDescriptorPool == mDescriptorPools.size())
+    {
+        std::vector<vk::DescriptorPoolSize> poolSizes =
+        {
+            { vk::DescriptorType::eStorageImage, 3 * descriptorSetsPerPool },
+            { vk::DescriptorType::eUniformBufferDynamic, descriptorSetsPerPool }
+        };
+        vk::DescriptorPoolCreateInfo poolInfo({}, descriptorSetsPerPool, poolSizes);
+
+        mDescriptorPools.push_back(mDevice->createDescriptorPoolUnique(poolInfo).value);
+    }
+
+    vk::DescriptorSetAllocateInfo allocInfo(
+                *mDescriptorPools.at(mCurrentDescriptorPool),
+                1,
+                &mDescriptorSetLayout);
+
+    mNumSetsInPool++;
+
+    return mDevice->allocateDescriptorSets(allocInfo).value.front();
+}
+
+CsSettingsBuffer* CsFrameGraph::writeSettings(
+        const std::vector<float>& values,
+        const DispatchInfo& info,
+        uint32_t& offset)
+{
+    if (mCurrentSettingsBuffer < mSettingsBuffers.size())
+    {
+        CsSettingsBuffer* buffer = mSettingsBuffers.at(mCurrentSettingsBuffer).get();
+        if (buffer->write(values, info, offset))
+            return buffer;
+
+        // Full, continue with the next one
+        mCurrentSettingsBuffer++;
+    }
+
+    if (mCurrentSettingsBuffer == mSettingsBuffers.size())
+    {
+        mSettingsBuffers.push_back(std::make_unique<CsSettingsBuffer>(
+                    mDevice, mPhysicalDevice, mAllocator, settingsSlotsPerBuffer));
+    }
+
+    CsSettingsBuffer* buffer = mSettingsBuffers.at(mCurrentSettingsBuffer).get();
+    if (!buffer->write(values, info, offset))
+    {
+        CS_LOG_WARNING("Could not write settings.");
+        offset = 0;
+    }
+    return buffer;
+}
+
+void CsFrameGraph::reset()
+{
+    mTransientImages.clear();
+
+    for (auto& pool : mDescriptorPools)
+        mDevice->resetDescriptorPool(*pool);
+    mCurrentDescriptorPool = 0;
+    mNumSetsInPool         = 0;
+
+    for (auto& buffer : mSettingsBuffers)
+        buffer->reset();
+    mCurrentSettingsBuffer = 0;
+
+    mStagingBuffer->reset();
+    mReadbackBuffer->reset();
+    mReadbacks.clear();
+
+    mPlanner.reset();
+    mImages.clear();
+    mImageIds.clear();
+
+    mNumPasses = 0;
+}
+
+CsFrameGraph::~CsFrameGraph()
+{
+    CS_LOG_INFO("Destroying frame graph.");
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,173 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSFRAMEGRAPH_H
+#define CSFRAMEGRAPH_H
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "barrierplanner.h"
+#include "csimage.h"
+#include "cssettingsbuffer.h"
+#include "csstagingbuffer.h"
+
+namespace Cascade::Renderer {
+
+// Records the passes of a whole render job into one command buffer
+// and submits it once. The barriers between the passes are planned
+// from the images each pass reads and writes.
+class CsFrameGraph
+{
+public:
+    CsFrameGraph(
+            vk::Device* d,
+            vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            vk::Queue queue,
+            const uint32_t queueFamilyIndex,
+            vk::DescriptorSetLayout descriptorSetLayout,
+            vk::PipelineLayout pipelineLayout);
+
+    void begin();
+    bool isRecording() const;
+
+    // True from the first pass that uses the image
+    // until the submission has finished
+    bool isUsing(const CsImage* image) const;
+
+    // Back and front are read, front can be nullptr.
+    // Only the work groups covering the region are dispatched.
+    // The settings go into the uniform buffer at binding 3 along with
+    // the DispatchInfo, or into the push constants for shaders that
+    // read them from there. Those get no DispatchInfo.
+    void addDispatch(
+            vk::Pipeline pipeline,
+            CsImage* const inputImageBack,
+            CsImage* const inputImageFront,
+            CsImage* const outputImage,
+            const std::vector<float>& settings,
+            const QRegion& region,
+            const bool pushSettings = false,
+            const int shaderPass = 0);
+
+    void addCopy(
+            CsImage* const src,
+            CsImage* const dst);
+
+    // Copies pixels from the CPU into the image through the staging buffer,
+    // in bands of rows that fit into half of it. write() puts the rows
+    // from firstRow on into data, tightly packed with pixelSize bytes per
+    // pixel. When a half is full it is submitted, so the next band is
+    // written while the GPU copies the last one.
+    bool addUpload(
+            CsImage* const dst,
+            const int pixelSize,
+            const std::function<void(char* data, const int firstRow, const int numRows)>& write);
+
+    // Copies the image into host memory. read() gets the pixels,
+    // tightly packed, once wait() has seen the submission finish.
+    bool addReadback(
+            CsImage* const src,
+            const std::function<void(const char* data)>& read);
+
+    // Images that are only needed by the recorded commands
+    // are destroyed after the submission has finished
+    void keepAlive(std::unique_ptr<CsImage> image);
+
+    // Leaves all images the passes used ready for sampling,
+    // submits the command buffer and waits for it
+    bool submit();
+
+    // The same in steps, so the caller can let others go on while the
+    // GPU works. wait() only touches the fences and hands out the
+    // readbacks, reset() frees what the submission kept alive and
+    // has to follow it.
+    bool submitWithoutWaiting();
+    bool wait();
+    void reset();
+
+    ~CsFrameGraph();
+
+private:
+    int getImageId(CsImage* const image);
+
+    // Submits what has been recorded so far without waiting for it and
+    // continues in the other command buffer and half of the staging buffer
+    void flush();
+    bool waitForFence(vk::Fence fence);
+
+    void recordBarriers(const std::vector<ImageTransition>& transitions);
+
+    vk::DescriptorSet allocateDescriptorSet();
+
+    // The buffer with a free slot for the values and the offset of that slot
+    CsSettingsBuffer* writeSettings(
+            const std::vector<float>& values,
+            const DispatchInfo& info,
+            uint32_t& offset);
+
+    vk::Device* mDevice;
+    vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mAllocator;
+
+    vk::Queue mQueue;
+
+    vk::DescriptorSetLayout mDescriptorSetLayout;
+    vk::PipelineLayout mPipelineLayout;
+
+    vk::UniqueCommandPool mCommandPool;
+    vk::UniqueCommandBuffer mCommandBuffer;
+    vk::UniqueFence mFence;
+
+    // Submitted by flush(), may still be running
+    vk::UniqueCommandBuffer mFlushedCommandBuffer;
+    vk::UniqueFence mFlushedFence;
+    bool mHasFlushed = false;
+
+    std::unique_ptr<CsStagingBuffer> mStagingBuffer;
+
+    std::unique_ptr<CsStagingBuffer> mReadbackBuffer;
+    std::vector<std::pair<const char*, std::function<void(const char* data)>>> mReadbacks;
+
+    bool mIsRecording = false;
+    bool mIsSubmitted = false;
+    int mNumPasses = 0;
+
+    BarrierPlanner mPlanner;
+    std::vector<CsImage*> mImages;
+    std::unordered_map<const CsImage*, int> mImageIds;
+
+    std::vector<std::unique_ptr<CsImage>> mTransientImages;
+
+    // Every dispatch gets its own descriptor set and slot for the
+    // settings, both are reused by the next recording
+    std::vector<vk::UniqueDescriptorPool> mDescriptorPools;
+    size_t mCurrentDescriptorPool = 0;
+    uint32_t mNumSetsInPool = 0;
+
+    std::vector<std::unique_ptr<CsSettingsBuffer>> mSettingsBuffers;
+    size_t mCurrentSettingsBuffer = 0;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSFRAMEGRAPH_H
@@ -29,93 +29,157 @@ CsImage::CsImage(
         VulkanWindow* win,
         const vk::Device* d,
         const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
         const int w,
         const int h,
         const bool isLinear,
+        const vk::Format format,
         const char* debugName)
         : mDevice(d),
           mPhysicalDevice(pd),
           mWidth(w),
-          mHeight(h)
+          mHeight(h),
+          mFormat(format)
 {
     mWindow = win;
 
-    isLinear ? mCurrentLayout = vk::ImageLayout::eUndefined :
-               mCurrentLayout = vk::ImageLayout::ePreinitialized;
+    createImage(isLinear, debugName);
 
-    vk::ImageCreateInfo imageInfo(
-                {},
-                vk::ImageType::e2D,
-                vk::Format::eR32G32B32A32Sfloat,
-                vk::Extent3D(mWidth, mHeight, 1),
-                1,
-                1,
-                vk::SampleCountFlagBits::e1,
-                isLinear ? vk::ImageTiling::eLinear :
-                           vk::ImageTiling::eOptimal,
-                isLinear ? vk::ImageUsageFlagBits::eSampled |
-                           vk::ImageUsageFlagBits::eTransferSrc :
-                           vk::ImageUsageFlagBits::eSampled |
-                           vk::ImageUsageFlagBits::eStorage |
-                           vk::ImageUsageFlagBits::eTransferSrc |
-                           vk::ImageUsageFlagBits::eTransferDst,
-                vk::SharingMode::eExclusive,
-                {},
-                {},
-                mCurrentLayout);
-    mImage = mDevice->createImageUnique(imageInfo).value;
+    // Get how much memory we need and how it should aligned
+    vk::MemoryRequirements memReq = mDevice->getImageMemoryRequirements(*mImage);
 
-#ifdef QT_DEBUG
+    // Make sure linear images get memory visible to the CPU
+    uint32_t memIndex = getMemoryIndex(mWindow, mPhysicalDevice, memReq.memoryTypeBits, isLinear);
+
+    mAllocation = allocator->allocate(memReq, memIndex, isLinear);
+    if (!mAllocation)
     {
-        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eImage,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkImage, *mImage),
-                    debugName);
-         [[maybe_unused]] auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
+        CS_LOG_WARNING("Could not allocate memory for image.");
+        return;
     }
-#endif
 
-    // Get how much memory we need and how it should aligned
+    //Associate the image with this chunk of memory
+     [[maybe_unused]] auto result = mDevice->bindImageMemory(
+                 *mImage, mAllocation.getMemory(), mAllocation.getOffset());
+
+    createView();
+}
+
+CsImage::CsImage(
+        VulkanWindow* win,
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        const int w,
+        const int h,
+        const vk::Format format,
+        const MemoryProvider& memoryProvider,
+        const char* debugName)
+        : mDevice(d),
+          mPhysicalDevice(pd),
+          mWidth(w),
+          mHeight(h),
+          mFormat(format)
+{
+    mWindow = win;
+
+    createImage(false, debugName);
+
     vk::MemoryRequirements memReq = mDevice->getImageMemoryRequirements(*mImage);
 
-    // Make sure linear images get memory visible to the CPU
+    const CsAllocation& allocation = memoryProvider(memReq);
+    if (!allocation)
+    {
+        CS_LOG_WARNING("Could not allocate memory for image.");
+        return;
+    }
+
+    [[maybe_unused]] auto result = mDevice->bindImageMemory(
+                *mImage, allocation.getMemory(), allocation.getOffset());
+
+    createView();
+}
+
+uint32_t CsImage::getMemoryIndex(
+        VulkanWindow* win,
+        const vk::PhysicalDevice* pd,
+        const uint32_t memoryTypeBits,
+        const bool isLinear)
+{
     uint32_t memIndex = 0;
 
-    isLinear ? memIndex = mWindow->hostVisibleMemoryIndex() :
-               memIndex = mWindow->deviceLocalMemoryIndex();
+    isLinear ? memIndex = win->hostVisibleMemoryIndex() :
+               memIndex = win->deviceLocalMemoryIndex();
 
-    if (!(memReq.memoryTypeBits & (1 << memIndex)))
+    if (!(memoryTypeBits & (1 << memIndex)))
     {
-        vk::PhysicalDeviceMemoryProperties physDevMemProps = mPhysicalDevice->getMemoryProperties();
+        vk::PhysicalDeviceMemoryProperties physDevMemProps = pd->getMemoryProperties();
         for (uint32_t i = 0; i < physDevMemProps.memoryTypeCount; ++i)
         {
-            if (!(memReq.memoryTypeBits & (1 << i)))
+            if (!(memoryTypeBits & (1 << i)))
                 continue;
             memIndex = i;
         }
     }
 
-    vk::MemoryAllocateInfo allocInfo(memReq.size, memIndex);
-    mMemory = mDevice->allocateMemoryUnique(allocInfo).value;
+    return memIndex;
+}
+
+vk::ImageUsageFlags CsImage::getUsageFlags(const bool isLinear)
+{
+    if (isLinear)
+        return vk::ImageUsageFlagBits::eSampled |
+               vk::ImageUsageFlagBits::eTransferSrc;
+
+    return vk::ImageUsageFlagBits::eSampled |
+           vk::ImageUsageFlagBits::eStorage |
+           vk::ImageUsageFlagBits::eTransferSrc |
+           vk::ImageUsageFlagBits::eTransferDst;
+}
+
+void CsImage::createImage(const bool isLinear, const char* debugName)
+{
+    isLinear ? mCurrentLayout = vk::ImageLayout::eUndefined :
+               mCurrentLayout = vk::ImageLayout::ePreinitialized;
+
+    mTiling = isLinear ? vk::ImageTiling::eLinear : vk::ImageTiling::eOptimal;
+    mUsage  = getUsageFlags(isLinear);
+
+    vk::ImageCreateInfo imageInfo(
+                {},
+                vk::ImageType::e2D,
+                mFormat,
+                vk::Extent3D(mWidth, mHeight, 1),
+                1,
+                1,
+                vk::SampleCountFlagBits::e1,
+                mTiling,
+                mUsage,
+                vk::SharingMode::eExclusive,
+                {},
+                {},
+                mCurrentLayout);
+    mImage = mDevice->createImageUnique(imageInfo).value;
 
 #ifdef QT_DEBUG
     {
         vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-                    vk::ObjectType::eDeviceMemory,
-                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkDeviceMemory, *mMemory),
+                    vk::ObjectType::eImage,
+                    NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkImage, *mImage),
                     debugName);
          [[maybe_unused]] auto result = mDevice->setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
     }
+#else
+    Q_UNUSED(debugName);
 #endif
+}
 
-    //Associate the image with this chunk of memory
-     [[maybe_unused]] auto result = mDevice->bindImageMemory(*mImage, *mMemory, 0);
-
+void CsImage::createView()
+{
     vk::ImageViewCreateInfo viewInfo(
                 { },
                 *mImage,
                 vk::ImageViewType::e2D,
-                vk::Format::eR32G32B32A32Sfloat,
+                mFormat,
                 vk::ComponentMapping(vk::ComponentSwizzle::eR,
                                      vk::ComponentSwizzle::eG,
                                      vk::ComponentSwizzle::eB,
@@ -139,9 +203,9 @@ const vk::UniqueImageView& CsImage::getImageView() const
     return mView;
 }
 
-const vk::UniqueDeviceMemory& CsImage::getMemory() const
+const CsAllocation& CsImage::getAllocation() const
 {
-    return mMemory;
+    return mAllocation;
 }
 
 vk::ImageLayout CsImage::getLayout() const
@@ -195,6 +259,41 @@ int CsImage::getHeight() const
     return mHeight;
 }
 
+vk::Format CsImage::getFormat() const
+{
+    return mFormat;
+}
+
+vk::ImageTiling CsImage::getTiling() const
+{
+    return mTiling;
+}
+
+vk::ImageUsageFlags CsImage::getUsage() const
+{
+    return mUsage;
+}
+
+void CsImage::setLastUse(const uint64_t frame)
+{
+    mLastUse = frame;
+}
+
+uint64_t CsImage::getLastUse() const
+{
+    return mLastUse;
+}
+
+void CsImage::setValidRegion(const QRegion& region)
+{
+    mValidRegion = region;
+}
+
+const QRegion& CsImage::getValidRegion() const
+{
+    return mValidRegion;
+}
+
 void CsImage::destroy()
 {
 
@@ -202,9 +301,9 @@ void CsImage::destroy()
 
 CsImage::~CsImage()
 {
-    // Need to make sure this image is not used by any command buffer
-    auto result = mDevice->waitIdle();
-    Q_UNUSED(result);
+    // Whoever owns the image makes sure the GPU is done with it,
+    // the command buffers wait for their fences and the images
+    // on screen go through the CsImagePool.
 }
 
 } // end namespace Cascade::Renderer
@@ -20,11 +20,16 @@
 #ifndef CSIMAGE_H
 #define CSIMAGE_H
 
+#include <functional>
+
+#include <QRegion>
 #include <QVulkanDeviceFunctions>
 
 #include <vulkan/vulkan.h>
 
 #include "../vulkanwindow.h"
+#include "csmemoryallocator.h"
+#include "renderconfig.h"
 #include "vulkanhppinclude.h"
 
 namespace Cascade::Renderer {
@@ -35,14 +40,38 @@ public:
     CsImage(VulkanWindow* win,
             const vk::Device* d,
             const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
             const int w = 100,
             const int h = 100,
             const bool isLinear = false,
+            const vk::Format format = globalImageFormat,
+            const char* debugName = "Unnamed");
+
+    // Returns the memory an image is bound to if the image doesn't own it
+    using MemoryProvider = std::function<const CsAllocation&(const vk::MemoryRequirements&)>;
+
+    // An optimal image bound to memory that is owned elsewhere
+    CsImage(VulkanWindow* win,
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            const int w,
+            const int h,
+            const vk::Format format,
+            const MemoryProvider& memoryProvider,
             const char* debugName = "Unnamed");
 
+    static uint32_t getMemoryIndex(
+            VulkanWindow* win,
+            const vk::PhysicalDevice* pd,
+            const uint32_t memoryTypeBits,
+            const bool isLinear);
+
+    static vk::ImageUsageFlags getUsageFlags(const bool isLinear);
+
     const vk::UniqueImage& getImage() const;
     const vk::UniqueImageView& getImageView() const;
-    const vk::UniqueDeviceMemory& getMemory() const;
+    // Empty if the image doesn't own its memory
+    const CsAllocation& getAllocation() const;
 
     vk::ImageLayout getLayout() const;
     void transitionLayoutTo(vk::UniqueCommandBuffer& cb,
@@ -51,15 +80,32 @@ public:
 
     int getWidth() const;
     int getHeight() const;
+    vk::Format getFormat() const;
+    vk::ImageTiling getTiling() const;
+    vk::ImageUsageFlags getUsage() const;
+
+    // The last frame the image was drawn in, it must not
+    // be destroyed before that frame has finished
+    void setLastUse(const uint64_t frame);
+    uint64_t getLastUse() const;
+
+    // The part of the image that holds a result, the rest is undefined
+    void setValidRegion(const QRegion& region);
+    const QRegion& getValidRegion() const;
 
     void destroy();
 
     ~CsImage();
 
 private:
+    void createImage(const bool isLinear, const char* debugName);
+    void createView();
+
+    // Declared first so it is freed after the image has been destroyed
+    CsAllocation mAllocation;
+
     vk::UniqueImage mImage;
     vk::UniqueImageView mView;
-    vk::UniqueDeviceMemory mMemory;
 
     VulkanWindow* mWindow;
     const vk::Device* mDevice;
@@ -69,6 +115,13 @@ private:
 
     const int mWidth;
     const int mHeight;
+    const vk::Format mFormat;
+    vk::ImageTiling mTiling;
+    vk::ImageUsageFlags mUsage;
+
+    uint64_t mLastUse = 0;
+
+    QRegion mValidRegion;
 };
 
 } // end namespace Cascade::Renderer
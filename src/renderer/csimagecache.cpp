@@ -0,0 +1,202 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csimagecache.h"
+
+#include "renderutility.h"
+
+namespace Cascade::Renderer {
+
+CsImageCache::CsImageCache(const uint64_t budget)
+    : mBudget(budget)
+{}
+
+void CsImageCache::setReleaseCallback(ReleaseCallback callback)
+{
+    mReleaseCallback = std::move(callback);
+}
+
+void CsImageCache::setBudget(const uint64_t budget)
+{
+    mBudget = budget;
+
+    evict();
+}
+
+uint64_t CsImageCache::getBudget() const
+{
+    return mBudget;
+}
+
+uint64_t CsImageCache::getUsedMemory() const
+{
+    return mUsedMemory;
+}
+
+void CsImageCache::beginEpoch()
+{
+    mEpoch++;
+
+    evict();
+}
+
+CsImage* CsImageCache::get(const QByteArray& key)
+{
+    auto it = mEntries.find(key);
+    if (it == mEntries.end())
+        return nullptr;
+
+    touch(key);
+
+    return it->second.image.get();
+}
+
+bool CsImageCache::contains(const QByteArray& key) const
+{
+    return mEntries.find(key) != mEntries.end();
+}
+
+bool CsImageCache::hasRoomFor(const uint64_t size) const
+{
+    // Memory that can't be given back right now
+    uint64_t kept = 0;
+    for (auto& [key, entry] : mEntries)
+    {
+        if (entry.epoch == mEpoch || mPinned.count(key))
+            kept += entry.size;
+    }
+
+    return kept + size <= mBudget;
+}
+
+void CsImageCache::insert(const QByteArray& key, std::unique_ptr<CsImage> image)
+{
+    auto it = mEntries.find(key);
+    if (it != mEntries.end())
+    {
+        // The old image may still be on screen, the pool
+        // only hands it out again when the frames are done
+        auto& entry = it->second;
+
+        mUsedMemory -= entry.size;
+        release(std::move(entry.image));
+
+        entry.size  = getMemorySize(image.get());
+        entry.image = std::move(image);
+
+        mUsedMemory += entry.size;
+
+        touch(key);
+        evict();
+
+        return;
+    }
+
+    mLru.push_front(key);
+
+    Entry entry;
+    entry.size        = getMemorySize(image.get());
+    entry.epoch       = mEpoch;
+    entry.lruPosition = mLru.begin();
+    entry.image       = std::move(image);
+
+    mUsedMemory += entry.size;
+
+    mEntries[key] = std::move(entry);
+
+    evict();
+}
+
+void CsImageCache::remove(const QByteArray& key)
+{
+    auto it = mEntries.find(key);
+    if (it == mEntries.end() || mPinned.count(key))
+        return;
+
+    mUsedMemory -= it->second.size;
+    mLru.erase(it->second.lruPosition);
+    release(std::move(it->second.image));
+    mEntries.erase(it);
+}
+
+void CsImageCache::clear()
+{
+    for (auto& [key, entry] : mEntries)
+        release(std::move(entry.image));
+
+    mEntries.clear();
+    mLru.clear();
+    mPinned.clear();
+    mUsedMemory = 0;
+}
+
+void CsImageCache::pin(const QByteArray& key)
+{
+    mPinned.insert(key);
+}
+
+void CsImageCache::unpin(const QByteArray& key)
+{
+    mPinned.erase(key);
+
+    evict();
+}
+
+uint64_t CsImageCache::getMemorySize(const CsImage* image)
+{
+    return static_cast<uint64_t>(image->getWidth()) * image->getHeight() *
+           getBytesPerPixel(image->getFormat());
+}
+
+void CsImageCache::touch(const QByteArray& key)
+{
+    auto& entry = mEntries[key];
+
+    mLru.splice(mLru.begin(), mLru, entry.lruPosition);
+
+    entry.epoch = mEpoch;
+}
+
+void CsImageCache::evict()
+{
+    auto it = mLru.end();
+
+    while (mUsedMemory > mBudget && it != mLru.begin())
+    {
+        --it;
+
+        auto& entry = mEntries[*it];
+
+        if (entry.epoch == mEpoch || mPinned.count(*it))
+            continue;
+
+        mUsedMemory -= entry.size;
+        release(std::move(entry.image));
+        mEntries.erase(*it);
+        it = mLru.erase(it);
+    }
+}
+
+void CsImageCache::release(std::unique_ptr<CsImage> image)
+{
+    if (mReleaseCallback)
+        mReleaseCallback(std::move(image));
+}
+
+} // end namespace Cascade::Renderer
@@ -0,0 +1,107 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSIMAGECACHE_H
+#define CSIMAGECACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <QByteArray>
+
+#include "csimage.h"
+
+namespace Cascade::Renderer {
+
+// Owns the rendered images, keyed by the hash of their render task,
+// and keeps the memory they use below a budget by dropping the
+// images that have not been used for the longest time.
+// Tasks with the same hash share one image.
+class CsImageCache
+{
+public:
+    explicit CsImageCache(const uint64_t budget);
+
+    // Receives the images that are dropped from the cache,
+    // without it they are destroyed
+    using ReleaseCallback = std::function<void(std::unique_ptr<CsImage>)>;
+    void setReleaseCallback(ReleaseCallback callback);
+
+    void setBudget(const uint64_t budget);
+    uint64_t getBudget() const;
+    uint64_t getUsedMemory() const;
+
+    // Images used after this call are not evicted until the next
+    // call, so everything an evaluation needs stays available.
+    void beginEpoch();
+
+    // Returns nullptr if there is no image for the key
+    CsImage* get(const QByteArray& key);
+    bool contains(const QByteArray& key) const;
+
+    // True if an image of the given size can be inserted
+    // without going over the budget, after evicting what can be
+    bool hasRoomFor(const uint64_t size) const;
+
+    // Replaces the image of an existing entry, also a pinned one
+    void insert(const QByteArray& key, std::unique_ptr<CsImage> image);
+    // Pinned entries are kept
+    void remove(const QByteArray& key);
+    void clear();
+
+    // Pinned images are never evicted, e.g. the one on screen
+    void pin(const QByteArray& key);
+    void unpin(const QByteArray& key);
+
+    static uint64_t getMemorySize(const CsImage* image);
+
+private:
+    void touch(const QByteArray& key);
+    void evict();
+    void release(std::unique_ptr<CsImage> image);
+
+    struct Entry
+    {
+        std::unique_ptr<CsImage> image;
+        uint64_t size;
+        uint64_t epoch;
+        std::list<QByteArray>::iterator lruPosition;
+    };
+
+    std::unordered_map<QByteArray, Entry> mEntries;
+
+    // Most recently used first
+    std::list<QByteArray> mLru;
+
+    std::unordered_set<QByteArray> mPinned;
+
+    ReleaseCallback mReleaseCallback;
+
+    uint64_t mBudget;
+    uint64_t mUsedMemory = 0;
+    uint64_t mEpoch = 0;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSIMAGECACHE_H
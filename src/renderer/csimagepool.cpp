@@ -0,0 +1,160 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csimagepool.h"
+
+#include "csimagecache.h"
+
+namespace Cascade::Renderer {
+
+bool CsImagePool::Key::operator==(const Key& other) const
+{
+    return width == other.width &&
+           height == other.height &&
+           format == other.format &&
+           tiling == other.tiling &&
+           usage == other.usage;
+}
+
+CsImagePool::CsImagePool(
+        VulkanWindow* win,
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        const uint64_t budget)
+    : mWindow(win),
+      mDevice(d),
+      mPhysicalDevice(pd),
+      mAllocator(allocator),
+      mBudget(budget)
+{}
+
+std::unique_ptr<CsImage> CsImagePool::acquire(
+        const int width,
+        const int height,
+        const bool isLinear,
+        const vk::Format format,
+        const char* debugName)
+{
+    const Key key {
+        width,
+        height,
+        format,
+        isLinear ? vk::ImageTiling::eLinear : vk::ImageTiling::eOptimal,
+        CsImage::getUsageFlags(isLinear) };
+
+    // Most recently released first, it is the most likely to be done
+    for (auto it = mEntries.rbegin(); it != mEntries.rend(); ++it)
+    {
+        if (isInFlight(*it) || !(it->key == key))
+            continue;
+
+        auto image = std::move(it->image);
+        mPooledMemory -= CsImageCache::getMemorySize(image.get());
+        mEntries.erase(std::next(it).base());
+
+        // What it held before is not a result anymore
+        image->setValidRegion(QRegion());
+
+        return image;
+    }
+
+    return std::make_unique<CsImage>(
+                mWindow,
+                mDevice,
+                mPhysicalDevice,
+                mAllocator,
+                width,
+                height,
+                isLinear,
+                format,
+                debugName);
+}
+
+void CsImagePool::release(std::unique_ptr<CsImage> image)
+{
+    if (!image)
+        return;
+
+    mPooledMemory += CsImageCache::getMemorySize(image.get());
+
+    Entry entry;
+    entry.key   = getKey(image.get());
+    entry.image = std::move(image);
+
+    mEntries.push_back(std::move(entry));
+
+    trim();
+}
+
+void CsImagePool::setCompletedFrame(const uint64_t frame)
+{
+    mCompletedFrame = frame;
+
+    trim();
+}
+
+uint64_t CsImagePool::getPooledMemory() const
+{
+    return mPooledMemory;
+}
+
+int CsImagePool::getNumImages() const
+{
+    return static_cast<int>(mEntries.size());
+}
+
+void CsImagePool::clear()
+{
+    mEntries.clear();
+    mPooledMemory = 0;
+}
+
+CsImagePool::Key CsImagePool::getKey(const CsImage* image)
+{
+    return {
+        image->getWidth(),
+        image->getHeight(),
+        image->getFormat(),
+        image->getTiling(),
+        image->getUsage() };
+}
+
+void CsImagePool::trim()
+{
+    for (auto it = mEntries.begin(); it != mEntries.end() && mPooledMemory > mBudget;)
+    {
+        // Images the GPU may still be using have to wait
+        if (isInFlight(*it))
+        {
+            ++it;
+            continue;
+        }
+
+        mPooledMemory -= CsImageCache::getMemorySize(it->image.get());
+        it = mEntries.erase(it);
+    }
+}
+
+bool CsImagePool::isInFlight(const Entry& entry) const
+{
+    return entry.image->getLastUse() > mCompletedFrame;
+}
+
+} // end namespace Cascade::Renderer
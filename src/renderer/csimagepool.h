@@ -0,0 +1,106 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSIMAGEPOOL_H
+#define CSIMAGEPOOL_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+
+#include "csimage.h"
+
+namespace Cascade::Renderer {
+
+// Keeps render targets that are no longer needed and hands them out
+// again for the next image with the same properties, so re-rendering
+// at the same size doesn't create and destroy images all the time.
+// A released image is only reused or destroyed once the frames it was
+// drawn in have finished on the GPU. The frame is read from the image
+// each time, as it may still be drawn after it was released.
+class CsImagePool
+{
+public:
+    CsImagePool(
+            VulkanWindow* win,
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            const uint64_t budget);
+
+    // A free image with these properties or a new one
+    std::unique_ptr<CsImage> acquire(
+            const int width,
+            const int height,
+            const bool isLinear,
+            const vk::Format format,
+            const char* debugName);
+
+    void release(std::unique_ptr<CsImage> image);
+
+    // All frames up to this one have finished on the GPU
+    void setCompletedFrame(const uint64_t frame);
+
+    // Memory held by the free and the pending images
+    uint64_t getPooledMemory() const;
+    int getNumImages() const;
+
+    void clear();
+
+private:
+    struct Key
+    {
+        int width;
+        int height;
+        vk::Format format;
+        vk::ImageTiling tiling;
+        vk::ImageUsageFlags usage;
+
+        bool operator==(const Key& other) const;
+    };
+
+    static Key getKey(const CsImage* image);
+
+    // Destroys the oldest free images until the pool fits into its budget
+    void trim();
+
+    bool isInFlight(const Entry& entry) const;
+
+    struct Entry
+    {
+        Key key;
+        std::unique_ptr<CsImage> image;
+    };
+
+    // Oldest first
+    std::list<Entry> mEntries;
+
+    VulkanWindow* mWindow;
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mAllocator;
+
+    const uint64_t mBudget;
+    uint64_t mPooledMemory   = 0;
+    uint64_t mCompletedFrame = 0;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSIMAGEPOOL_H
@@ -0,0 +1,301 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csmemoryallocator.h"
+
+#include <algorithm>
+
+#include <QString>
+
+#include "../log.h"
+#include "rangeallocator.h"
+#include "renderconfig.h"
+
+namespace Cascade::Renderer {
+
+struct CsMemoryBlock
+{
+    vk::UniqueDeviceMemory memory;
+    RangeAllocator ranges;
+    uint32_t memoryIndex;
+    bool isLinear;
+    char* mappedData;
+};
+
+CsAllocation::CsAllocation(CsAllocation&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+CsAllocation& CsAllocation::operator=(CsAllocation&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        mAllocator  = other.mAllocator;
+        mBlock      = other.mBlock;
+        mMemory     = other.mMemory;
+        mOffset     = other.mOffset;
+        mSize       = other.mSize;
+        mMappedData = other.mMappedData;
+
+        other.mAllocator = nullptr;
+        other.mBlock     = nullptr;
+    }
+    return *this;
+}
+
+CsAllocation::~CsAllocation()
+{
+    release();
+}
+
+vk::DeviceMemory CsAllocation::getMemory() const
+{
+    return mMemory;
+}
+
+vk::DeviceSize CsAllocation::getOffset() const
+{
+    return mOffset;
+}
+
+vk::DeviceSize CsAllocation::getSize() const
+{
+    return mSize;
+}
+
+void* CsAllocation::getMappedData() const
+{
+    return mMappedData;
+}
+
+CsAllocation::operator bool() const
+{
+    return mBlock != nullptr;
+}
+
+void CsAllocation::release()
+{
+    if (mAllocator && mBlock)
+        mAllocator->free(mBlock, mOffset);
+
+    mAllocator = nullptr;
+    mBlock     = nullptr;
+}
+
+CsMemoryAllocator::CsMemoryAllocator(
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd) :
+    mDevice(d)
+{
+    mMemoryProperties = pd->getMemoryProperties();
+}
+
+CsAllocation CsMemoryAllocator::allocate(
+        const vk::MemoryRequirements& requirements,
+        const uint32_t memoryIndex,
+        const bool isLinear)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    CsAllocation allocation;
+
+    auto tryBlock = [&](CsMemoryBlock* block)
+    {
+        uint64_t offset = 0;
+        if (!block->ranges.allocate(requirements.size, requirements.alignment, offset))
+            return false;
+
+        allocation.mAllocator  = this;
+        allocation.mBlock      = block;
+        allocation.mMemory     = *block->memory;
+        allocation.mOffset     = offset;
+        allocation.mSize       = requirements.size;
+        allocation.mMappedData = block->mappedData ? block->mappedData + offset : nullptr;
+
+        return true;
+    };
+
+    for (auto& block : mBlocks)
+    {
+        if (block->memoryIndex != memoryIndex || block->isLinear != isLinear)
+            continue;
+
+        if (tryBlock(block.get()))
+            return allocation;
+    }
+
+    const vk::DeviceSize blockSize = std::max<vk::DeviceSize>(
+                requirements.size,
+                getBlockSize(memoryIndex));
+
+    if (CsMemoryBlock* block = createBlock(blockSize, memoryIndex, isLinear))
+        tryBlock(block);
+
+    return allocation;
+}
+
+uint32_t CsMemoryAllocator::findMemoryIndex(
+        const uint32_t typeBits,
+        const vk::MemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1 << i)) &&
+            (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+uint32_t CsMemoryAllocator::findMemoryIndex(
+        const uint32_t typeBits,
+        const vk::MemoryPropertyFlags preferred,
+        const vk::MemoryPropertyFlags required) const
+{
+    for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1 << i)) &&
+            (mMemoryProperties.memoryTypes[i].propertyFlags & preferred) == preferred)
+        {
+            return i;
+        }
+    }
+    return findMemoryIndex(typeBits, required);
+}
+
+CsMemoryAllocator::Stats CsMemoryAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    Stats stats;
+
+    uint64_t freeBytes        = 0;
+    uint64_t largestFreeRange = 0;
+
+    for (auto& block : mBlocks)
+    {
+        stats.allocatedBytes += block->ranges.getSize();
+        stats.usedBytes += block->ranges.getUsedSize();
+        stats.numAllocations += block->ranges.getNumAllocations();
+
+        freeBytes += block->ranges.getSize() - block->ranges.getUsedSize();
+        largestFreeRange = std::max(largestFreeRange, block->ranges.getLargestFreeRange());
+    }
+    stats.numBlocks = static_cast<int>(mBlocks.size());
+
+    if (freeBytes > 0)
+        stats.fragmentation = 1.0f - static_cast<float>(largestFreeRange) / freeBytes;
+
+    return stats;
+}
+
+CsMemoryBlock* CsMemoryAllocator::createBlock(
+        const vk::DeviceSize size,
+        const uint32_t memoryIndex,
+        const bool isLinear)
+{
+    vk::MemoryAllocateInfo allocInfo(size, memoryIndex);
+
+    auto memory = mDevice->allocateMemoryUnique(allocInfo);
+    if (memory.result != vk::Result::eSuccess)
+    {
+        CS_LOG_WARNING("Failed to allocate a memory block of " + QString::number(size) + " bytes.");
+        return nullptr;
+    }
+
+    char* mappedData = nullptr;
+
+    // Host visible blocks stay mapped for their whole life
+    if (mMemoryProperties.memoryTypes[memoryIndex].propertyFlags &
+        vk::MemoryPropertyFlagBits::eHostVisible)
+    {
+        auto result = mDevice->mapMemory(
+                    *memory.value,
+                    0,
+                    VK_WHOLE_SIZE,
+                    {},
+                    reinterpret_cast<void**>(&mappedData));
+        if (result != vk::Result::eSuccess)
+            CS_LOG_WARNING("Failed to map memory block.");
+    }
+
+    mBlocks.push_back(std::unique_ptr<CsMemoryBlock>(new CsMemoryBlock {
+                std::move(memory.value),
+                RangeAllocator(size),
+                memoryIndex,
+                isLinear,
+                mappedData }));
+
+    return mBlocks.back().get();
+}
+
+void CsMemoryAllocator::free(CsMemoryBlock* block, const vk::DeviceSize offset)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    block->ranges.free(offset);
+
+    if (!block->ranges.isEmpty())
+        return;
+
+    // Keep one empty block of each kind around, so a single
+    // resource doesn't allocate over and over. Blocks that were
+    // made for one big resource are given back right away.
+    bool isKept = block->ranges.getSize() <= getBlockSize(block->memoryIndex);
+    for (auto& other : mBlocks)
+    {
+        if (other.get() != block &&
+            other->memoryIndex == block->memoryIndex &&
+            other->isLinear == block->isLinear &&
+            other->ranges.isEmpty())
+        {
+            isKept = false;
+        }
+    }
+
+    if (!isKept)
+    {
+        mBlocks.erase(std::find_if(
+            mBlocks.begin(), mBlocks.end(), [block](auto& b) { return b.get() == block; }));
+    }
+}
+
+vk::DeviceSize CsMemoryAllocator::getBlockSize(const uint32_t memoryIndex) const
+{
+    if (mMemoryProperties.memoryTypes[memoryIndex].propertyFlags &
+        vk::MemoryPropertyFlagBits::eHostVisible)
+        return hostVisibleBlockSize;
+
+    return deviceLocalBlockSize;
+}
+
+CsMemoryAllocator::~CsMemoryAllocator()
+{
+    auto stats = getStats();
+
+    CS_LOG_INFO("Destroying memory allocator, " + QString::number(stats.numAllocations) +
+                " allocations left.");
+}
+
+} // namespace Cascade::Renderer
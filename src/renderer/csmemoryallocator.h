@@ -0,0 +1,134 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSMEMORYALLOCATOR_H
+#define CSMEMORYALLOCATOR_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+class CsMemoryAllocator;
+struct CsMemoryBlock;
+
+// A range of device memory, given back to the allocator when destroyed
+class CsAllocation
+{
+public:
+    CsAllocation() = default;
+    CsAllocation(CsAllocation&& other) noexcept;
+    CsAllocation& operator=(CsAllocation&& other) noexcept;
+    CsAllocation(const CsAllocation&) = delete;
+    CsAllocation& operator=(const CsAllocation&) = delete;
+
+    ~CsAllocation();
+
+    vk::DeviceMemory getMemory() const;
+    vk::DeviceSize getOffset() const;
+    vk::DeviceSize getSize() const;
+
+    // Persistently mapped, nullptr if the memory is not host visible
+    void* getMappedData() const;
+
+    explicit operator bool() const;
+
+private:
+    friend class CsMemoryAllocator;
+
+    void release();
+
+    CsMemoryAllocator* mAllocator = nullptr;
+    CsMemoryBlock* mBlock         = nullptr;
+    vk::DeviceMemory mMemory;
+    vk::DeviceSize mOffset        = 0;
+    vk::DeviceSize mSize          = 0;
+    char* mMappedData             = nullptr;
+};
+
+// Sub-allocates images and buffers from a few large memory blocks
+// instead of giving every object its own vkAllocateMemory.
+// Linear resources and optimal images get separate blocks, so the
+// buffer-image granularity never has to be taken into account.
+class CsMemoryAllocator
+{
+public:
+    CsMemoryAllocator(
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd);
+
+    CsAllocation allocate(
+            const vk::MemoryRequirements& requirements,
+            const uint32_t memoryIndex,
+            const bool isLinear);
+
+    // A memory type in typeBits that has all the properties
+    uint32_t findMemoryIndex(
+            const uint32_t typeBits,
+            const vk::MemoryPropertyFlags properties) const;
+
+    // One with the preferred properties if there is any,
+    // otherwise one that has the required ones
+    uint32_t findMemoryIndex(
+            const uint32_t typeBits,
+            const vk::MemoryPropertyFlags preferred,
+            const vk::MemoryPropertyFlags required) const;
+
+    struct Stats
+    {
+        uint64_t allocatedBytes = 0;
+        uint64_t usedBytes      = 0;
+        int numBlocks           = 0;
+        int numAllocations      = 0;
+        // 0 if all free memory is in one range, close to 1
+        // if it is split into many small ones
+        float fragmentation     = 0.0f;
+    };
+
+    Stats getStats() const;
+
+    ~CsMemoryAllocator();
+
+private:
+    friend class CsAllocation;
+
+    CsMemoryBlock* createBlock(
+            const vk::DeviceSize size,
+            const uint32_t memoryIndex,
+            const bool isLinear);
+
+    void free(CsMemoryBlock* block, const vk::DeviceSize offset);
+
+    vk::DeviceSize getBlockSize(const uint32_t memoryIndex) const;
+
+    const vk::Device* mDevice;
+    vk::PhysicalDeviceMemoryProperties mMemoryProperties;
+
+    std::vector<std::unique_ptr<CsMemoryBlock>> mBlocks;
+
+    // Resources are created on the GUI and the render thread
+    mutable std::mutex mMutex;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSMEMORYALLOCATOR_H
@@ -19,23 +19,31 @@
 
 #include "cssettingsbuffer.h"
 
-#include <stdexcept>
-
-#include <QString>
-#include <QStringList>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 #include "../log.h"
+#include "renderconfig.h"
 
 namespace Cascade::Renderer {
 
 CsSettingsBuffer::CsSettingsBuffer(
         vk::Device* d,
-        vk::PhysicalDevice* pd)
+        vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator,
+        const uint32_t numSlots)
 {
     mDevice = d;
     mPhysicalDevice = pd;
+    mNumSlots = numSlots;
+
+    // Dynamic offsets have to be multiples of this
+    const vk::DeviceSize alignment =
+            mPhysicalDevice->getProperties().limits.minUniformBufferOffsetAlignment;
+    mSlotSize = (getRange() + alignment - 1) / alignment * alignment;
 
-    vk::DeviceSize size = sizeof(float) * 128;
+    vk::DeviceSize size = mSlotSize * mNumSlots;
 
     vk::BufferCreateInfo bufferInfo(
                 {},
@@ -50,70 +58,54 @@ CsSettingsBuffer::CsSettingsBuffer(
 
     vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*mBuffer);
 
-    vk::MemoryPropertyFlags properties =
-            vk::MemoryPropertyFlagBits::eHostVisible |
-            vk::MemoryPropertyFlagBits::eHostCoherent;
-
-    vk::PhysicalDeviceMemoryProperties memProperties = mPhysicalDevice->getMemoryProperties();
-
-    uint32_t memTypeIndex = 0;
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-    {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            memTypeIndex = i;
-        }
-    }
+    uint32_t memTypeIndex = allocator->findMemoryIndex(
+                memRequirements.memoryTypeBits,
+                vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent);
 
-    vk::MemoryAllocateInfo allocInfo(
-                memRequirements.size,
-                memTypeIndex);
+    mAllocation = allocator->allocate(memRequirements, memTypeIndex, true);
 
-   mMemory = mDevice->allocateMemoryUnique(allocInfo).value;
+    auto result = mDevice->bindBufferMemory(
+                *mBuffer,
+                mAllocation.getMemory(),
+                mAllocation.getOffset());
+    Q_UNUSED(result);
 
-    auto result = mDevice->bindBufferMemory(*mBuffer, *mMemory, 0);
-
-    result = mDevice->mapMemory(
-                *mMemory,
-                0,
-                VK_WHOLE_SIZE,
-                {},
-                reinterpret_cast<void **>(&mBufferStart));
-    if (result != vk::Result::eSuccess)
+    mBufferStart = static_cast<char*>(mAllocation.getMappedData());
+    if (!mBufferStart)
         CS_LOG_WARNING("Failed to map memory");
 }
 
-void CsSettingsBuffer::fillBuffer(const QString &s)
+static_assert(shaderPassOffset - hasMaskOffset == offsetof(DispatchInfo, shaderPass));
+
+bool CsSettingsBuffer::write(
+        const std::vector<float>& values,
+        const DispatchInfo& info,
+        uint32_t& offset)
 {
-    auto parts = s.split(",");
+    if (mNumUsedSlots == mNumSlots || !mBufferStart)
+        return false;
+
+    if (values.size() > static_cast<size_t>(maxNumSettings))
+        CS_LOG_WARNING("Too many settings, the rest is dropped.");
 
-    float* pBuffer = mBufferStart;
+    offset = static_cast<uint32_t>(mSlotSize * mNumUsedSlots++);
 
-    mBufferSize = 0;
+    const size_t numValues = std::min(values.size(), static_cast<size_t>(maxNumSettings));
+    memcpy(mBufferStart + offset, values.data(), numValues * sizeof(float));
+    memcpy(mBufferStart + offset + hasMaskOffset, &info, sizeof(info));
 
-    foreach(auto& item, parts)
-    {
-        *pBuffer = item.toFloat();
-        pBuffer++;
-        mBufferSize++;
-    }
+    return true;
 }
 
-void CsSettingsBuffer::appendValue(float f)
+void CsSettingsBuffer::reset()
 {
-    float *pBuffer = mBufferStart;
-    pBuffer += mBufferSize;
-    *pBuffer = f;
-    mBufferSize++;
+    mNumUsedSlots = 0;
 }
 
-void CsSettingsBuffer::incrementLastValue()
+vk::DeviceSize CsSettingsBuffer::getRange()
 {
-    float *pBuffer = mBufferStart;
-    pBuffer += mBufferSize - 1;
-    *pBuffer = *pBuffer + 1.0;
+    return sizeof(float) * maxNumSettings + sizeof(DispatchInfo);
 }
 
 vk::UniqueBuffer& CsSettingsBuffer::getBuffer()
@@ -121,9 +113,9 @@ vk::UniqueBuffer& CsSettingsBuffer::getBuffer()
     return mBuffer;
 }
 
-vk::UniqueDeviceMemory& CsSettingsBuffer::getMemory()
+const CsAllocation& CsSettingsBuffer::getAllocation() const
 {
-    return mMemory;
+    return mAllocation;
 }
 
 CsSettingsBuffer::~CsSettingsBuffer()
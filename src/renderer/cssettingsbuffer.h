@@ -20,39 +20,65 @@
 #ifndef CSSETTINGSBUFFER_H
 #define CSSETTINGSBUFFER_H
 
+#include <vector>
+
 #include <QVulkanDeviceFunctions>
 
 #include <vulkan/vulkan.h>
 
+#include "csmemoryallocator.h"
 #include "vulkanhppinclude.h"
 
 namespace Cascade::Renderer {
 
+// What the renderer tells every shader that reads the uniform buffer,
+// after the room for the settings, see hasMaskOffset
+struct DispatchInfo
+{
+    // Whether an image is bound to the front input, most shaders use it as mask
+    float hasMask    = 0.0f;
+    float shaderPass = 0.0f;
+};
+
+// Uniform buffer with the settings of many dispatches, one after another.
+// Each dispatch binds it with the offset of its slot as dynamic offset,
+// so the settings of the passes in flight don't overwrite each other.
 class CsSettingsBuffer
 {
 public:
     CsSettingsBuffer(
             vk::Device* d,
-            vk::PhysicalDevice* pd);
+            vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator,
+            const uint32_t numSlots);
 
-    void fillBuffer(const QString& s);
-    void appendValue(float f);
-    void incrementLastValue();
+    // Copies the values into the next free slot and returns its
+    // offset in the buffer. False if all slots are used.
+    bool write(const std::vector<float>& values, const DispatchInfo& info, uint32_t& offset);
+
+    // All slots are free again, the commands reading them have to be finished
+    void reset();
+
+    // What a shader sees from the offset of its slot on
+    static vk::DeviceSize getRange();
 
     vk::UniqueBuffer& getBuffer();
-    vk::UniqueDeviceMemory& getMemory();
+    const CsAllocation& getAllocation() const;
 
     ~CsSettingsBuffer();
 
 private:
+    CsAllocation mAllocation;
     vk::UniqueBuffer mBuffer;
-    vk::UniqueDeviceMemory mMemory;
 
     vk::Device* mDevice;
     vk::PhysicalDevice* mPhysicalDevice;
 
-    float* mBufferStart;
-    int mBufferSize;
+    char* mBufferStart;
+
+    vk::DeviceSize mSlotSize;
+    uint32_t mNumSlots;
+    uint32_t mNumUsedSlots = 0;
 };
 
 } // end namespace Cascade::Renderer
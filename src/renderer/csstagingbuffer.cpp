@@ -0,0 +1,112 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "csstagingbuffer.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer {
+
+// Offsets of copies to images have to be multiples of the texel size
+static constexpr vk::DeviceSize stagingAlignment = 16;
+
+CsStagingBuffer::CsStagingBuffer(
+        vk::Device* d,
+        CsMemoryAllocator* allocator,
+        const vk::DeviceSize size,
+        const vk::BufferUsageFlags usage)
+    : mDevice(d),
+      mHalfSize(size / 2 / stagingAlignment * stagingAlignment)
+{
+    vk::BufferCreateInfo bufferInfo(
+                {},
+                mHalfSize * 2,
+                usage,
+                vk::SharingMode::eExclusive);
+
+    mBuffer = mDevice->createBufferUnique(bufferInfo).value;
+
+    vk::MemoryRequirements memRequirements = mDevice->getBufferMemoryRequirements(*mBuffer);
+
+    // The pixels are converted in place after decoding,
+    // which reads back what has been written
+    const vk::MemoryPropertyFlags required =
+            vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    uint32_t memTypeIndex = allocator->findMemoryIndex(
+                memRequirements.memoryTypeBits,
+                required | vk::MemoryPropertyFlagBits::eHostCached,
+                required);
+
+    mAllocation = allocator->allocate(memRequirements, memTypeIndex, true);
+    if (!mAllocation)
+    {
+        CS_LOG_WARNING("Could not allocate memory for staging buffer.");
+        return;
+    }
+
+    auto result = mDevice->bindBufferMemory(
+                *mBuffer,
+                mAllocation.getMemory(),
+                mAllocation.getOffset());
+    Q_UNUSED(result);
+
+    mBufferStart = static_cast<char*>(mAllocation.getMappedData());
+    if (!mBufferStart)
+        CS_LOG_WARNING("Failed to map staging buffer.");
+}
+
+char* CsStagingBuffer::allocate(const vk::DeviceSize size, vk::DeviceSize& offset)
+{
+    const vk::DeviceSize start =
+            (mUsed + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+
+    if (!mBufferStart || start + size > mHalfSize)
+        return nullptr;
+
+    mUsed  = start + size;
+    offset = mCurrentHalf * mHalfSize + start;
+
+    return mBufferStart + offset;
+}
+
+void CsStagingBuffer::switchHalf()
+{
+    mCurrentHalf = 1 - mCurrentHalf;
+    mUsed        = 0;
+}
+
+void CsStagingBuffer::reset()
+{
+    mCurrentHalf = 0;
+    mUsed        = 0;
+}
+
+vk::DeviceSize CsStagingBuffer::getHalfSize() const
+{
+    return mHalfSize;
+}
+
+vk::Buffer CsStagingBuffer::getBuffer() const
+{
+    return *mBuffer;
+}
+
+} // end namespace Cascade::Renderer
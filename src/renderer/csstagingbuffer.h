@@ -0,0 +1,70 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSSTAGINGBUFFER_H
+#define CSSTAGINGBUFFER_H
+
+#include "csmemoryallocator.h"
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+// Host visible buffer that stays mapped, for the uploads to the images.
+// It is used in two halves: while the GPU copies from one, the CPU
+// writes the next part of the upload into the other. With eTransferDst
+// usage the images are copied back into it instead.
+class CsStagingBuffer
+{
+public:
+    CsStagingBuffer(
+            vk::Device* d,
+            CsMemoryAllocator* allocator,
+            const vk::DeviceSize size,
+            const vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eTransferSrc);
+
+    // Mapped memory in the current half and its offset in the
+    // buffer, nullptr if there isn't enough space left
+    char* allocate(const vk::DeviceSize size, vk::DeviceSize& offset);
+
+    // Continues in the other half. Copies out of it must have finished.
+    void switchHalf();
+
+    // Empty again, the copies out of both halves must have finished
+    void reset();
+
+    vk::DeviceSize getHalfSize() const;
+
+    vk::Buffer getBuffer() const;
+
+private:
+    CsAllocation mAllocation;
+    vk::UniqueBuffer mBuffer;
+
+    vk::Device* mDevice;
+
+    char* mBufferStart = nullptr;
+
+    vk::DeviceSize mHalfSize;
+    int mCurrentHalf      = 0;
+    vk::DeviceSize mUsed  = 0;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // CSSTAGINGBUFFER_H
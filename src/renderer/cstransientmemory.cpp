@@ -0,0 +1,121 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "cstransientmemory.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer {
+
+CsTransientMemory::CsTransientMemory(
+        VulkanWindow* win,
+        const vk::Device* d,
+        const vk::PhysicalDevice* pd,
+        CsMemoryAllocator* allocator) :
+    mWindow(win),
+    mDevice(d),
+    mPhysicalDevice(pd),
+    mAllocator(allocator)
+{}
+
+std::unique_ptr<CsImage> CsTransientMemory::createImage(
+        const int width,
+        const int height,
+        const vk::Format format,
+        const int firstUse,
+        const int lastUse,
+        const char* debugName)
+{
+    return std::make_unique<CsImage>(
+                mWindow,
+                mDevice,
+                mPhysicalDevice,
+                width,
+                height,
+                format,
+                [this, firstUse, lastUse](const vk::MemoryRequirements& requirements)
+                -> const CsAllocation& { return getBlock(requirements, firstUse, lastUse); },
+                debugName);
+}
+
+const CsAllocation& CsTransientMemory::getBlock(
+        const vk::MemoryRequirements& requirements,
+        const int firstUse,
+        const int lastUse)
+{
+    uint32_t memoryIndex = CsImage::getMemoryIndex(
+                mWindow, mPhysicalDevice, requirements.memoryTypeBits, false);
+
+    // The smallest block that is free by the time the image is needed
+    Block* best = nullptr;
+    for (auto& block : mBlocks)
+    {
+        if (block.lastUse >= firstUse ||
+            block.memoryIndex != memoryIndex ||
+            block.size < requirements.size ||
+            block.allocation.getOffset() % requirements.alignment != 0)
+            continue;
+
+        if (!best || block.size < best->size)
+            best = &block;
+    }
+
+    if (!best)
+    {
+        CsAllocation allocation = mAllocator->allocate(requirements, memoryIndex, false);
+        if (!allocation)
+            return mNoAllocation;
+
+        mBlocks.push_back(
+            { std::move(allocation),
+              requirements.size,
+              memoryIndex,
+              lastUse });
+
+        CS_LOG_INFO("Allocated transient memory block " + QString::number(mBlocks.size()));
+
+        return mBlocks.back().allocation;
+    }
+
+    best->lastUse = lastUse;
+
+    return best->allocation;
+}
+
+void CsTransientMemory::reset()
+{
+    for (auto& block : mBlocks)
+        block.lastUse = -1;
+}
+
+uint64_t CsTransientMemory::getAllocatedMemory() const
+{
+    uint64_t size = 0;
+    for (auto& block : mBlocks)
+        size += block.size;
+
+    return size;
+}
+
+int CsTransientMemory::getNumBlocks() const
+{
+    return static_cast<int>(mBlocks.size());
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,85 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSTRANSIENTMEMORY_H
+#define CSTRANSIENTMEMORY_H
+
+#include <memory>
+#include <vector>
+
+#include "csimage.h"
+
+namespace Cascade::Renderer {
+
+// Device memory for images that only live during one render job.
+// Lifetimes are given as the first and last task of the job using
+// the image, images whose lifetimes don't overlap share a block.
+// Images have to be requested in execution order.
+class CsTransientMemory
+{
+public:
+    CsTransientMemory(
+            VulkanWindow* win,
+            const vk::Device* d,
+            const vk::PhysicalDevice* pd,
+            CsMemoryAllocator* allocator);
+
+    std::unique_ptr<CsImage> createImage(
+            const int width,
+            const int height,
+            const vk::Format format,
+            const int firstUse,
+            const int lastUse,
+            const char* debugName = "Transient Image");
+
+    // Makes all blocks available again, the images
+    // using them must not be used anymore
+    void reset();
+
+    uint64_t getAllocatedMemory() const;
+    int getNumBlocks() const;
+
+private:
+    const CsAllocation& getBlock(
+            const vk::MemoryRequirements& requirements,
+            const int firstUse,
+            const int lastUse);
+
+    struct Block
+    {
+        CsAllocation allocation;
+        vk::DeviceSize size;
+        uint32_t memoryIndex;
+        int lastUse;
+    };
+
+    VulkanWindow* mWindow;
+    const vk::Device* mDevice;
+    const vk::PhysicalDevice* mPhysicalDevice;
+    CsMemoryAllocator* mAllocator;
+
+    std::vector<Block> mBlocks;
+
+    // Handed out when there is no memory left for a new block
+    CsAllocation mNoAllocation;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // CSTRANSIENTMEMORY_H
@@ -0,0 +1,103 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "imageupload.h"
+
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+int getUploadPixelSize(const UploadDepth depth)
+{
+    switch (depth)
+    {
+        case UploadDepth::eUInt8:
+            return 4;
+        case UploadDepth::eUInt16:
+        case UploadDepth::eHalf:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+// Format qualifier of the uploaded image, normalized
+// integers are read as floats between 0 and 1
+static QString getUploadFormatQualifier(const UploadDepth depth)
+{
+    switch (depth)
+    {
+        case UploadDepth::eUInt8:
+            return "rgba8";
+        case UploadDepth::eUInt16:
+            return "rgba16";
+        case UploadDepth::eHalf:
+            return "rgba16f";
+        default:
+            return "rgba32f";
+    }
+}
+
+QString generateReadShader(
+    const UploadDepth depth,
+    const int numChannels,
+    const QString& colorSpaceCode)
+{
+    QString expand;
+    switch (numChannels)
+    {
+        case 1:
+            expand = "    rgba = vec4(rgba.rrr, 1.0);\n";
+            break;
+        case 2:
+            expand = "    rgba = rgba.rrrg;\n";
+            break;
+        case 3:
+            expand = "    rgba.a = 1.0;\n";
+            break;
+        default:
+            break;
+    }
+    if (!colorSpaceCode.isEmpty())
+        expand += "    rgba.rgb = convertColorSpace(rgba.rgb);\n";
+
+    return
+        "#version 430\n"
+        "\n"
+        "layout (local_size_x = " + QString::number(workGroupSize) +
+        ", local_size_y = " + QString::number(workGroupSize) + ") in;\n"
+        "layout (binding = 0, " + getUploadFormatQualifier(depth) +
+        ") uniform readonly image2D inputImage;\n"
+        "layout (binding = 1, rgba32f) uniform readonly image2D inputFront;\n"
+        "layout (binding = 2, rgba32f) uniform image2D resultImage;\n"
+        "\n" +
+        colorSpaceCode +
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    vec4 rgba = imageLoad(inputImage, pixelCoords);\n" +
+        expand +
+        "\n"
+        "    imageStore(resultImage, pixelCoords, rgba);\n"
+        "}\n";
+}
+
+} // namespace Cascade::Renderer
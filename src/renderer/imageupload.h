@@ -0,0 +1,53 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEUPLOAD_H
+#define IMAGEUPLOAD_H
+
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+// Type the pixels of a file are uploaded in, close to how they are
+// stored so that an 8 bit file doesn't take up four times the bandwidth.
+// There are always four channels in the staging memory, the ones the file
+// doesn't have are left out by the stride and filled in by the read shader.
+enum class UploadDepth
+{
+    eUInt8,
+    eUInt16,
+    eHalf,
+    eFloat
+};
+
+int getUploadPixelSize(const UploadDepth depth);
+
+// Turns the uploaded pixels into float, shows gray files as gray
+// and makes the pixels opaque if there is no alpha.
+// colorSpaceCode defines convertColorSpace(), see colorspacelut.h,
+// the colors are converted with it if it is given.
+QString generateReadShader(
+    const UploadDepth depth,
+    const int numChannels,
+    const QString& colorSpaceCode = QString());
+
+} // namespace Cascade::Renderer
+
+#endif // IMAGEUPLOAD_H
@@ -0,0 +1,79 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pipelinecachefile.h"
+
+#include <cstring>
+
+#include <QCryptographicHash>
+
+namespace Cascade::Renderer
+{
+
+// What the files start with, followed by the checksum
+static const QByteArray fileMagic = QByteArrayLiteral("CSPC0001");
+static const int checksumSize     = 20;
+
+// Layout of the header Vulkan puts in front of the data of a pipeline cache
+static const int vkHeaderSize         = 32;
+static const uint32_t vkHeaderVersion = 1;
+
+static uint32_t readUint32(const QByteArray& data, const int offset)
+{
+    uint32_t value = 0;
+    std::memcpy(&value, data.constData() + offset, sizeof(value));
+    return value;
+}
+
+QString getPipelineCacheFileName(const PipelineCacheId& id)
+{
+    return QString("pipelines-%1-%2-%3-%4.bin")
+        .arg(id.vendorId, 4, 16, QChar('0'))
+        .arg(id.deviceId, 4, 16, QChar('0'))
+        .arg(id.driverVersion, 8, 16, QChar('0'))
+        .arg(QString::fromLatin1(id.uuid.toHex()));
+}
+
+QByteArray packPipelineCache(const QByteArray& data)
+{
+    return fileMagic + QCryptographicHash::hash(data, QCryptographicHash::Sha1) + data;
+}
+
+QByteArray unpackPipelineCache(const QByteArray& file, const PipelineCacheId& id)
+{
+    const int start = fileMagic.size() + checksumSize;
+    if (file.size() < start + vkHeaderSize || !file.startsWith(fileMagic))
+        return QByteArray();
+
+    const QByteArray data = file.mid(start);
+    if (QCryptographicHash::hash(data, QCryptographicHash::Sha1) !=
+        file.mid(fileMagic.size(), checksumSize))
+        return QByteArray();
+
+    // The driver would reject these as well, but not all of them do that gracefully
+    const bool matches = readUint32(data, 0) >= static_cast<uint32_t>(vkHeaderSize) &&
+                         readUint32(data, 4) == vkHeaderVersion &&
+                         readUint32(data, 8) == id.vendorId &&
+                         readUint32(data, 12) == id.deviceId &&
+                         data.mid(16, 16) == id.uuid;
+
+    return matches ? data : QByteArray();
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,55 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINECACHEFILE_H
+#define PIPELINECACHEFILE_H
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QString>
+
+namespace Cascade::Renderer
+{
+
+// The device and driver a pipeline cache has been created with
+struct PipelineCacheId
+{
+    uint32_t vendorId      = 0;
+    uint32_t deviceId      = 0;
+    uint32_t driverVersion = 0;
+    // pipelineCacheUUID of the device, 16 bytes
+    QByteArray uuid;
+};
+
+// Name of the file with the pipeline cache of a device,
+// a new driver or device gets a file of its own
+QString getPipelineCacheFileName(const PipelineCacheId& id);
+
+// Puts a checksum in front of the data of a
+// pipeline cache, to notice damaged files
+QByteArray packPipelineCache(const QByteArray& data);
+
+// The data of a pipeline cache written with packPipelineCache(),
+// empty if it is damaged or its header doesn't match the device
+QByteArray unpackPipelineCache(const QByteArray& file, const PipelineCacheId& id);
+
+} // namespace Cascade::Renderer
+
+#endif // PIPELINECACHEFILE_H
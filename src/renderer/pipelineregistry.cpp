@@ -0,0 +1,140 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pipelineregistry.h"
+
+#include <algorithm>
+
+#include "spirvutility.h"
+
+namespace Cascade::Renderer {
+
+PipelineRegistry::PipelineRegistry(ShaderFactory createShader, PipelineFactory createPipeline)
+    : mCreateShader(std::move(createShader)),
+      mCreatePipeline(std::move(createPipeline))
+{}
+
+vk::Pipeline PipelineRegistry::getPipeline(
+        const std::vector<uint32_t>& code,
+        const std::vector<uint32_t>& specialization)
+{
+    const QByteArray key = getShaderKey(code);
+
+    getShader(key, code).isPermanent = true;
+
+    return getPipeline(key, code, specialization);
+}
+
+vk::Pipeline PipelineRegistry::getPipeline(
+        const std::shared_ptr<const std::vector<uint32_t>>& code,
+        const std::vector<uint32_t>& specialization)
+{
+    auto known = mKnownCode.find(code.get());
+    if (known == mKnownCode.end() || known->second.code.lock() != code)
+    {
+        const QByteArray key = getShaderKey(*code);
+
+        getShader(key, *code).owners.push_back(code);
+
+        known = mKnownCode.insert_or_assign(code.get(), KnownCode { code, key }).first;
+    }
+    return getPipeline(known->second.key, *code, specialization);
+}
+
+vk::Pipeline PipelineRegistry::getPipeline(
+        const QByteArray& shaderKey,
+        const std::vector<uint32_t>& code,
+        const std::vector<uint32_t>& specialization)
+{
+    const QByteArray key = getPipelineKey(shaderKey, specialization);
+
+    auto it = mPipelines.find(key);
+    if (it != mPipelines.end())
+        return *it->second.pipeline;
+
+    Pipeline& pipeline = mPipelines[key];
+    pipeline.shaderKey = shaderKey;
+    pipeline.pipeline  = mCreatePipeline(*getShader(shaderKey, code).module, specialization);
+
+    return *pipeline.pipeline;
+}
+
+PipelineRegistry::Shader& PipelineRegistry::getShader(
+        const QByteArray& key,
+        const std::vector<uint32_t>& code)
+{
+    Shader& shader = mShaders[key];
+    if (!shader.module)
+        shader.module = mCreateShader(code);
+
+    return shader;
+}
+
+void PipelineRegistry::purge()
+{
+    for (auto it = mKnownCode.begin(); it != mKnownCode.end();)
+    {
+        if (it->second.code.expired())
+            it = mKnownCode.erase(it);
+        else
+            ++it;
+    }
+
+    for (auto shader = mShaders.begin(); shader != mShaders.end();)
+    {
+        auto& owners = shader->second.owners;
+        owners.erase(
+            std::remove_if(owners.begin(), owners.end(), [](const auto& owner) { return owner.expired(); }),
+            owners.end());
+
+        if (shader->second.isPermanent || !owners.empty())
+        {
+            ++shader;
+            continue;
+        }
+
+        for (auto pipeline = mPipelines.begin(); pipeline != mPipelines.end();)
+        {
+            if (pipeline->second.shaderKey == shader->first)
+                pipeline = mPipelines.erase(pipeline);
+            else
+                ++pipeline;
+        }
+        shader = mShaders.erase(shader);
+    }
+}
+
+int PipelineRegistry::getNumShaders() const
+{
+    return static_cast<int>(mShaders.size());
+}
+
+int PipelineRegistry::getNumPipelines() const
+{
+    return static_cast<int>(mPipelines.size());
+}
+
+void PipelineRegistry::clear()
+{
+    mKnownCode.clear();
+    mPipelines.clear();
+    mShaders.clear();
+}
+
+} // end namespace Cascade::Renderer
@@ -0,0 +1,109 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINEREGISTRY_H
+#define PIPELINEREGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+
+#include "vulkanhppinclude.h"
+
+namespace Cascade::Renderer {
+
+// All compute pipelines of the renderer, each created once for its
+// SPIR-V and specialization constants. Shader modules and pipelines
+// are shared by everything that uses the same code, so re-rendering
+// a node or having several nodes with one shader creates nothing.
+class PipelineRegistry
+{
+public:
+    using ShaderFactory =
+        std::function<vk::UniqueShaderModule(const std::vector<uint32_t>& code)>;
+    using PipelineFactory =
+        std::function<vk::UniquePipeline(
+            const vk::ShaderModule shader,
+            const std::vector<uint32_t>& specialization)>;
+
+    PipelineRegistry(ShaderFactory createShader, PipelineFactory createPipeline);
+
+    // Kept for as long as the registry, for the built-in shaders
+    vk::Pipeline getPipeline(
+            const std::vector<uint32_t>& code,
+            const std::vector<uint32_t>& specialization = {});
+
+    // Kept while one of the owners of code with this content exists,
+    // for the shaders of nodes
+    vk::Pipeline getPipeline(
+            const std::shared_ptr<const std::vector<uint32_t>>& code,
+            const std::vector<uint32_t>& specialization = {});
+
+    // Destroys the pipelines whose code is no longer owned by anything.
+    // Commands that use them must have finished.
+    void purge();
+
+    int getNumShaders() const;
+    int getNumPipelines() const;
+
+    void clear();
+
+private:
+    struct Shader
+    {
+        vk::UniqueShaderModule module;
+        bool isPermanent = false;
+        std::vector<std::weak_ptr<const std::vector<uint32_t>>> owners;
+    };
+
+    struct Pipeline
+    {
+        QByteArray shaderKey;
+        vk::UniquePipeline pipeline;
+    };
+
+    Shader& getShader(const QByteArray& key, const std::vector<uint32_t>& code);
+
+    vk::Pipeline getPipeline(
+            const QByteArray& shaderKey,
+            const std::vector<uint32_t>& code,
+            const std::vector<uint32_t>& specialization);
+
+    ShaderFactory mCreateShader;
+    PipelineFactory mCreatePipeline;
+
+    std::map<QByteArray, Shader> mShaders;
+    std::map<QByteArray, Pipeline> mPipelines;
+
+    // Code that has been seen before doesn't have to be hashed again
+    struct KnownCode
+    {
+        std::weak_ptr<const std::vector<uint32_t>> code;
+        QByteArray key;
+    };
+    std::map<const std::vector<uint32_t>*, KnownCode> mKnownCode;
+};
+
+} // end namespace Cascade::Renderer
+
+#endif // PIPELINEREGISTRY_H
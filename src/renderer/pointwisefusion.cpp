@@ -0,0 +1,203 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pointwisefusion.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <QCryptographicHash>
+#include <QStringList>
+
+namespace Cascade::Renderer
+{
+
+static bool canBeFused(const RenderTask* task)
+{
+    return !task->getPointwiseFunction().isEmpty() && task->getNumShaderPasses() == 1 &&
+           task->getInput(0) && !task->getInput(1);
+}
+
+std::vector<PointwiseChain> findPointwiseChains(
+    const RenderJob& job,
+    const std::function<bool(const RenderTask*)>& hasResult,
+    const std::function<bool(const RenderTask*)>& needsResult,
+    const int maxSettings)
+{
+    auto& tasks = job.getTasks();
+
+    // Task -> the tasks reading it
+    std::unordered_map<const RenderTask*, std::vector<RenderTask*>> readers;
+    for (auto& task : tasks)
+    {
+        for (auto& input : task->getInputs())
+        {
+            if (input)
+                readers[input].push_back(task.get());
+        }
+    }
+
+    auto isFusable = [&hasResult](const RenderTask* task)
+    {
+        return canBeFused(task) && !hasResult(task);
+    };
+
+    std::vector<PointwiseChain> chains;
+    std::unordered_map<const RenderTask*, bool> isInChain;
+
+    for (auto& task : tasks)
+    {
+        if (isInChain[task.get()] || !isFusable(task.get()))
+            continue;
+
+        PointwiseChain chain = { task.get() };
+        int numSettings      = static_cast<int>(task->getSettings().size());
+
+        while (!needsResult(chain.back()))
+        {
+            auto& next = readers[chain.back()];
+            if (next.size() != 1 || !isFusable(next.front()))
+                break;
+
+            const int nextSettings = static_cast<int>(next.front()->getSettings().size());
+            if (numSettings + nextSettings > maxSettings)
+                break;
+
+            chain.push_back(next.front());
+            numSettings += nextSettings;
+        }
+
+        for (auto& t : chain)
+            isInChain[t] = true;
+
+        // A single task is rendered with its own shader
+        if (chain.size() > 1)
+            chains.push_back(std::move(chain));
+    }
+
+    return chains;
+}
+
+QString generateShaderHeader()
+{
+    return
+        "#version 430\n"
+        "\n"
+        "layout (local_size_x = " + QString::number(workGroupSize) +
+        ", local_size_y = " + QString::number(workGroupSize) + ") in;\n"
+        "layout (binding = 0, rgba32f) uniform readonly image2D inputBack;\n"
+        "layout (binding = 1, rgba32f) uniform readonly image2D inputFront;\n"
+        "layout (binding = 2, rgba32f) uniform image2D outputImage;\n"
+        "\n";
+}
+
+QString generateChainCode(const PointwiseChain& chain)
+{
+    const std::vector<float> settings = getFusedSettings(chain);
+    const int numSettings = static_cast<int>(settings.size());
+
+    QString code =
+        QString(usesPushConstants(settings) ? "layout(push_constant) uniform InputBuffer\n"
+                                            : "layout(set = 0, binding = 3) uniform InputBuffer\n") +
+        "{\n"
+        "    vec4 values[" + QString::number(std::max(1, (numSettings + 3) / 4)) + "];\n"
+        "} sb;\n"
+        "\n"
+        "// Where the settings of the function that is called start\n"
+        "int settingsOffset = 0;\n"
+        "\n"
+        "#define setting(i) sb.values[(settingsOffset + (i)) / 4][(settingsOffset + (i)) % 4]\n"
+        "\n";
+
+    // Each distinct function once, renamed so they can live side by side
+    QStringList functions;
+    std::vector<int> calls;
+    for (auto& task : chain)
+    {
+        const QString function = task->getPointwiseFunction();
+
+        int index = functions.indexOf(function);
+        if (index < 0)
+        {
+            index = functions.size();
+            functions.append(function);
+
+            code += "#define apply stage" + QString::number(index) + "\n";
+            code += function + "\n";
+            code += "#undef apply\n\n";
+        }
+        calls.push_back(index);
+    }
+
+    code +=
+        "vec4 applyChain(vec4 pixel)\n"
+        "{\n";
+
+    int offset = 0;
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        code += "    settingsOffset = " + QString::number(offset) + ";\n";
+        code += "    pixel = stage" + QString::number(calls[i]) + "(pixel);\n";
+
+        offset += static_cast<int>(chain[i]->getSettings().size());
+    }
+
+    code +=
+        "    return pixel;\n"
+        "}\n"
+        "\n";
+
+    return code;
+}
+
+QString generateFusedShader(const PointwiseChain& chain)
+{
+    return generateShaderHeader() + generateChainCode(chain) +
+        "void main()\n"
+        "{\n"
+        "    ivec2 pixelCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+        "\n"
+        "    imageStore(outputImage, pixelCoords, applyChain(imageLoad(inputBack, pixelCoords)));\n"
+        "}\n";
+}
+
+QByteArray getFusedSignature(const PointwiseChain& chain)
+{
+    // The settings only go into the shader as offsets
+    return QCryptographicHash::hash(generateFusedShader(chain).toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool usesPushConstants(const std::vector<float>& settings)
+{
+    return settings.size() <= static_cast<size_t>(maxPushConstantSettings);
+}
+
+std::vector<float> getFusedSettings(const PointwiseChain& chain)
+{
+    std::vector<float> settings;
+    for (auto& task : chain)
+    {
+        auto& values = task->getSettings();
+        settings.insert(settings.end(), values.begin(), values.end());
+    }
+
+    return settings;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,73 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef POINTWISEFUSION_H
+#define POINTWISEFUSION_H
+
+#include <functional>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include "renderjob.h"
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+// Tasks that only look at the pixel they write, rendered by one shader
+// that keeps the pixel in registers from one to the next instead of
+// writing an image for each of them. Only the last one gets a result.
+using PointwiseChain = std::vector<RenderTask*>;
+
+// The longest chains in the job. Every task in a chain reads the one before
+// it at its back input and nothing else, and only the next one reads it.
+// Tasks that have a result already are left out, those that need one of
+// their own can only end a chain. The settings of a chain fit maxSettings.
+std::vector<PointwiseChain> findPointwiseChains(
+    const RenderJob& job,
+    const std::function<bool(const RenderTask*)>& hasResult,
+    const std::function<bool(const RenderTask*)>& needsResult,
+    const int maxSettings);
+
+// Start of the generated shaders, with the bindings of the node shaders
+QString generateShaderHeader();
+
+// GLSL of the settings of the chain and of a function vec4 applyChain(vec4 pixel)
+// that calls those of the tasks in order. Tasks with the same function share its code.
+QString generateChainCode(const PointwiseChain& chain);
+
+// Compute shader that renders the chain
+QString generateFusedShader(const PointwiseChain& chain);
+
+// What the shader of a chain is cached by, the same for
+// chains of the same nodes with different settings
+QByteArray getFusedSignature(const PointwiseChain& chain);
+
+// The settings of the tasks one after another, as the shader reads them
+std::vector<float> getFusedSettings(const PointwiseChain& chain);
+
+// Whether a generated shader reads these settings from push constants
+// instead of the uniform buffer, see maxPushConstantSettings
+bool usesPushConstants(const std::vector<float>& settings);
+
+} // namespace Cascade::Renderer
+
+#endif // POINTWISEFUSION_H
@@ -0,0 +1,160 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rangeallocator.h"
+
+namespace Cascade::Renderer {
+
+RangeAllocator::RangeAllocator(const uint64_t size)
+    : mSize(size)
+{
+    addFreeRange(0, size);
+}
+
+bool RangeAllocator::allocate(const uint64_t size, const uint64_t alignment, uint64_t& offset)
+{
+    if (size == 0)
+        return false;
+
+    const uint64_t align = alignment > 0 ? alignment : 1;
+
+    for (auto it = mFreeBySize.lower_bound(size); it != mFreeBySize.end(); ++it)
+    {
+        const uint64_t rangeSize   = it->first;
+        const uint64_t rangeOffset = it->second;
+
+        const uint64_t aligned = (rangeOffset + align - 1) / align * align;
+        const uint64_t padding = aligned - rangeOffset;
+
+        if (padding + size > rangeSize)
+            continue;
+
+        removeFreeRange(rangeOffset);
+
+        // Give back what is left on both sides
+        if (padding > 0)
+            addFreeRange(rangeOffset, padding);
+        if (padding + size < rangeSize)
+            addFreeRange(aligned + size, rangeSize - padding - size);
+
+        mAllocations[aligned] = size;
+        mUsedSize += size;
+
+        offset = aligned;
+
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::free(const uint64_t offset)
+{
+    auto it = mAllocations.find(offset);
+    if (it == mAllocations.end())
+        return;
+
+    const uint64_t size = it->second;
+
+    mAllocations.erase(it);
+    mUsedSize -= size;
+
+    addFreeRange(offset, size);
+}
+
+uint64_t RangeAllocator::getSize() const
+{
+    return mSize;
+}
+
+uint64_t RangeAllocator::getUsedSize() const
+{
+    return mUsedSize;
+}
+
+uint64_t RangeAllocator::getLargestFreeRange() const
+{
+    if (mFreeBySize.empty())
+        return 0;
+
+    return mFreeBySize.rbegin()->first;
+}
+
+int RangeAllocator::getNumFreeRanges() const
+{
+    return static_cast<int>(mFreeByOffset.size());
+}
+
+int RangeAllocator::getNumAllocations() const
+{
+    return static_cast<int>(mAllocations.size());
+}
+
+bool RangeAllocator::isEmpty() const
+{
+    return mAllocations.empty();
+}
+
+void RangeAllocator::addFreeRange(uint64_t offset, uint64_t size)
+{
+    // Merge with the free range after this one
+    auto next = mFreeByOffset.find(offset + size);
+    if (next != mFreeByOffset.end())
+    {
+        size += next->second;
+        removeFreeRange(next->first);
+    }
+
+    // And with the one before
+    auto prev = mFreeByOffset.lower_bound(offset);
+    if (prev != mFreeByOffset.begin())
+    {
+        --prev;
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            removeFreeRange(prev->first);
+        }
+    }
+
+    mFreeByOffset[offset] = size;
+    mFreeBySize.insert({ size, offset });
+}
+
+void RangeAllocator::removeFreeRange(const uint64_t offset)
+{
+    auto it = mFreeByOffset.find(offset);
+    if (it == mFreeByOffset.end())
+        return;
+
+    auto range = mFreeBySize.equal_range(it->second);
+    for (auto s = range.first; s != range.second; ++s)
+    {
+        if (s->second == offset)
+        {
+            mFreeBySize.erase(s);
+            break;
+        }
+    }
+
+    mFreeByOffset.erase(it);
+}
+
+} // namespace Cascade::Renderer
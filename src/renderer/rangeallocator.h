@@ -0,0 +1,66 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RANGEALLOCATOR_H
+#define RANGEALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+
+namespace Cascade::Renderer {
+
+// Hands out ranges of a block of a fixed size. Uses the smallest
+// free range an allocation fits in and merges neighbouring free
+// ranges when an allocation is freed.
+class RangeAllocator
+{
+public:
+    explicit RangeAllocator(const uint64_t size);
+
+    // Returns false if no free range is big enough
+    bool allocate(const uint64_t size, const uint64_t alignment, uint64_t& offset);
+
+    // Takes the offset returned by allocate()
+    void free(const uint64_t offset);
+
+    uint64_t getSize() const;
+    uint64_t getUsedSize() const;
+    uint64_t getLargestFreeRange() const;
+    int getNumFreeRanges() const;
+    int getNumAllocations() const;
+    bool isEmpty() const;
+
+private:
+    void addFreeRange(uint64_t offset, uint64_t size);
+    void removeFreeRange(const uint64_t offset);
+
+    const uint64_t mSize;
+    uint64_t mUsedSize = 0;
+
+    // Offset -> size
+    std::map<uint64_t, uint64_t> mFreeByOffset;
+    // Size -> offset, for finding the best fit
+    std::multimap<uint64_t, uint64_t> mFreeBySize;
+    // Offset -> size
+    std::map<uint64_t, uint64_t> mAllocations;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RANGEALLOCATOR_H
@@ -0,0 +1,51 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+namespace Cascade::Renderer
+{
+
+class RenderJob;
+class RenderTask;
+class RenderTaskRead;
+
+// Interface the render tasks use to get their work done on the GPU.
+// Kept free of any Vulkan types so the node graph does not depend on them.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual bool processReadTask(RenderTaskRead* task) = 0;
+
+    virtual bool processTask(RenderTask* task) = 0;
+
+    // Called from the render thread before the tasks of a job are executed
+    virtual void beginEvaluation(const RenderJob& job) = 0;
+
+    // Called after the tasks of a job, also if it has been cancelled.
+    // The results are only complete after this returns.
+    virtual bool endEvaluation() = 0;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERBACKEND_H
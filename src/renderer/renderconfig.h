@@ -47,6 +47,50 @@ inline const vk::ClearColorValue clearColor(std::array<float, 4>({ 0.05f, 0.05f,
 
 inline constexpr int uniformDataSize = 16 * sizeof(float);
 
+// Number of values the settings buffer of a shader holds
+inline constexpr int maxNumSettings = 128;
+
+// Where the shaders find the values of DispatchInfo in the
+// uniform buffer, the same for all of them
+inline constexpr int hasMaskOffset    = maxNumSettings * sizeof(float);
+inline constexpr int shaderPassOffset = hasMaskOffset + sizeof(float);
+
+// Dispatches whose settings share one uniform buffer
+inline constexpr uint32_t settingsSlotsPerBuffer = 64;
+
+// Size of the buffer the images are uploaded through. Bigger
+// images are uploaded in parts of half of it at a time.
+inline constexpr uint64_t stagingBufferSize = 32ull * 1024 * 1024;
+
+// Size of the buffer small images are read back through
+// along with the submission of a job
+inline constexpr uint64_t readbackBufferSize = 2ull * 1024 * 1024;
+
+// Memory the rendered node images may use if there is no preference for it
+inline constexpr uint64_t defaultImageCacheBudget = 2048ull * 1024 * 1024;
+
+// Memory the unused render targets kept for reuse may take up
+inline constexpr uint64_t imagePoolBudget = 512ull * 1024 * 1024;
+
+// Size of the blocks the device memory is sub-allocated from.
+// Bigger allocations get a block of their own.
+inline constexpr uint64_t deviceLocalBlockSize = 256ull * 1024 * 1024;
+inline constexpr uint64_t hostVisibleBlockSize = 64ull * 1024 * 1024;
+
+// Time a proxy render while dragging should take if there is no
+// preference for it, the automatic scale is chosen to stay below
+inline constexpr int defaultProxyFrameTime = 40;
+
+// Where the pipeline cache is kept between sessions
+inline const QString pipelineCacheDir = "cache";
+
+// Smallest fraction of the full resolution proxies are rendered at
+inline constexpr float minProxyScale = 0.125f;
+
+// A tile may take up this fraction of the device memory. A job holds
+// the results of several nodes, the staging images and the cache.
+inline constexpr int tileMemoryDivisor = 16;
+
 inline const std::unordered_map<int, QString> colorSpaces =
 {
     { 0, "sRGB" },
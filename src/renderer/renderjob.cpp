@@ -0,0 +1,189 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "renderjob.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace Cascade::Renderer
+{
+
+RenderJob::RenderJob(const QString& target, const float proxyScale)
+    : mTarget(target)
+    , mProxyScale(proxyScale)
+{}
+
+void RenderJob::addTask(const RenderTask* task)
+{
+    auto copy = task->clone();
+
+    const int index = static_cast<int>(mTasks.size());
+
+    std::vector<RenderTask*> inputs;
+    for (auto& input : copy->getInputs())
+    {
+        auto it = mCopies.find(input);
+        if (it != mCopies.end())
+        {
+            inputs.push_back(it->second);
+            mLastUses.at(mIndices.at(it->second)) = index;
+        }
+        else
+        {
+            inputs.push_back(nullptr);
+        }
+    }
+    copy->setInputs(inputs);
+    copy->setProxyScale(mProxyScale);
+
+    mCopies[task]        = copy.get();
+    mIndices[copy.get()] = index;
+    mLastUses.push_back(index);
+    mTasks.push_back(std::move(copy));
+}
+
+const QString& RenderJob::getTarget() const
+{
+    return mTarget;
+}
+
+float RenderJob::getProxyScale() const
+{
+    return mProxyScale;
+}
+
+const std::vector<std::unique_ptr<RenderTask>>& RenderJob::getTasks() const
+{
+    return mTasks;
+}
+
+RenderTask* RenderJob::getResult() const
+{
+    if (mTasks.empty())
+        return nullptr;
+
+    return mTasks.back().get();
+}
+
+int RenderJob::getIndex(const RenderTask* task) const
+{
+    auto it = mIndices.find(task);
+    if (it == mIndices.end())
+        return -1;
+
+    return it->second;
+}
+
+int RenderJob::getLastUse(const RenderTask* task) const
+{
+    int index = getIndex(task);
+    if (index < 0)
+        return -1;
+
+    return mLastUses.at(index);
+}
+
+void RenderJob::setRegion(const QRectF& region)
+{
+    if (mTasks.empty())
+        return;
+
+    // Unset until a task downstream reads the result
+    std::vector<std::optional<QRectF>> regions(mTasks.size());
+    regions.back() = region;
+
+    for (int i = static_cast<int>(mTasks.size()) - 1; i >= 0; --i)
+    {
+        auto& task = mTasks[i];
+
+        const QRectF taskRegion = regions[i].value_or(QRectF());
+        task->setRegion(taskRegion);
+
+        // Every pass renders whole work groups and reads a margin around
+        // them. Both are in pixels of the proxy.
+        const qreal margin = task->getNumShaderPasses() *
+                             (task->getInputMargin() + workGroupSize) / task->getProxyScale();
+
+        for (auto& input : task->getInputs())
+        {
+            if (!input)
+                continue;
+
+            auto& inputRegion = regions.at(mIndices.at(input));
+
+            if (taskRegion.isNull() || (inputRegion && inputRegion->isNull()))
+            {
+                inputRegion = QRectF();
+                continue;
+            }
+
+            const QRectF needed = taskRegion.adjusted(-margin, -margin, margin, margin);
+            inputRegion = inputRegion ? inputRegion->united(needed) : needed;
+        }
+    }
+}
+
+void RenderJob::setTile(const QRect& tile)
+{
+    for (auto& task : mTasks)
+        task->setTile(tile);
+}
+
+int RenderJob::getHalo() const
+{
+    if (mTasks.empty())
+        return 0;
+
+    // How far around the result each task is read
+    std::vector<int> halos(mTasks.size(), 0);
+
+    int halo = 0;
+    for (int i = static_cast<int>(mTasks.size()) - 1; i >= 0; --i)
+    {
+        auto& task = mTasks[i];
+
+        const int reach = halos[i] + task->getNumShaderPasses() * task->getInputMargin();
+        halo = std::max(halo, reach);
+
+        for (auto& input : task->getInputs())
+        {
+            if (!input)
+                continue;
+
+            int& inputHalo = halos.at(mIndices.at(input));
+            inputHalo      = std::max(inputHalo, reach);
+        }
+    }
+
+    return halo;
+}
+
+void RenderJob::setFinishedCallback(std::function<void(RenderTask*)> callback)
+{
+    mFinishedCallback = std::move(callback);
+}
+
+void RenderJob::finish(const bool success)
+{
+    if (mFinishedCallback)
+        mFinishedCallback(success ? getResult() : nullptr);
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,104 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERJOB_H
+#define RENDERJOB_H
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QRectF>
+#include <QString>
+
+#include "rendertask.h"
+
+namespace Cascade::Renderer
+{
+
+// A snapshot of the render tasks needed for one result, executed
+// on the render thread in the order they were added.
+class RenderJob
+{
+public:
+    // A newer job for the same target replaces this one.
+    // With a proxy scale below 1 the tasks render a preview
+    // at that fraction of the full resolution.
+    explicit RenderJob(const QString& target, const float proxyScale = 1.0f);
+
+    // Adds a copy of the task with its inputs pointing to the
+    // copies in this job, so inputs have to be added first
+    void addTask(const RenderTask* task);
+
+    const QString& getTarget() const;
+
+    float getProxyScale() const;
+
+    const std::vector<std::unique_ptr<RenderTask>>& getTasks() const;
+
+    // The task added last, nullptr if the job is empty
+    RenderTask* getResult() const;
+
+    // Position of a task in the job, -1 if it is not part of it
+    int getIndex(const RenderTask* task) const;
+
+    // Index of the last task that reads the result of the given one,
+    // its own index if nothing in the job reads it
+    int getLastUse(const RenderTask* task) const;
+
+    // Only this part of the result is needed, see RenderTask::setRegion().
+    // The tasks upstream get the parts they need for it.
+    // Has to be called after all tasks have been added.
+    void setRegion(const QRectF& region);
+
+    // Renders only a tile of the images, see RenderTask::setTile().
+    // Has to be called after all tasks have been added.
+    void setTile(const QRect& tile);
+
+    // How far around a pixel of the result the pixels of the sources
+    // are read, what has to be around a tile for it to be correct
+    int getHalo() const;
+
+    void setFinishedCallback(std::function<void(RenderTask*)> callback);
+
+    // Called when all tasks have been executed. If one of
+    // them failed, the callback gets nullptr as the result.
+    void finish(const bool success);
+
+private:
+    QString mTarget;
+
+    float mProxyScale;
+
+    std::vector<std::unique_ptr<RenderTask>> mTasks;
+
+    // Original task -> copy in this job
+    std::unordered_map<const RenderTask*, RenderTask*> mCopies;
+
+    // Copy -> position in mTasks
+    std::unordered_map<const RenderTask*, int> mIndices;
+    std::vector<int> mLastUses;
+
+    std::function<void(RenderTask*)> mFinishedCallback;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERJOB_H
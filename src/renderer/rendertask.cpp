@@ -19,9 +19,219 @@
 
 #include "rendertask.h"
 
+#include <cmath>
+
+#include <QCryptographicHash>
+
 namespace Cascade::Renderer
 {
 
+RenderBackend* RenderTask::sBackend = nullptr;
+
 RenderTask::RenderTask() {}
 
+void RenderTask::setInputs(const std::vector<RenderTask*>& inputs)
+{
+    mInputs = inputs;
+}
+
+const std::vector<RenderTask*>& RenderTask::getInputs() const
+{
+    return mInputs;
+}
+
+RenderTask* RenderTask::getInput(const int index) const
+{
+    if (index < 0 || index >= static_cast<int>(mInputs.size()))
+        return nullptr;
+
+    return mInputs[index];
+}
+
+void RenderTask::setPrecision(const ImagePrecision precision)
+{
+    mPrecision = precision;
+}
+
+ImagePrecision RenderTask::getPrecision() const
+{
+    return mPrecision;
+}
+
+void RenderTask::updateHash(const QString& type, const std::vector<PropertyData*>& data)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(type.toUtf8());
+    hash.addData(QByteArray::number(static_cast<int>(mPrecision)) + ':');
+
+    // Prefix the values with their size so that different
+    // values can't end up as the same sequence of bytes
+    for (auto& d : data)
+    {
+        auto bytes = d->serialize();
+        hash.addData(QByteArray::number(bytes.size()) + ':');
+        hash.addData(bytes);
+    }
+
+    for (auto& input : mInputs)
+    {
+        hash.addData(input ? input->getHash() : QByteArray("-"));
+    }
+
+    mFullHash = hash.result();
+    mHash     = mFullHash;
+
+    mProxyScale = 1.0f;
+    mTile       = QRect();
+}
+
+void RenderTask::addToHash(const QByteArray& data)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(mFullHash);
+    hash.addData(QByteArray::number(data.size()) + ':');
+    hash.addData(data);
+
+    mFullHash = hash.result();
+    mHash     = mFullHash;
+
+    mProxyScale = 1.0f;
+    mTile       = QRect();
+}
+
+const QByteArray& RenderTask::getHash() const
+{
+    return mHash;
+}
+
+void RenderTask::setProxyScale(const float scale)
+{
+    if (scale == mProxyScale)
+        return;
+
+    for (auto index : mPixelSettings)
+    {
+        if (index >= 0 && index < static_cast<int>(mSettings.size()))
+            mSettings[index] *= scale / mProxyScale;
+    }
+    mProxyScale = scale;
+
+    updateDerivedHash();
+}
+
+float RenderTask::getProxyScale() const
+{
+    return mProxyScale;
+}
+
+void RenderTask::setRegion(const QRectF& region)
+{
+    mRegion = region;
+}
+
+const QRectF& RenderTask::getRegion() const
+{
+    return mRegion;
+}
+
+int RenderTask::getInputMargin() const
+{
+    return 0;
+}
+
+QString RenderTask::getPointwiseFunction() const
+{
+    return QString();
+}
+
+bool RenderTask::isColorTransform() const
+{
+    return false;
+}
+
+void RenderTask::setTile(const QRect& tile)
+{
+    mTile = tile;
+
+    updateDerivedHash();
+}
+
+const QRect& RenderTask::getTile() const
+{
+    return mTile;
+}
+
+void RenderTask::updateDerivedHash()
+{
+    if (mProxyScale == 1.0f && mTile.isNull())
+    {
+        mHash = mFullHash;
+        return;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(mFullHash);
+    hash.addData("proxy:" + QByteArray::number(mProxyScale));
+
+    if (!mTile.isNull())
+    {
+        hash.addData(QString("tile:%1,%2,%3,%4")
+                         .arg(mTile.x())
+                         .arg(mTile.y())
+                         .arg(mTile.width())
+                         .arg(mTile.height())
+                         .toUtf8());
+    }
+
+    mHash = hash.result();
+}
+
+QString RenderTask::getShaderPath() const
+{
+    return ":/shaders/noop_comp.spv";
+}
+
+std::shared_ptr<const std::vector<uint32_t>> RenderTask::getShaderCode() const
+{
+    return nullptr;
+}
+
+int RenderTask::getNumShaderPasses() const
+{
+    return 1;
+}
+
+const std::vector<float>& RenderTask::getSettings() const
+{
+    return mSettings;
+}
+
+std::vector<uint32_t> RenderTask::getSpecialization() const
+{
+    std::vector<uint32_t> values;
+    values.reserve(mSpecializedSettings.size());
+
+    for (auto index : mSpecializedSettings)
+    {
+        int32_t value = 0;
+        if (index >= 0 && index < static_cast<int>(mSettings.size()))
+            value = static_cast<int32_t>(std::lround(mSettings[index]));
+
+        values.push_back(static_cast<uint32_t>(value));
+    }
+    return values;
+}
+
+void RenderTask::setBackend(RenderBackend* backend)
+{
+    sBackend = backend;
+}
+
+RenderBackend* RenderTask::getBackend()
+{
+    return sBackend;
+}
+
 } // namespace Cascade::Renderer
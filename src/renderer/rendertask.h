@@ -20,23 +20,154 @@
 #ifndef RENDERTASK_H
 #define RENDERTASK_H
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+#include <QByteArray>
+#include <QRect>
+#include <QRectF>
+#include <QString>
+
 #include "../properties/propertydata.h"
+#include "renderbackend.h"
 
 using Cascade::Properties::PropertyData;
 
 namespace Cascade::Renderer
 {
 
+// Width and height of the work groups of the compute shaders.
+// Results are always rendered in whole groups.
+inline constexpr int workGroupSize = 16;
+
+// Settings that fit into the 128 bytes of push constants every
+// device has. Generated shaders with no more read them from there.
+inline constexpr int maxPushConstantSettings = 32;
+
+// How precisely the result of a task is stored
+enum class ImagePrecision
+{
+    eDefault, // What the renderer is set to
+    eHalf,    // RGBA, 16 bit float
+    eFull,    // RGBA, 32 bit float
+    eMask     // One channel, 16 bit float
+};
+
 class RenderTask
 {
 public:
     RenderTask();
 
+    virtual ~RenderTask() = default;
+
+    // A copy that can be executed on the render thread while
+    // the original is prepared for the next render
+    virtual std::unique_ptr<RenderTask> clone() const = 0;
+
     virtual void initialize(std::vector<PropertyData*> data) = 0;
 
-    virtual void execute() = 0;
+    // Returns false if the task could not produce a result
+    virtual bool execute() = 0;
+
+    // Results of the upstream tasks, one per input port.
+    // Unconnected ports are nullptr.
+    void setInputs(const std::vector<RenderTask*>& inputs);
+    const std::vector<RenderTask*>& getInputs() const;
+    RenderTask* getInput(const int index) const;
+
+    // Nodes that need more or less than the default set it here
+    void setPrecision(const ImagePrecision precision);
+    ImagePrecision getPrecision() const;
+
+    // Identifies the result by what goes into it: the node type, the property
+    // values, the precision and the hashes of the inputs.
+    // Has to be called after setInputs() and setPrecision().
+    void updateHash(const QString& type, const std::vector<PropertyData*>& data);
+    const QByteArray& getHash() const;
+
+    // Renders at a fraction of the full resolution, 1 is the full image.
+    // The settings that are distances in pixels are scaled along and
+    // the result gets a hash of its own.
+    void setProxyScale(const float scale);
+    float getProxyScale() const;
+
+    // The part of the result that is needed, in pixels of the full
+    // resolution image relative to its center. Null if it is all needed.
+    void setRegion(const QRectF& region);
+    const QRectF& getRegion() const;
+
+    // How far around a pixel each pass of the shader reads its input
+    virtual int getInputMargin() const;
+
+    // Nodes that only look at the pixel they write return the GLSL of a
+    // function vec4 apply(vec4 pixel) here, which reads its settings with
+    // setting(i). Chains of them are rendered by one shader, see
+    // pointwisefusion.h. Empty for the others.
+    virtual QString getPointwiseFunction() const;
+
+    // Whether the pointwise function maps each color to another one, with
+    // the alpha and the position making no difference. Chains of them
+    // can be baked into a 3D LUT, see colorlut.h.
+    virtual bool isColorTransform() const;
+
+    // Renders only this part of the full image, for images that are too big
+    // to be rendered at once. Null for the whole image.
+    void setTile(const QRect& tile);
+    const QRect& getTile() const;
+
+    virtual QString getShaderPath() const;
+    // Nodes with shader code of their own, like GLSL and ISF nodes, return
+    // it here instead of a shader path. Tasks and nodes that share the code
+    // share the pipeline, which lives as long as the code.
+    virtual std::shared_ptr<const std::vector<uint32_t>> getShaderCode() const;
+    virtual int getNumShaderPasses() const;
+
+    // Values for the uniform buffer of the shader
+    const std::vector<float>& getSettings() const;
+
+    // The settings that are specialization constants, for the constant ids
+    // 0, 1, 2... of the shader, which declares them as int. Each combination
+    // of values gets a pipeline of its own, so modes and fixed loop counts
+    // don't cost a branch per pixel.
+    std::vector<uint32_t> getSpecialization() const;
+
+    static void setBackend(RenderBackend* backend);
+    static RenderBackend* getBackend();
+
+protected:
+    // For what the property values don't tell, like the state of a file
+    // the task reads. Called from initialize(), after updateHash().
+    void addToHash(const QByteArray& data);
+
+    std::vector<RenderTask*> mInputs;
+
+    std::vector<float> mSettings;
+
+    // Indices of the settings that are measured in pixels
+    std::vector<int> mPixelSettings;
+
+    // Indices of the settings that are specialization constants, in the
+    // order of their constant ids. They stay in the uniform buffer as well.
+    std::vector<int> mSpecializedSettings;
+
+    ImagePrecision mPrecision = ImagePrecision::eDefault;
+
+    float mProxyScale = 1.0f;
+
+    QRectF mRegion;
+
+    QRect mTile;
+
+    QByteArray mHash;
+    // The hash of the full resolution result
+    QByteArray mFullHash;
+
+private:
+    // Derives the hash of a proxy or a tile from the full one
+    void updateDerivedHash();
+
+    static RenderBackend* sBackend;
 };
 
 } // namespace Cascade::Renderer
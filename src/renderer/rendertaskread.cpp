@@ -1,17 +1,83 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
 #include "rendertaskread.h"
 
-#include "../log.h"
+#include <QFileInfo>
+
+using Cascade::Properties::FilesPropertyData;
 
 namespace Cascade::Renderer
 {
 
 RenderTaskRead::RenderTaskRead() {}
 
-void RenderTaskRead::initialize( [[maybe_unused]] std::vector<PropertyData*> data) {}
+std::unique_ptr<RenderTask> RenderTaskRead::clone() const
+{
+    return std::make_unique<RenderTaskRead>(*this);
+}
+
+void RenderTaskRead::initialize(std::vector<PropertyData*> data)
+{
+    mPath.clear();
+
+    for (auto& d : data)
+    {
+        if (auto files = dynamic_cast<FilesPropertyData*>(d))
+        {
+            auto list = files->getFiles()->stringList();
+            if (!list.isEmpty())
+                mPath = list.first();
+        }
+    }
+
+    // A file that was written again under the same name
+    // is not the same image
+    if (!mPath.isEmpty())
+    {
+        QFileInfo info(mPath);
+        addToHash(QByteArray::number(info.size()) + ':' +
+                  QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    }
+}
+
+bool RenderTaskRead::execute()
+{
+    if (mPath.isEmpty() || !getBackend())
+        return false;
+
+    return getBackend()->processReadTask(this);
+}
+
+QString RenderTaskRead::getShaderPath() const
+{
+    return ":/shaders/read_comp.spv";
+}
+
+const QString& RenderTaskRead::getPath() const
+{
+    return mPath;
+}
 
-void RenderTaskRead::execute()
+int RenderTaskRead::getColorSpace() const
 {
-    CS_LOG_INFO("Exec");
+    return mColorSpace;
 }
 
 } // namespace Cascade::Renderer
@@ -1,3 +1,22 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
 #ifndef RENDERTASKREAD_H
 #define RENDERTASKREAD_H
 
@@ -11,9 +30,23 @@ class RenderTaskRead : public RenderTask
 public:
     RenderTaskRead();
 
+    std::unique_ptr<RenderTask> clone() const override;
+
     void initialize(std::vector<PropertyData*> data) override;
 
-    void execute() override;
+    bool execute() override;
+
+    QString getShaderPath() const override;
+
+    // The file to load, empty if there is none
+    const QString& getPath() const;
+
+    int getColorSpace() const;
+
+private:
+    QString mPath;
+
+    int mColorSpace = 0;
 };
 
 } // namespace Cascade::Renderer
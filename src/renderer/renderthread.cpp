@@ -0,0 +1,135 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "renderthread.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer
+{
+
+RenderThread::RenderThread(RenderBackend* backend, QObject* parent)
+    : QThread(parent)
+    , mBackend(backend)
+{}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+void RenderThread::submit(std::unique_ptr<RenderJob> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mStopped)
+            return;
+
+        for (auto it = mJobs.begin(); it != mJobs.end();)
+        {
+            if ((*it)->getTarget() == job->getTarget())
+                it = mJobs.erase(it);
+            else
+                ++it;
+        }
+        mJobs.push_back(std::move(job));
+    }
+    mCondition.notify_one();
+}
+
+void RenderThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mStopped = true;
+        mJobs.clear();
+    }
+    mCondition.notify_one();
+
+    wait();
+}
+
+void RenderThread::run()
+{
+    while (true)
+    {
+        std::unique_ptr<RenderJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+
+            mCondition.wait(lock, [this]() { return mStopped || !mJobs.empty(); });
+
+            if (mStopped)
+                return;
+
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        mBackend->beginEvaluation(*job);
+
+        bool cancelled = false;
+        bool success   = true;
+        for (auto& task : job->getTasks())
+        {
+            // Tasks are the boundary at which a stale job is given up
+            if (isCancelled(*job))
+            {
+                cancelled = true;
+                break;
+            }
+
+            // Everything downstream would read a missing result
+            if (!task->execute())
+            {
+                CS_LOG_WARNING("Render task failed, stopping job " + job->getTarget());
+                success = false;
+                break;
+            }
+        }
+
+        // What has been recorded so far has to be finished either way
+        if (!mBackend->endEvaluation())
+            success = false;
+
+        // Even if a newer job is waiting, a finished
+        // result is better than keeping the old one
+        if (!cancelled)
+            job->finish(success);
+    }
+}
+
+bool RenderThread::isCancelled(const RenderJob& job)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mStopped)
+        return true;
+
+    for (auto& queued : mJobs)
+    {
+        if (queued->getTarget() == job.getTarget())
+            return true;
+    }
+    return false;
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,69 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <QThread>
+
+#include "renderbackend.h"
+#include "renderjob.h"
+
+namespace Cascade::Renderer
+{
+
+// Executes render jobs away from the GUI thread.
+// Only the latest job for a target is rendered, older ones that are still
+// queued are dropped and a running one stops at the next task.
+class RenderThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RenderThread(RenderBackend* backend, QObject* parent = nullptr);
+
+    ~RenderThread();
+
+    void submit(std::unique_ptr<RenderJob> job);
+
+    // Waits for the task that is currently executed, drops the rest
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    bool isCancelled(const RenderJob& job);
+
+    RenderBackend* mBackend;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::unique_ptr<RenderJob>> mJobs;
+    bool mStopped = false;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // RENDERTHREAD_H
@@ -21,14 +21,77 @@
 #define RENDERUTILITY_H
 
 #include <QFileInfo>
+#include <QRect>
+#include <QRegion>
 #include <QString>
 #include <QStringList>
 
 #include <vulkan/vulkan.hpp>
 
+#include "rendertask.h"
+
 namespace Cascade::Renderer
 {
 
+inline uint32_t getBytesPerPixel(const vk::Format format)
+{
+    switch (format)
+    {
+        case vk::Format::eR16Sfloat:
+            return 2;
+        case vk::Format::eR32Sfloat:
+            return 4;
+        case vk::Format::eR16G16B16A16Sfloat:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+inline uint32_t getNumChannels(const vk::Format format)
+{
+    switch (format)
+    {
+        case vk::Format::eR16Sfloat:
+        case vk::Format::eR32Sfloat:
+            return 1;
+        default:
+            return 4;
+    }
+}
+
+// The smallest rect made of whole work groups that contains the given one
+inline QRect alignToWorkGroups(const QRect& rect)
+{
+    if (rect.isEmpty())
+        return QRect();
+
+    const int left   = rect.left() / workGroupSize * workGroupSize;
+    const int top    = rect.top() / workGroupSize * workGroupSize;
+    const int right  = (rect.right() / workGroupSize + 1) * workGroupSize;
+    const int bottom = (rect.bottom() / workGroupSize + 1) * workGroupSize;
+
+    return QRect(left, top, right - left, bottom - top);
+}
+
+// Dispatches the work groups that cover the region. Only regions that
+// start at the origin work with pipelines without the dispatch base flag.
+inline void dispatchRegion(vk::CommandBuffer commandBuffer, const QRegion& region)
+{
+    for (const QRect& rect : region)
+    {
+        const uint32_t x      = rect.left() / workGroupSize;
+        const uint32_t y      = rect.top() / workGroupSize;
+        const uint32_t countX = rect.right() / workGroupSize + 1 - x;
+        const uint32_t countY = rect.bottom() / workGroupSize + 1 - y;
+
+        if (x == 0 && y == 0)
+            commandBuffer.dispatch(countX, countY, 1);
+        else
+            commandBuffer.dispatchBase(x, y, 0, countX, countY, 1);
+    }
+}
+
 inline VkDeviceSize aligned(VkDeviceSize v, VkDeviceSize byteAlign)
 {
     return (v + byteAlign - 1) & ~(byteAlign - 1);
@@ -45,21 +108,6 @@ inline const std::vector<float> unpackPushConstants(const QString& s)
     return values;
 }
 
-inline const std::vector<char> uintVecToCharVec(const std::vector<unsigned int>& in)
-{
-    std::vector<char> out;
-
-    for (size_t i = 0; i < in.size(); i++)
-    {
-        out.push_back(in[i] >> 0);
-        out.push_back(in[i] >> 8);
-        out.push_back(in[i] >> 16);
-        out.push_back(in[i] >> 24);
-    }
-
-    return out;
-}
-
 } // namespace Cascade::Renderer
 
 #endif // RENDERUTILITY_H
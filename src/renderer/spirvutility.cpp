@@ -0,0 +1,138 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "spirvutility.h"
+
+#include <cstddef>
+
+#include <QCryptographicHash>
+
+namespace Cascade::Renderer
+{
+
+namespace
+{
+
+constexpr uint32_t magicNumber  = 0x07230203;
+constexpr uint32_t headerLength = 5;
+
+constexpr uint32_t opCapability = 17;
+constexpr uint32_t opTypeImage  = 25;
+
+constexpr uint32_t capabilityReadWithoutFormat  = 55;
+constexpr uint32_t capabilityWriteWithoutFormat = 56;
+
+// Operands of OpTypeImage, counted from the opcode
+constexpr uint32_t imageSampledOperand = 7;
+constexpr uint32_t imageFormatOperand  = 8;
+constexpr uint32_t sampledIsStorage    = 2;
+constexpr uint32_t formatUnknown       = 0;
+
+uint32_t getOpcode(const uint32_t word)
+{
+    return word & 0xffff;
+}
+
+uint32_t getWordCount(const uint32_t word)
+{
+    return word >> 16;
+}
+
+} // namespace
+
+bool removeStorageImageFormats(std::vector<uint32_t>& code)
+{
+    if (code.size() < headerLength || code[0] != magicNumber)
+        return false;
+
+    bool hasStorageImages = false;
+    bool hasReadCapability = false;
+    bool hasWriteCapability = false;
+
+    // Capabilities come first, new ones go after the last one
+    std::size_t capabilitiesEnd = headerLength;
+
+    std::size_t i = headerLength;
+    while (i < code.size())
+    {
+        const uint32_t opcode    = getOpcode(code[i]);
+        const uint32_t wordCount = getWordCount(code[i]);
+
+        if (wordCount == 0 || i + wordCount > code.size())
+            return false;
+
+        if (opcode == opCapability && wordCount == 2)
+        {
+            hasReadCapability |= code[i + 1] == capabilityReadWithoutFormat;
+            hasWriteCapability |= code[i + 1] == capabilityWriteWithoutFormat;
+
+            capabilitiesEnd = i + wordCount;
+        }
+        else if (opcode == opTypeImage &&
+                 wordCount > imageFormatOperand &&
+                 code[i + imageSampledOperand] == sampledIsStorage)
+        {
+            code[i + imageFormatOperand] = formatUnknown;
+
+            hasStorageImages = true;
+        }
+
+        i += wordCount;
+    }
+
+    if (!hasStorageImages)
+        return true;
+
+    std::vector<uint32_t> capabilities;
+    if (!hasReadCapability)
+        capabilities.insert(capabilities.end(), { (2 << 16) | opCapability, capabilityReadWithoutFormat });
+    if (!hasWriteCapability)
+        capabilities.insert(capabilities.end(), { (2 << 16) | opCapability, capabilityWriteWithoutFormat });
+
+    code.insert(code.begin() + capabilitiesEnd, capabilities.begin(), capabilities.end());
+
+    return true;
+}
+
+QByteArray getShaderKey(const std::vector<uint32_t>& code)
+{
+    return QCryptographicHash::hash(
+        QByteArray::fromRawData(
+            reinterpret_cast<const char*>(code.data()),
+            static_cast<int>(code.size() * sizeof(uint32_t))),
+        QCryptographicHash::Sha1);
+}
+
+QByteArray getPipelineKey(
+    const QByteArray& shaderKey,
+    const std::vector<uint32_t>& specialization)
+{
+    if (specialization.empty())
+        return shaderKey;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(shaderKey);
+    hash.addData(
+        reinterpret_cast<const char*>(specialization.data()),
+        static_cast<int>(specialization.size() * sizeof(uint32_t)));
+
+    return hash.result();
+}
+
+} // namespace Cascade::Renderer
@@ -0,0 +1,49 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPIRVUTILITY_H
+#define SPIRVUTILITY_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QByteArray>
+
+namespace Cascade::Renderer
+{
+
+// Changes the format of all storage images in a SPIR-V module to
+// Unknown, so one shader works on images of any format, and adds the
+// capabilities this needs. Returns false if the code is not SPIR-V.
+// The device needs shaderStorageImageReadWithoutFormat and
+// shaderStorageImageWriteWithoutFormat.
+bool removeStorageImageFormats(std::vector<uint32_t>& code);
+
+// Identifies a shader by its code
+QByteArray getShaderKey(const std::vector<uint32_t>& code);
+
+// Identifies a pipeline by its shader and the values
+// of its specialization constants
+QByteArray getPipelineKey(
+    const QByteArray& shaderKey,
+    const std::vector<uint32_t>& specialization);
+
+} // namespace Cascade::Renderer
+
+#endif // SPIRVUTILITY_H
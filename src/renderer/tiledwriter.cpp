@@ -0,0 +1,125 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tiledwriter.h"
+
+#include "../log.h"
+
+namespace Cascade::Renderer
+{
+
+TiledWriter::TiledWriter(
+    const QString& path,
+    const QSize& size,
+    const QMap<std::string, std::string>& attributes)
+    : mPath(path)
+    , mSize(size)
+    , mSpec(size.width(), size.height(), 4, OIIO::TypeDesc::FLOAT)
+{
+    QMap<std::string, std::string>::const_iterator it;
+    for (it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        mSpec.attribute(it.key(), it.value());
+    }
+
+    mOutput = OIIO::ImageOutput::create(path.toStdString());
+    if (!mOutput)
+    {
+        CS_LOG_WARNING("Could not find a writer for " + path);
+        return;
+    }
+
+    mIsGood = true;
+}
+
+TiledWriter::~TiledWriter()
+{
+    // Rows that were not written leave a truncated file behind
+    if (mIsOpen)
+        mOutput->close();
+}
+
+bool TiledWriter::isGood() const
+{
+    return mIsGood;
+}
+
+void TiledWriter::beginRow(const int top, const int height)
+{
+    if (mIsGood && !mIsOpen)
+    {
+        mIsOpen = mOutput->open(mPath.toStdString(), mSpec);
+        if (!mIsOpen)
+        {
+            CS_LOG_WARNING("Could not open " + mPath + " for writing.");
+            CS_LOG_WARNING(QString::fromStdString(mOutput->geterror()));
+            abort();
+        }
+    }
+
+    mRowTop = top;
+    mRow.reset(OIIO::ImageSpec(mSize.width(), height, 4, OIIO::TypeDesc::FLOAT));
+}
+
+OIIO::ImageBuf& TiledWriter::getRow()
+{
+    return mRow;
+}
+
+bool TiledWriter::endRow()
+{
+    if (!mIsGood)
+        return false;
+
+    const int bottom = mRowTop + mRow.spec().height;
+
+    mIsGood = mOutput->write_scanlines(
+        mRowTop, bottom, 0, OIIO::TypeDesc::FLOAT, mRow.localpixels());
+    if (!mIsGood)
+    {
+        CS_LOG_WARNING("Problem writing " + mPath + ": " +
+                       QString::fromStdString(mOutput->geterror()));
+    }
+
+    if (bottom >= mSize.height() || !mIsGood)
+    {
+        mIsGood = mOutput->close() && mIsGood;
+        mOutput.reset();
+        mIsOpen = false;
+    }
+
+    return mIsGood;
+}
+
+void TiledWriter::abort()
+{
+    if (mIsOpen)
+        mOutput->close();
+    mOutput.reset();
+    mIsOpen = false;
+
+    mIsGood = false;
+}
+
+const QString& TiledWriter::getPath() const
+{
+    return mPath;
+}
+
+} // namespace Cascade::Renderer
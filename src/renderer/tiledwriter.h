@@ -0,0 +1,83 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILEDWRITER_H
+#define TILEDWRITER_H
+
+#include <memory>
+
+#include <QMap>
+#include <QSize>
+#include <QString>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imageio.h>
+
+namespace Cascade::Renderer
+{
+
+// Writes an image that is rendered in tiles to a file row by row,
+// so only one row of tiles has to be in memory at a time. The file is
+// opened with the first row, saves of the same path that are rendered
+// one after the other don't have it open at the same time.
+class TiledWriter
+{
+public:
+    TiledWriter(
+        const QString& path,
+        const QSize& size,
+        const QMap<std::string, std::string>& attributes);
+
+    ~TiledWriter();
+
+    // False if the format is not supported, the file could not
+    // be opened or a row could not be written
+    bool isGood() const;
+
+    // Starts a row of tiles at the given height in the image
+    void beginRow(const int top, const int height);
+
+    // Receives the tiles of the current row, it spans the full
+    // width of the image and starts at the top of the row
+    OIIO::ImageBuf& getRow();
+
+    // Writes the row to the file, closes it after the last one
+    bool endRow();
+
+    // Gives up on the file, for when a tile could not be rendered
+    void abort();
+
+    const QString& getPath() const;
+
+private:
+    QString mPath;
+    QSize mSize;
+
+    OIIO::ImageSpec mSpec;
+    std::unique_ptr<OIIO::ImageOutput> mOutput;
+    bool mIsOpen = false;
+    OIIO::ImageBuf mRow;
+    int mRowTop = 0;
+
+    bool mIsGood = false;
+};
+
+} // namespace Cascade::Renderer
+
+#endif // TILEDWRITER_H
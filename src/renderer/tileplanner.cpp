@@ -0,0 +1,53 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "tileplanner.h"
+
+namespace Cascade::Renderer
+{
+
+std::vector<Tile> planTiles(const QSize& size, const int maxTileSize, const int halo)
+{
+    std::vector<Tile> tiles;
+
+    const int step = maxTileSize - 2 * halo;
+    if (step <= 0 || size.isEmpty())
+        return tiles;
+
+    const QRect image(QPoint(0, 0), size);
+
+    int row = 0;
+    for (int y = 0; y < size.height(); y += step, ++row)
+    {
+        for (int x = 0; x < size.width(); x += step)
+        {
+            Tile tile;
+            tile.target      = QRect(x, y, step, step) & image;
+            tile.source      = tile.target.adjusted(-halo, -halo, halo, halo) & image;
+            tile.row         = row;
+            tile.isLastInRow = x + step >= size.width();
+
+            tiles.push_back(tile);
+        }
+    }
+
+    return tiles;
+}
+
+} // namespace Cascade::Renderer
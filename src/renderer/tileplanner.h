@@ -0,0 +1,50 @@
+/*
+ *  Cascade Image Editor
+ *
+ *  Copyright (C) 2022 Till Dechent and contributors
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILEPLANNER_H
+#define TILEPLANNER_H
+
+#include <vector>
+
+#include <QRect>
+#include <QSize>
+
+namespace Cascade::Renderer
+{
+
+// A part of an image that is rendered on its own
+struct Tile
+{
+    // What is rendered, the target and the halo around it
+    QRect source;
+    // The part of the result the tile is responsible for
+    QRect target;
+    // Tiles are in rows from top to bottom, left to right in a row
+    int row;
+    bool isLastInRow;
+};
+
+// Splits an image into tiles of at most maxTileSize pixels in either
+// direction, halo included. The targets of the tiles cover the image
+// without overlapping. Empty if the halo leaves no room for a target.
+std::vector<Tile> planTiles(const QSize& size, const int maxTileSize, const int halo);
+
+} // namespace Cascade::Renderer
+
+#endif // TILEPLANNER_H
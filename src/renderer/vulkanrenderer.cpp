@@ -19,21 +19,32 @@
 
 #include "vulkanrenderer.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <QCoreApplication>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QMouseEvent>
+#include <QSaveFile>
+#include <QTimer>
+#include <QVersionNumber>
 #include <QVulkanFunctions>
 #include <QVulkanWindowRenderer>
 
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imageio.h>
 
 #include "../benchmark.h"
 #include "../log.h"
 #include "../multithreading.h"
 #include "../uientities/fileboxentity.h"
 #include "../vulkanwindow.h"
+#include "pipelinecachefile.h"
 #include "renderutility.h"
+#include "spirvutility.h"
 
 namespace Cascade::Renderer
 {
@@ -63,6 +74,18 @@ void VulkanRenderer::initResources()
     mDevice         = mWindow->device();
     mPhysicalDevice = mWindow->physicalDevice();
 
+    // Everything below gets its memory from here
+    mAllocator = std::make_unique<CsMemoryAllocator>(&mDevice, &mPhysicalDevice);
+
+    // Has to be known before the shaders are loaded
+    checkImageFormats();
+
+    // Dispatches with an offset are needed to render only
+    // the visible part of an image, they are part of Vulkan 1.1
+    mHasDispatchBase =
+        mWindow->vulkanInstance()->apiVersion() >= QVersionNumber(1, 1) &&
+        mPhysicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_1;
+
     // Init all the permanent parts of the renderer
     createVertexBuffer();
     createSampler();
@@ -77,19 +100,47 @@ void VulkanRenderer::initResources()
     createComputeDescriptors();
     createComputePipelineLayout();
 
-    // Load all the shaders we need and create their pipelines
-    loadShadersFromDisk();
-    // Create Noop pipeline
-    mComputePipelineNoop =
-        createComputePipeline(createShaderFromFile(":/shaders/noop_comp.spv").get());
-    // Create a pipeline for each shader
-    createComputePipelines();
+    mPipelineRegistry = std::make_unique<PipelineRegistry>(
+        [this](const std::vector<uint32_t>& code) { return createShaderFromCode(code); },
+        [this](const vk::ShaderModule shader, const std::vector<uint32_t>& specialization)
+        { return createComputePipeline(shader, specialization); });
 
     mComputeCommandBuffer = std::unique_ptr<CsCommandBuffer>(new CsCommandBuffer(
-        &mDevice, &mPhysicalDevice, &mComputePipelineLayout.get(), &mComputeDescriptorSet.get()));
+        &mDevice,
+        &mPhysicalDevice,
+        mAllocator.get(),
+        &mComputePipelineLayout.get(),
+        &mComputeDescriptorSet.get()));
+
+    mFrameGraph = std::make_unique<CsFrameGraph>(
+        &mDevice,
+        &mPhysicalDevice,
+        mAllocator.get(),
+        *mComputeCommandBuffer->getQueue(),
+        mComputeCommandBuffer->getQueueFamilyIndex(),
+        *mComputeDescriptorSetLayout,
+        *mComputePipelineLayout);
 
     mSettingsBuffer =
-        std::unique_ptr<CsSettingsBuffer>(new CsSettingsBuffer(&mDevice, &mPhysicalDevice));
+        std::unique_ptr<CsSettingsBuffer>(new CsSettingsBuffer(&mDevice, &mPhysicalDevice, mAllocator.get(), 1));
+
+    mImagePool = std::make_unique<CsImagePool>(
+        mWindow, &mDevice, &mPhysicalDevice, mAllocator.get(), imagePoolBudget);
+
+    mImageCache = std::make_unique<CsImageCache>(defaultImageCacheBudget);
+    // The pool may destroy what it gets, images the job
+    // has recorded commands for have to outlive it
+    mImageCache->setReleaseCallback(
+        [this](std::unique_ptr<CsImage> image)
+        {
+            if (mFrameGraph->isUsing(image.get()))
+                mFrameGraph->keepAlive(std::move(image));
+            else
+                mImagePool->release(std::move(image));
+        });
+
+    mTransientMemory = std::make_unique<CsTransientMemory>(
+        mWindow, &mDevice, &mPhysicalDevice, mAllocator.get());
 
     // Load OCIO config
     try
@@ -115,19 +166,17 @@ QString VulkanRenderer::getGpuName()
 
 void VulkanRenderer::createVertexBuffer()
 {
-    // The current vertexBuffer will be destroyed,
-    // so we have to wait here.
-    auto result = mDevice.waitIdle();
-
     const vk::PhysicalDeviceLimits pdevLimits(mPhysicalDevice.getProperties().limits);
     const vk::DeviceSize uniAlign = pdevLimits.minUniformBufferOffsetAlignment;
 
     const vk::DeviceSize vertexAllocSize  = aligned(sizeof(vertexData), uniAlign);
     const vk::DeviceSize uniformAllocSize = aligned(uniformDataSize, uniAlign);
 
+    // Every frame in flight has its own vertices and matrix,
+    // they are written by the frame that draws with them
     vk::BufferCreateInfo bufferInfo(
         {},
-        vertexAllocSize + mConcurrentFrameCount * uniformAllocSize,
+        mConcurrentFrameCount * (vertexAllocSize + uniformAllocSize),
         vk::BufferUsageFlags(
             vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eUniformBuffer));
     mVertexBuffer = mDevice.createBufferUnique(bufferInfo).value;
@@ -138,43 +187,36 @@ void VulkanRenderer::createVertexBuffer()
             vk::ObjectType::eBuffer,
             NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkBuffer, *mVertexBuffer),
             "Vertex Buffer");
-        result = mDevice.setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
+        auto result = mDevice.setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
+        Q_UNUSED(result);
     }
 #endif
 
     vk::MemoryRequirements memReq = mDevice.getBufferMemoryRequirements(*mVertexBuffer);
 
-    vk::MemoryAllocateInfo memAllocInfo(memReq.size, mWindow->hostVisibleMemoryIndex());
-
-    mVertexBufferMemory = mDevice.allocateMemoryUnique(memAllocInfo).value;
-
-#ifdef QT_DEBUG
-    {
-        vk::DebugUtilsObjectNameInfoEXT debugUtilsObjectNameInfo(
-            vk::ObjectType::eDeviceMemory,
-            NON_DISPATCHABLE_HANDLE_TO_UINT64_CAST(VkDeviceMemory, *mVertexBufferMemory),
-            "Vertex Buffer Memory");
-        result = mDevice.setDebugUtilsObjectNameEXT(debugUtilsObjectNameInfo);
-    }
-#endif
+    mVertexBufferAllocation =
+        mAllocator->allocate(memReq, mWindow->hostVisibleMemoryIndex(), true);
 
     // copy the vertex and color data into device memory
-    uint8_t* pData =
-        static_cast<uint8_t*>(mDevice.mapMemory(mVertexBufferMemory.get(), 0, memReq.size).value);
-    memcpy(pData, vertexData, sizeof(vertexData));
+    uint8_t* pData = static_cast<uint8_t*>(mVertexBufferAllocation.getMappedData());
 
     QMatrix4x4 ident;
     for (int i = 0; i < mConcurrentFrameCount; ++i)
     {
-        const vk::DeviceSize offset = vertexAllocSize + i * uniformAllocSize;
+        mVertexOffsets[i] = i * (vertexAllocSize + uniformAllocSize);
+        memcpy(pData + mVertexOffsets[i], vertexData, sizeof(vertexData));
+
+        const vk::DeviceSize offset = mVertexOffsets[i] + vertexAllocSize;
         memcpy(pData + offset, ident.constData(), 16 * sizeof(float));
         mUniformBufferInfo[i].setBuffer(*mVertexBuffer);
         mUniformBufferInfo[i].setOffset(offset);
         mUniformBufferInfo[i].setRange(uniformAllocSize);
     }
-    mDevice.unmapMemory(mVertexBufferMemory.get());
 
-    result = mDevice.bindBufferMemory(*mVertexBuffer, *mVertexBufferMemory, 0);
+    auto result = mDevice.bindBufferMemory(
+        *mVertexBuffer,
+        mVertexBufferAllocation.getMemory(),
+        mVertexBufferAllocation.getOffset());
     Q_UNUSED(result);
 }
 
@@ -202,9 +244,10 @@ void VulkanRenderer::createDescriptorPool()
         {vk::DescriptorType::eUniformBuffer, 3 * uint32_t(mConcurrentFrameCount)},
         {vk::DescriptorType::eCombinedImageSampler, 1 * uint32_t(mConcurrentFrameCount)},
         {vk::DescriptorType::eCombinedImageSampler, 1 * uint32_t(mConcurrentFrameCount)},
-        {vk::DescriptorType::eStorageImage, 6 * uint32_t(mConcurrentFrameCount)}};
+        {vk::DescriptorType::eStorageImage, 6 * uint32_t(mConcurrentFrameCount)},
+        {vk::DescriptorType::eUniformBufferDynamic, 1}};
 
-    vk::DescriptorPoolCreateInfo descPoolInfo({}, 6, 4, descPoolSizes.data());
+    vk::DescriptorPoolCreateInfo descPoolInfo({}, 6, 5, descPoolSizes.data());
 
     mDescriptorPool = mDevice.createDescriptorPoolUnique(descPoolInfo).value;
 }
@@ -236,9 +279,61 @@ void VulkanRenderer::createGraphicsDescriptors()
 
 void VulkanRenderer::createGraphicsPipelineCache()
 {
-    // Pipeline cache
-    vk::PipelineCacheCreateInfo pipelineCacheInfo;
-    mPipelineCache = mDevice.createPipelineCacheUnique(pipelineCacheInfo).value;
+    const vk::PhysicalDeviceProperties props = mPhysicalDevice.getProperties();
+
+    PipelineCacheId id;
+    id.vendorId      = props.vendorID;
+    id.deviceId      = props.deviceID;
+    id.driverVersion = props.driverVersion;
+    id.uuid          = QByteArray(
+        reinterpret_cast<const char*>(props.pipelineCacheUUID.data()), VK_UUID_SIZE);
+
+    mPipelineCachePath = pipelineCacheDir + "/" + getPipelineCacheFileName(id);
+
+    QByteArray data;
+    QFile file(mPipelineCachePath);
+    if (file.open(QIODevice::ReadOnly))
+    {
+        data = unpackPipelineCache(file.readAll(), id);
+        if (data.isEmpty())
+            CS_LOG_WARNING("Ignoring damaged pipeline cache " + mPipelineCachePath);
+    }
+
+    vk::PipelineCacheCreateInfo pipelineCacheInfo({}, data.size(), data.constData());
+    auto result = mDevice.createPipelineCacheUnique(pipelineCacheInfo);
+
+    // Starting empty only costs time
+    if (result.result != vk::Result::eSuccess && !data.isEmpty())
+    {
+        CS_LOG_WARNING("The driver rejected the pipeline cache, starting with an empty one.");
+        result = mDevice.createPipelineCacheUnique(vk::PipelineCacheCreateInfo());
+    }
+    mPipelineCache = std::move(result.value);
+}
+
+void VulkanRenderer::savePipelineCache()
+{
+    if (!mPipelineCache || mPipelineCachePath.isEmpty())
+        return;
+
+    auto result = mDevice.getPipelineCacheData(*mPipelineCache);
+    if (result.result != vk::Result::eSuccess || result.value.empty())
+        return;
+
+    const QByteArray data(
+        reinterpret_cast<const char*>(result.value.data()),
+        static_cast<int>(result.value.size()));
+
+    // Written next to the old file and renamed, so a crash
+    // in between leaves the old one as it was
+    QDir().mkpath(pipelineCacheDir);
+    QSaveFile file(mPipelineCachePath);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(packPipelineCache(data)) < 0 ||
+        !file.commit())
+    {
+        CS_LOG_WARNING("Could not save the pipeline cache to " + mPipelineCachePath);
+    }
 }
 
 void VulkanRenderer::createGraphicsPipelineLayout()
@@ -254,13 +349,6 @@ void VulkanRenderer::createGraphicsPipelineLayout()
     mGraphicsPipelineLayout = mDevice.createPipelineLayoutUnique(pipelineLayoutInfo).value;
 }
 
-void VulkanRenderer::fillSettingsBuffer( [[maybe_unused]] const NodeBase* node)
-{
-    //    auto props = node->getAllPropertyValues();
-
-    //    mSettingsBuffer->fillBuffer(props);
-}
-
 void VulkanRenderer::createGraphicsPipeline(vk::UniquePipeline& pl, const QString& fragShaderPath)
 {
     // Vertex shader never changes
@@ -354,7 +442,7 @@ void VulkanRenderer::createGraphicsPipeline(vk::UniquePipeline& pl, const QStrin
     pl = std::move(mDevice.createGraphicsPipelineUnique(*mPipelineCache, pipelineInfo).value);
 }
 
-vk::UniqueShaderModule VulkanRenderer::createShaderFromFile(const QString& name)
+std::vector<uint32_t> VulkanRenderer::readShaderFile(const QString& name)
 {
     QFile file(name);
     if (!file.open(QIODevice::ReadOnly))
@@ -365,45 +453,39 @@ vk::UniqueShaderModule VulkanRenderer::createShaderFromFile(const QString& name)
     QByteArray blob = file.readAll();
     file.close();
 
-    vk::ShaderModuleCreateInfo shaderInfo(
-        {}, blob.size(), reinterpret_cast<const uint32_t*>(blob.constData()));
-
-    vk::UniqueShaderModule shaderModule = mDevice.createShaderModuleUnique(shaderInfo).value;
+    std::vector<uint32_t> code(blob.size() / sizeof(uint32_t));
+    memcpy(code.data(), blob.constData(), code.size() * sizeof(uint32_t));
 
-    return shaderModule;
+    return code;
 }
 
-vk::UniqueShaderModule VulkanRenderer::createShaderFromCode(const std::vector<unsigned int>& code)
+vk::UniqueShaderModule VulkanRenderer::createShaderFromFile(const QString& name)
 {
-    auto codeChar = uintVecToCharVec(code);
+    return createShaderFromCode(readShaderFile(name));
+}
 
-    QByteArray codeArray =
-        QByteArray(reinterpret_cast<const char*>(codeChar.data()), codeChar.size());
+vk::UniqueShaderModule VulkanRenderer::createShaderFromCode(std::vector<uint32_t> spirv)
+{
+    // The shaders declare their images as rgba32f
+    if (mHasFormatlessStorage && !removeStorageImageFormats(spirv))
+        CS_LOG_WARNING("Shader is not valid SPIR-V.");
 
-    vk::ShaderModuleCreateInfo shaderInfo(
-        {}, codeArray.size(), reinterpret_cast<const uint32_t*>(codeArray.constData()));
+    vk::ShaderModuleCreateInfo shaderInfo({}, spirv.size() * sizeof(uint32_t), spirv.data());
 
     vk::UniqueShaderModule shaderModule = mDevice.createShaderModuleUnique(shaderInfo).value;
 
     return shaderModule;
 }
 
-void VulkanRenderer::loadShadersFromDisk()
+bool VulkanRenderer::createComputeRenderTarget(
+    uint32_t width,
+    uint32_t height,
+    const vk::Format format)
 {
-    //    for (int i = 0; i != static_cast<int>(NodeType::eLast); i++)
-    //    {
-    //        NodeType nodeType = static_cast<NodeType>(i);
+    mImagePool->release(std::move(mComputeRenderTarget));
 
-    //        auto props = getPropertiesForType(nodeType);
-
-    //        mShaders[nodeType] = createShaderFromFile(props.shaderPath);
-    //    }
-}
-
-bool VulkanRenderer::createComputeRenderTarget(uint32_t width, uint32_t height)
-{
-    mComputeRenderTarget = std::unique_ptr<CsImage>(new CsImage(
-        mWindow, &mDevice, &mPhysicalDevice, width, height, false, "Compute Render Target"));
+    mComputeRenderTarget =
+        mImagePool->acquire(width, height, false, format, "Compute Render Target");
 
     emit mWindow->renderTargetHasBeenCreated(width, height);
 
@@ -412,73 +494,397 @@ bool VulkanRenderer::createComputeRenderTarget(uint32_t width, uint32_t height)
     return true;
 }
 
-bool VulkanRenderer::createImageFromFile(const QString& path, const int colorSpace)
+// The closest depth to the type the file is stored in
+static UploadDepth getUploadDepth(const OIIO::TypeDesc& type)
 {
-    mCpuImage = std::unique_ptr<ImageBuf>(new ImageBuf(path.toStdString()));
-    bool ok   = mCpuImage->read(0, 0, 0, 4, true, OIIO::TypeDesc::FLOAT);
-    if (!ok)
+    switch (type.basetype)
     {
-        CS_LOG_WARNING("There was a problem reading the image from disk.");
-        CS_LOG_WARNING(QString::fromStdString(mCpuImage->geterror()));
+        case OIIO::TypeDesc::UINT8:
+            return UploadDepth::eUInt8;
+        case OIIO::TypeDesc::UINT16:
+            return UploadDepth::eUInt16;
+        case OIIO::TypeDesc::HALF:
+            return UploadDepth::eHalf;
+        default:
+            return UploadDepth::eFloat;
     }
-    // Add alpha channel if it doesn't exist
-    if (mCpuImage->nchannels() == 3)
+}
+
+static vk::Format getUploadFormat(const UploadDepth depth)
+{
+    switch (depth)
     {
-        int channelorder[]         = {0, 1, 2, -1};
-        float channelvalues[]      = {0 /*ignore*/, 0 /*ignore*/, 0 /*ignore*/, 1.0};
-        std::string channelnames[] = {"R", "G", "B", "A"};
+        case UploadDepth::eUInt8:
+            return vk::Format::eR8G8B8A8Unorm;
+        case UploadDepth::eUInt16:
+            return vk::Format::eR16G16B16A16Unorm;
+        case UploadDepth::eHalf:
+            return vk::Format::eR16G16B16A16Sfloat;
+        default:
+            return globalImageFormat;
+    }
+}
 
-        *mCpuImage =
-            OIIO::ImageBufAlgo::channels(*mCpuImage, 4, channelorder, channelvalues, channelnames);
+static OIIO::TypeDesc getUploadType(const UploadDepth depth)
+{
+    switch (depth)
+    {
+        case UploadDepth::eUInt8:
+            return OIIO::TypeDesc::UINT8;
+        case UploadDepth::eUInt16:
+            return OIIO::TypeDesc::UINT16;
+        case UploadDepth::eHalf:
+            return OIIO::TypeDesc::HALF;
+        default:
+            return OIIO::TypeDesc::FLOAT;
     }
+}
+
+std::unique_ptr<CsImage> VulkanRenderer::uploadImageFromFile(
+    RenderTaskRead* task,
+    vk::Pipeline& readPipeline,
+    CsImage*& colorSpaceLut,
+    std::unique_lock<std::recursive_mutex>& lock)
+{
+    const std::string path = task->getPath().toStdString();
+    const QRect& tile      = task->getTile();
+    const float scale      = task->getProxyScale();
 
-    transformColorSpace(colorSpaces.at(colorSpace), "linear", *mCpuImage);
+    std::unique_ptr<OIIO::ImageInput> input;
+    ImageBuf part;
+    QSize size;
+    OIIO::TypeDesc fileType;
+    int numChannels = 0;
 
-    updateVertexData(mCpuImage->xend(), mCpuImage->yend());
+    // Nothing the file is read into is shared yet, the viewer
+    // goes on drawing while OIIO works on it
+    lock.unlock();
 
-    vk::FormatProperties props = mPhysicalDevice.getFormatProperties(globalImageFormat);
-    const bool canSampleLinear =
-        (bool)(props.linearTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
-    const bool canSampleOptimal =
-        (bool)(props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
-    if (!canSampleLinear && !canSampleOptimal)
+    if (tile.isNull() && scale == 1.0f)
     {
-        CS_LOG_WARNING("Neither linear nor optimal image sampling is supported for image");
-        return false;
+        input = OIIO::ImageInput::open(path);
+        if (!input)
+        {
+            lock.lock();
+            CS_LOG_WARNING("There was a problem reading the image from disk.");
+            CS_LOG_WARNING(QString::fromStdString(OIIO::geterror()));
+            return nullptr;
+        }
+        const OIIO::ImageSpec& spec = input->spec();
+
+        size        = QSize(spec.width, spec.height);
+        numChannels = std::min(4, spec.nchannels);
+        fileType    = spec.format;
     }
+    else
+    {
+        // Goes through the image cache of OIIO, which only reads what is
+        // needed of the file. Files too big to be loaded at once are
+        // rendered in tiles or as a preview at a fraction of their size.
+        ImageBuf file(path);
+        numChannels = std::min(4, file.nchannels());
 
-    // The image that gets the data from the CPU
-    mLoadImageStaging = std::unique_ptr<CsImage>(new CsImage(
-        mWindow,
-        &mDevice,
-        &mPhysicalDevice,
-        mCpuImage->xend(),
-        mCpuImage->yend(),
-        true,
-        "Load Image Staging"));
+        if (!tile.isNull())
+        {
+            part = OIIO::ImageBufAlgo::cut(
+                file,
+                OIIO::ROI(
+                    tile.left(),
+                    tile.right() + 1,
+                    tile.top(),
+                    tile.bottom() + 1,
+                    0,
+                    1,
+                    0,
+                    numChannels));
+        }
+        else
+        {
+            // A plain resample is good enough for a preview,
+            // the full resolution render replaces it afterwards
+            const int w = std::max(1, static_cast<int>(std::lround(file.xend() * scale)));
+            const int h = std::max(1, static_cast<int>(std::lround(file.yend() * scale)));
+
+            part = OIIO::ImageBufAlgo::resample(
+                file, true, OIIO::ROI(0, w, 0, h, 0, 1, 0, numChannels));
+        }
+        if (part.has_error() || !part.initialized())
+        {
+            lock.lock();
+            CS_LOG_WARNING("There was a problem reading the image from disk.");
+            CS_LOG_WARNING(QString::fromStdString(part.geterror()));
+            return nullptr;
+        }
+        size     = QSize(part.spec().width, part.spec().height);
+        fileType = part.spec().format;
+    }
 
-    if (!writeLinearImage(
-            static_cast<float*>(mCpuImage->localpixels()),
-            QSize(mCpuImage->xend(), mCpuImage->yend()),
-            mLoadImageStaging))
+    lock.lock();
+
+    // Converted by the read shader if a LUT is close enough
+    // to the transform, otherwise on the CPU as floats
+    const QString& colorSpace = colorSpaces.at(task->getColorSpace());
+    ColorSpaceLutDomain domain;
+    colorSpaceLut = nullptr;
+
+    // Without a config the file is loaded as it is
+    OCIO::ConstCPUProcessorRcPtr toLinear =
+        mColorProcessors.get(mOcioConfig, colorSpace, "linear", mColorOptimization);
+
+    bool convertOnCpu = false;
+    if (toLinear && !toLinear->isNoOp())
     {
-        CS_LOG_WARNING("Failed to write linear image");
-        return false;
+        colorSpaceLut = getColorSpaceLut(colorSpace, "linear", domain);
+        convertOnCpu  = !colorSpaceLut;
     }
-    return true;
+
+    UploadDepth depth = convertOnCpu ? UploadDepth::eFloat : getUploadDepth(fileType);
+    if (!mHasUploadDepth[static_cast<int>(depth)])
+        depth = UploadDepth::eFloat;
+
+    QString key = "read:" + QString::number(static_cast<int>(depth)) + ":" +
+                  QString::number(numChannels);
+    QString colorSpaceCode;
+    if (colorSpaceLut)
+    {
+        key += ":" + QString::fromLatin1(getColorSpaceLutSignature(domain, colorSpaceLutSize));
+        colorSpaceCode = generateColorSpaceLutCode(domain, colorSpaceLutSize);
+    }
+    readPipeline = getGeneratedPipeline(key, generateReadShader(depth, numChannels, colorSpaceCode));
+    if (!readPipeline)
+        return nullptr;
+
+    const OIIO::TypeDesc uploadType = getUploadType(depth);
+    const int pixelSize             = getUploadPixelSize(depth);
+
+    // Same format as the decoded pixels for the upload,
+    // the read shader converts it to that of the result
+    auto image = createTransientImage(task, size, getUploadFormat(depth), true);
+
+    bool ok = true;
+
+    // Decodes straight into the staging memory, with the
+    // channels spread out to RGBA by the stride. Only this thread
+    // records into the frame graph while a job is recording, so the
+    // band handed out stays untouched without the lock.
+    auto readRows = [&](char* data, const int firstRow, const int numRows)
+    {
+        lock.unlock();
+
+        if (input)
+        {
+            const OIIO::ImageSpec& spec = input->spec();
+
+            ok &= input->read_scanlines(
+                0,
+                0,
+                spec.y + firstRow,
+                spec.y + firstRow + numRows,
+                0,
+                0,
+                numChannels,
+                uploadType,
+                data,
+                pixelSize);
+        }
+        else
+        {
+            const OIIO::ROI roi = part.roi();
+
+            ok &= part.get_pixels(
+                OIIO::ROI(
+                    roi.xbegin,
+                    roi.xend,
+                    roi.ybegin + firstRow,
+                    roi.ybegin + firstRow + numRows,
+                    0,
+                    1,
+                    0,
+                    numChannels),
+                uploadType,
+                data,
+                pixelSize);
+        }
+
+        // The channels the file doesn't have are converted as well,
+        // the read shader replaces them afterwards
+        if (convertOnCpu)
+        {
+            parallelApplyColorSpace(
+                toLinear,
+                reinterpret_cast<float*>(data),
+                size.width(),
+                numRows);
+        }
+
+        lock.lock();
+    };
+
+    if (!mFrameGraph->addUpload(image.get(), pixelSize, readRows) || !ok)
+    {
+        CS_LOG_WARNING("There was a problem reading the image from disk.");
+        if (input)
+            CS_LOG_WARNING(QString::fromStdString(input->geterror()));
+        else
+            CS_LOG_WARNING(QString::fromStdString(part.geterror()));
+
+        // Copies to it may have been recorded already
+        mFrameGraph->keepAlive(std::move(image));
+        return nullptr;
+    }
+
+    return image;
 }
 
 void VulkanRenderer::transformColorSpace(const QString& from, const QString& to, ImageBuf& image)
 {
+    // Without a config the image is saved as it is
+    OCIO::ConstCPUProcessorRcPtr processor =
+        mColorProcessors.get(mOcioConfig, from, to, mColorOptimization);
+    if (!processor)
+        return;
+
     parallelApplyColorSpace(
-        mOcioConfig,
-        from,
-        to,
+        processor,
         static_cast<float*>(image.localpixels()),
         image.xend(),
         image.yend());
 }
 
+// Range of the color space the LUT has to cover, from its allocation
+static ColorSpaceLutDomain getColorSpaceLutDomain(
+    OCIO::ConstConfigRcPtr config,
+    const QString& colorSpace)
+{
+    ColorSpaceLutDomain domain;
+
+    OCIO::ConstColorSpaceRcPtr space = config->getColorSpace(colorSpace.toLocal8Bit());
+    if (!space || space->getAllocationNumVars() < 2)
+        return domain;
+
+    float vars[3] = {};
+    space->getAllocationVars(vars);
+
+    domain.isLog = space->getAllocation() == OCIO::ALLOCATION_LG2;
+    domain.min   = vars[0];
+    domain.max   = vars[1];
+
+    return domain;
+}
+
+CsImage* VulkanRenderer::getColorSpaceLut(
+    const QString& from,
+    const QString& to,
+    ColorSpaceLutDomain& domain)
+{
+    // The same processor as the CPU path, so it is what the LUT is checked against
+    OCIO::ConstCPUProcessorRcPtr processor =
+        mColorProcessors.get(mOcioConfig, from, to, mColorOptimization);
+    if (!processor)
+        return nullptr;
+
+    domain = getColorSpaceLutDomain(mOcioConfig, from);
+
+    const QByteArray key = "colorspace:" + from.toUtf8() + ":" + to.toUtf8() + ":" +
+                           getColorSpaceLutSignature(domain, colorSpaceLutSize) + ":" +
+                           QByteArray::number(static_cast<qulonglong>(mColorOptimization));
+
+    // Conversions the LUT can't reproduce stay on the CPU
+    auto known = mColorSpaceLutIsExact.find(key);
+    if (known != mColorSpaceLutIsExact.end() && !known->second)
+        return nullptr;
+
+    if (CsImage* lut = mImageCache->get(key))
+        return lut;
+
+    const ColorTransform transform = [&processor](float* pixels, const int numPixels)
+    {
+        OCIO::PackedImageDesc desc(pixels, numPixels, 1, 4);
+        processor->apply(desc);
+    };
+    const std::vector<float> values = bakeColorSpaceLut(transform, domain, colorSpaceLutSize);
+
+    if (known == mColorSpaceLutIsExact.end())
+    {
+        const float error  = getColorSpaceLutError(values, transform, domain);
+        const bool isExact = error <= colorSpaceLutTolerance;
+
+        mColorSpaceLutIsExact[key] = isExact;
+        if (!isExact)
+        {
+            CS_LOG_INFO(
+                "Converting " + from + " to " + to + " on the CPU, the LUT is off by " +
+                QString::number(error));
+            return nullptr;
+        }
+    }
+
+    auto image = mImagePool->acquire(
+        colorSpaceLutSize, 1, false, globalImageFormat, "Color Space LUT");
+
+    const int pixelSize = 4 * sizeof(float);
+    auto writeLut       = [&values, pixelSize](char* data, const int firstRow, const int numRows)
+    {
+        memcpy(data,
+               values.data() + static_cast<size_t>(firstRow) * colorSpaceLutSize * 4,
+               static_cast<size_t>(numRows) * colorSpaceLutSize * pixelSize);
+    };
+    if (!mFrameGraph->addUpload(image.get(), pixelSize, writeLut))
+    {
+        mFrameGraph->keepAlive(std::move(image));
+        return nullptr;
+    }
+    image->setValidRegion(QRect(0, 0, colorSpaceLutSize, 1));
+
+    mImageCache->insert(key, std::move(image));
+
+    return mImageCache->get(key);
+}
+
+std::unique_ptr<CsImage> VulkanRenderer::convertColorSpaceOnGpu(
+    CsImage* const image,
+    const QString& to)
+{
+    // Only outside of a job, and masks are converted
+    // on the CPU after they have been made gray
+    if (mFrameGraph->isRecording() || getNumChannels(image->getFormat()) != 4)
+        return nullptr;
+
+    OCIO::ConstCPUProcessorRcPtr processor =
+        mColorProcessors.get(mOcioConfig, "linear", to, mColorOptimization);
+    if (!processor || processor->isNoOp())
+        return nullptr;
+
+    mFrameGraph->begin();
+
+    ColorSpaceLutDomain domain;
+    CsImage* lut = getColorSpaceLut("linear", to, domain);
+
+    vk::Pipeline pipeline;
+    if (lut)
+    {
+        pipeline = getGeneratedPipeline(
+            "colorspace:" + QString::fromLatin1(getColorSpaceLutSignature(domain, colorSpaceLutSize)),
+            generateColorSpaceLutShader(domain, colorSpaceLutSize));
+    }
+
+    std::unique_ptr<CsImage> converted;
+    if (pipeline)
+    {
+        const QRect region(0, 0, image->getWidth(), image->getHeight());
+
+        converted = mImagePool->acquire(
+            image->getWidth(), image->getHeight(), false, globalImageFormat, "Color Space Conversion");
+        mFrameGraph->addDispatch(pipeline, image, lut, converted.get(), {}, region);
+        converted->setValidRegion(region);
+    }
+
+    if (!mFrameGraph->submit())
+        return nullptr;
+
+    return converted;
+}
+
 void VulkanRenderer::createComputeDescriptors()
 {
     // TODO: Clean this up.
@@ -505,7 +911,7 @@ void VulkanRenderer::createComputeDescriptors()
         bindings.at(2).stageFlags      = vk::ShaderStageFlagBits::eCompute;
 
         bindings.at(3).binding         = 3;
-        bindings.at(3).descriptorType  = vk::DescriptorType::eUniformBuffer;
+        bindings.at(3).descriptorType  = vk::DescriptorType::eUniformBufferDynamic;
         bindings.at(3).descriptorCount = 1;
         bindings.at(3).stageFlags      = vk::ShaderStageFlagBits::eCompute;
 
@@ -536,39 +942,42 @@ void VulkanRenderer::createComputeDescriptors()
         std::move(mDevice.allocateDescriptorSetsUnique(descSetAllocInfoCompute).value.front());
 }
 
-void VulkanRenderer::updateGraphicsDescriptors(
-    const CsImage* const outputImage,
-    const CsImage* const upstreamImage)
+void VulkanRenderer::updateGraphicsDescriptors(const int frame)
 {
-    for (int i = 0; i < mConcurrentFrameCount; ++i)
-    {
-        std::vector<vk::WriteDescriptorSet> descWrite(3);
-        descWrite.at(0).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(0).dstBinding      = 0;
-        descWrite.at(0).descriptorCount = 1;
-        descWrite.at(0).descriptorType  = vk::DescriptorType::eUniformBuffer;
-        descWrite.at(0).pBufferInfo     = &mUniformBufferInfo[i];
-
-        vk::DescriptorImageInfo descImageInfo(
-            *mSampler, *outputImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-
-        descWrite.at(1).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(1).dstBinding      = 1;
-        descWrite.at(1).descriptorCount = 1;
-        descWrite.at(1).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
-        descWrite.at(1).pImageInfo      = &descImageInfo;
-
-        vk::DescriptorImageInfo descImageInfoUpstream(
-            *mSampler, *upstreamImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-
-        descWrite.at(2).dstSet          = *mGraphicsDescriptorSet.at(i);
-        descWrite.at(2).dstBinding      = 2;
-        descWrite.at(2).descriptorCount = 1;
-        descWrite.at(2).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
-        descWrite.at(2).pImageInfo      = &descImageInfoUpstream;
-
-        mDevice.updateDescriptorSets(descWrite, {});
-    }
+    // Only the set of the frame being recorded is free to change
+    if (!mGraphicsDescriptorIsStale[frame] || mDrawnImages.empty())
+        return;
+    mGraphicsDescriptorIsStale[frame] = false;
+
+    const CsImage* const outputImage   = mDrawnImages.at(0);
+    const CsImage* const upstreamImage = mDrawnImages.at(1);
+
+    std::vector<vk::WriteDescriptorSet> descWrite(3);
+    descWrite.at(0).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(0).dstBinding      = 0;
+    descWrite.at(0).descriptorCount = 1;
+    descWrite.at(0).descriptorType  = vk::DescriptorType::eUniformBuffer;
+    descWrite.at(0).pBufferInfo     = &mUniformBufferInfo[frame];
+
+    vk::DescriptorImageInfo descImageInfo(
+        *mSampler, *outputImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    descWrite.at(1).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(1).dstBinding      = 1;
+    descWrite.at(1).descriptorCount = 1;
+    descWrite.at(1).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+    descWrite.at(1).pImageInfo      = &descImageInfo;
+
+    vk::DescriptorImageInfo descImageInfoUpstream(
+        *mSampler, *upstreamImage->getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    descWrite.at(2).dstSet          = *mGraphicsDescriptorSet.at(frame);
+    descWrite.at(2).dstBinding      = 2;
+    descWrite.at(2).descriptorCount = 1;
+    descWrite.at(2).descriptorType  = vk::DescriptorType::eCombinedImageSampler;
+    descWrite.at(2).pImageInfo      = &descImageInfoUpstream;
+
+    mDevice.updateDescriptorSets(descWrite, {});
 }
 
 void VulkanRenderer::updateComputeDescriptors(
@@ -576,9 +985,6 @@ void VulkanRenderer::updateComputeDescriptors(
     const CsImage* const inputImageFront,
     const CsImage* const outputImage)
 {
-    auto result = mDevice.waitIdle();
-    Q_UNUSED(result);
-
     vk::DescriptorImageInfo sourceInfoBack(
         *mSampler, *inputImageBack->getImageView(), vk::ImageLayout::eGeneral);
 
@@ -593,7 +999,8 @@ void VulkanRenderer::updateComputeDescriptors(
     vk::DescriptorImageInfo destinationInfo(
         {}, *outputImage->getImageView(), vk::ImageLayout::eGeneral);
 
-    vk::DescriptorBufferInfo settingsBufferInfo(*mSettingsBuffer->getBuffer(), 0, VK_WHOLE_SIZE);
+    vk::DescriptorBufferInfo settingsBufferInfo(
+        *mSettingsBuffer->getBuffer(), 0, CsSettingsBuffer::getRange());
 
     std::vector<vk::WriteDescriptorSet> descWrite(4);
 
@@ -618,7 +1025,7 @@ void VulkanRenderer::updateComputeDescriptors(
     descWrite.at(3).dstSet          = *mComputeDescriptorSet;
     descWrite.at(3).dstBinding      = 3;
     descWrite.at(3).descriptorCount = 1;
-    descWrite.at(3).descriptorType  = vk::DescriptorType::eUniformBuffer;
+    descWrite.at(3).descriptorType  = vk::DescriptorType::eUniformBufferDynamic;
     descWrite.at(3).pBufferInfo     = &settingsBufferInfo;
 
     mDevice.updateDescriptorSets(descWrite, {});
@@ -626,28 +1033,39 @@ void VulkanRenderer::updateComputeDescriptors(
 
 void VulkanRenderer::createComputePipelineLayout()
 {
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, 1, &(*mComputeDescriptorSetLayout));
+    // Generated shaders with few settings read them from push constants
+    vk::PushConstantRange pushConstantRange(
+        vk::ShaderStageFlagBits::eCompute, 0, maxPushConstantSettings * sizeof(float));
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
+        {}, 1, &(*mComputeDescriptorSetLayout), 1, &pushConstantRange);
 
     //Create the layout, store it to share between shaders
     mComputePipelineLayout = mDevice.createPipelineLayoutUnique(pipelineLayoutInfo).value;
 }
 
-void VulkanRenderer::createComputePipelines()
-{
-    //    for (int i = 0; i != static_cast<int>(NodeType::eLast); i++)
-    //    {
-    //        NodeType nodeType = static_cast<NodeType>(i);
-
-    //        mPipelines[nodeType] = createComputePipeline(mShaders[nodeType].get());
-    //    }
-}
-
-vk::UniquePipeline VulkanRenderer::createComputePipeline(const vk::ShaderModule& shaderModule)
+vk::UniquePipeline VulkanRenderer::createComputePipeline(
+    const vk::ShaderModule& shaderModule,
+    const std::vector<uint32_t>& specialization)
 {
     vk::PipelineShaderStageCreateInfo computeStage(
         {}, vk::ShaderStageFlagBits::eCompute, shaderModule, "main");
 
-    vk::ComputePipelineCreateInfo pipelineInfo({}, computeStage, *mComputePipelineLayout);
+    // The values are for the constants with the ids 0, 1, 2...
+    std::vector<vk::SpecializationMapEntry> entries;
+    for (uint32_t i = 0; i < specialization.size(); ++i)
+        entries.emplace_back(i, i * sizeof(uint32_t), sizeof(uint32_t));
+
+    vk::SpecializationInfo specializationInfo(
+        entries.size(), entries.data(), specialization.size() * sizeof(uint32_t), specialization.data());
+    if (!specialization.empty())
+        computeStage.pSpecializationInfo = &specializationInfo;
+
+    vk::PipelineCreateFlags flags;
+    if (mHasDispatchBase)
+        flags |= vk::PipelineCreateFlagBits::eDispatchBase;
+
+    vk::ComputePipelineCreateInfo pipelineInfo(flags, computeStage, *mComputePipelineLayout);
 
     vk::UniquePipeline pl =
         mDevice.createComputePipelineUnique(*mPipelineCache, pipelineInfo).value;
@@ -655,51 +1073,136 @@ vk::UniquePipeline VulkanRenderer::createComputePipeline(const vk::ShaderModule&
     return pl;
 }
 
-void VulkanRenderer::createQueryPool()
+vk::Pipeline VulkanRenderer::getComputePipeline(
+    const QString& shaderPath,
+    const std::vector<uint32_t>& specialization)
 {
-    vk::QueryPoolCreateInfo queryPoolInfo({}, vk::QueryType::eTimestamp, 2);
+    QString key = shaderPath;
+    for (auto value : specialization)
+        key += ":" + QString::number(value);
 
-    mQueryPool = mDevice.createQueryPoolUnique(queryPoolInfo).value;
+    auto it = mPipelines.find(key);
+    if (it != mPipelines.end())
+        return it->second;
+
+    // Shaders that ship their source are compiled from it
+    QString sourcePath = shaderPath;
+    sourcePath.replace("_comp.spv", ".comp");
+
+    QFile source(sourcePath);
+    if (sourcePath == shaderPath || !source.open(QIODevice::ReadOnly))
+    {
+        return mPipelines[key] =
+            mPipelineRegistry->getPipeline(readShaderFile(shaderPath), specialization);
+    }
+
+    if (!mCompiler.compileGLSLFromCode(source.readAll().toStdString(), "comp"))
+    {
+        CS_LOG_WARNING("Could not compile shader " + sourcePath + ":");
+        CS_LOG_WARNING(QString::fromStdString(mCompiler.getError()));
+        mPipelines[key] = nullptr;
+        return nullptr;
+    }
+
+    return mPipelines[key] = mPipelineRegistry->getPipeline(mCompiler.getSpirV(), specialization);
+}
+
+vk::Pipeline VulkanRenderer::getTaskPipeline(const RenderTask* task)
+{
+    const std::vector<uint32_t> specialization = task->getSpecialization();
+
+    if (auto code = task->getShaderCode())
+        return mPipelineRegistry->getPipeline(code, specialization);
+
+    return getComputePipeline(task->getShaderPath(), specialization);
 }
 
-bool VulkanRenderer::writeLinearImage(
-    float* imgStart,
-    QSize imgSize,
-    std::unique_ptr<CsImage>& image)
+vk::Pipeline VulkanRenderer::getFusedPipeline(const PointwiseChain& chain)
 {
-    vk::ImageSubresource subres(
-        vk::ImageAspectFlagBits::eColor,
-        0, // mip level
-        0);
+    const QString key = "fused:" + QString::fromLatin1(getFusedSignature(chain).toHex());
+
+    // Only generated when it isn't known yet
+    auto it = mPipelines.find(key);
+    if (it != mPipelines.end())
+        return it->second;
+
+    return getGeneratedPipeline(key, generateFusedShader(chain));
+}
 
-    vk::SubresourceLayout layout = mDevice.getImageSubresourceLayout(*image->getImage(), subres);
+vk::Pipeline VulkanRenderer::getGeneratedPipeline(const QString& key, const QString& shader)
+{
+    // Also remembers the shaders that failed, as a null handle
+    auto it = mPipelines.find(key);
+    if (it != mPipelines.end())
+        return it->second;
 
-    float* p;
-    vk::Result err = mDevice.mapMemory(
-        *image->getMemory(), layout.offset, layout.size, {}, reinterpret_cast<void**>(&p));
-    if (err != vk::Result::eSuccess)
+    if (!mCompiler.compileGLSLFromCode(shader.toStdString(), "comp"))
     {
-        CS_LOG_WARNING("Failed to map memory for linear image.");
-        return false;
+        CS_LOG_WARNING("Could not compile generated shader " + key + ":");
+        CS_LOG_WARNING(QString::fromStdString(mCompiler.getError()));
+        mPipelines[key] = nullptr;
+        return nullptr;
+    }
+
+    return mPipelines[key] = mPipelineRegistry->getPipeline(mCompiler.getSpirV());
+}
+
+void VulkanRenderer::checkImageFormats()
+{
+    // QVulkanWindow enables all the features the device supports
+    const vk::PhysicalDeviceFeatures features = mPhysicalDevice.getFeatures();
+
+    mHasFormatlessStorage = features.shaderStorageImageReadWithoutFormat &&
+                            features.shaderStorageImageWriteWithoutFormat;
+    if (!mHasFormatlessStorage)
+        CS_LOG_WARNING("Device can't use storage images without format, rendering in full float.");
+
+    // Single channel half float storage is optional
+    const vk::FormatFeatureFlags maskFeatures =
+        vk::FormatFeatureFlagBits::eStorageImage | vk::FormatFeatureFlagBits::eSampledImage;
+    vk::FormatProperties props = mPhysicalDevice.getFormatProperties(vk::Format::eR16Sfloat);
+
+    mMaskFormat = (props.optimalTilingFeatures & maskFeatures) == maskFeatures
+                      ? vk::Format::eR16Sfloat
+                      : vk::Format::eR16G16B16A16Sfloat;
+
+    // 16 bit normalized storage needs the extended formats
+    const vk::FormatFeatureFlags uploadFeatures =
+        maskFeatures | vk::FormatFeatureFlagBits::eTransferDst;
+    for (const auto depth : { UploadDepth::eUInt8, UploadDepth::eUInt16, UploadDepth::eHalf })
+    {
+        props = mPhysicalDevice.getFormatProperties(getUploadFormat(depth));
+
+        mHasUploadDepth[static_cast<int>(depth)] =
+            (props.optimalTilingFeatures & uploadFeatures) == uploadFeatures;
     }
+}
+
+vk::Format VulkanRenderer::getImageFormat(const RenderTask* task) const
+{
+    if (!mHasFormatlessStorage)
+        return globalImageFormat;
 
-    int pad = (layout.rowPitch - imgSize.width() * 16) / 4;
+    ImagePrecision precision = task ? task->getPrecision() : ImagePrecision::eDefault;
+    if (precision == ImagePrecision::eDefault)
+        precision = mImagePrecision;
 
-    // TODO: Parallelize this
-    float* pixels = imgStart;
-    int lineWidth = imgSize.width() * 16; // 4 channels * 4 bytes
-    int w         = imgSize.width();
-    int h         = imgSize.height();
-    for (int y = 0; y < h; ++y)
+    switch (precision)
     {
-        memcpy(p, pixels, lineWidth);
-        pixels += w * 4;
-        p += w * 4 + pad;
+        case ImagePrecision::eHalf:
+            return vk::Format::eR16G16B16A16Sfloat;
+        case ImagePrecision::eMask:
+            return mMaskFormat;
+        default:
+            return globalImageFormat;
     }
+}
 
-    mDevice.unmapMemory(*image->getMemory());
+void VulkanRenderer::createQueryPool()
+{
+    vk::QueryPoolCreateInfo queryPoolInfo({}, vk::QueryType::eTimestamp, 2);
 
-    return true;
+    mQueryPool = mDevice.createQueryPoolUnique(queryPoolInfo).value;
 }
 
 void VulkanRenderer::updateVertexData(const int w, const int h)
@@ -728,6 +1231,8 @@ void VulkanRenderer::initSwapChainResources()
         -1.0f,
         100.0f);
     mProjection.scale(500);
+
+    emit mWindow->viewChanged();
 }
 
 void VulkanRenderer::setDisplayMode(const DisplayMode mode)
@@ -741,37 +1246,62 @@ bool VulkanRenderer::saveImageToDisk(
     const QMap<std::string, std::string>& attributes,
     const int colorSpace)
 {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
     bool success = true;
 
-    auto mem = mComputeCommandBuffer->recordImageSave(inputImage);
+    // Converted on the GPU if a LUT is close enough to the transform
+    auto converted            = convertColorSpaceOnGpu(inputImage, colorSpaces.at(colorSpace));
+    const bool convertedOnGpu = converted != nullptr;
+    CsImage* const saveInput  = convertedOnGpu ? converted.get() : inputImage;
+
+    const void* pInput = mComputeCommandBuffer->recordImageSave(saveInput);
+    if (!pInput)
+    {
+        CS_LOG_WARNING("Failed to map memory.");
+        mImagePool->release(std::move(converted));
+        return false;
+    }
 
     mComputeCommandBuffer->submitImageSave();
 
     auto result = mDevice.waitIdle();
+    Q_UNUSED(result);
 
-    float* pInput;
-    result = mDevice.mapMemory(*mem, 0, VK_WHOLE_SIZE, {}, reinterpret_cast<void**>(&pInput));
-    if (result != vk::Result::eSuccess)
-        CS_LOG_WARNING("Failed to map memory.");
+    const vk::Format format = saveInput->getFormat();
 
-    int width     = inputImage->getWidth();
-    int height    = inputImage->getHeight();
-    int numValues = width * height * 4;
+    const uint32_t numChannels = getNumChannels(format);
+    const bool isHalf          = getBytesPerPixel(format) / numChannels == 2;
 
-    float* output  = new float[numValues];
-    float* pOutput = &output[0];
+    OIIO::ImageSpec spec(
+        saveInput->getWidth(),
+        saveInput->getHeight(),
+        numChannels,
+        isHalf ? OIIO::TypeDesc::HALF : OIIO::TypeDesc::FLOAT);
+    const ImageBuf mapped(spec, const_cast<void*>(pInput));
 
-    parallelArrayCopy(pInput, pOutput, width, height);
+    // The color transform expects four float channels
+    std::unique_ptr<ImageBuf> saveImage = std::unique_ptr<ImageBuf>(new ImageBuf());
+    saveImage->copy(mapped, OIIO::TypeDesc::FLOAT);
+    mImagePool->release(std::move(converted));
+
+    // Masks are saved as gray
+    if (saveImage->nchannels() == 1)
+    {
+        int channelorder[]    = {0, 0, 0, -1};
+        float channelvalues[] = {0 /*ignore*/, 0 /*ignore*/, 0 /*ignore*/, 1.0};
+
+        *saveImage = OIIO::ImageBufAlgo::channels(*saveImage, 4, channelorder, channelvalues);
+    }
 
-    OIIO::ImageSpec spec(width, height, 4, OIIO::TypeDesc::FLOAT);
     QMap<std::string, std::string>::const_iterator it;
     for (it = attributes.begin(); it != attributes.end(); ++it)
     {
-        spec.attribute(it.key(), it.value());
+        saveImage->specmod().attribute(it.key(), it.value());
     }
-    std::unique_ptr<ImageBuf> saveImage = std::unique_ptr<ImageBuf>(new ImageBuf(spec, output));
 
-    transformColorSpace("linear", colorSpaces.at(colorSpace), *saveImage);
+    if (!convertedOnGpu)
+        transformColorSpace("linear", colorSpaces.at(colorSpace), *saveImage);
 
     success = saveImage->write(path.toStdString());
 
@@ -780,66 +1310,112 @@ bool VulkanRenderer::saveImageToDisk(
         CS_LOG_INFO("Problem saving image." + QString::fromStdString(saveImage->geterror()));
     }
 
-    delete[] output;
-
-    mDevice.unmapMemory(*mem);
-
     return success;
 }
 
-void VulkanRenderer::createRenderPass()
+bool VulkanRenderer::copyTaskImage(
+    const RenderTask* task,
+    const QRect& rect,
+    ImageBuf& destination,
+    const QPoint& position,
+    const int colorSpace)
 {
-    vk::CommandBuffer cb = mWindow->currentCommandBuffer();
-
-    const QSize sz = mWindow->swapChainImageSize();
-
-    // Clear background
-    vk::ClearDepthStencilValue clearDS = {1, 0};
-    vk::ClearValue clearValues[2];
-    clearValues[0].color        = clearColor;
-    clearValues[1].depthStencil = clearDS;
-
-    vk::RenderPassBeginInfo rpBeginInfo;
-    rpBeginInfo.renderPass               = mWindow->defaultRenderPass();
-    rpBeginInfo.framebuffer              = mWindow->currentFramebuffer();
-    rpBeginInfo.renderArea.extent.width  = sz.width();
-    rpBeginInfo.renderArea.extent.height = sz.height();
-    rpBeginInfo.clearValueCount          = 2;
-    rpBeginInfo.pClearValues             = clearValues;
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
 
-    cb.beginRenderPass(rpBeginInfo, vk::SubpassContents::eInline);
+    CsImage* image = getTaskImage(task);
+    if (!image)
+        return false;
 
-    // TODO: Can we do this once?
-    quint8* p;
-    vk::Result err = mDevice.mapMemory(
-        *mVertexBufferMemory,
-        mUniformBufferInfo[mWindow->currentFrame()].offset,
-        uniformDataSize,
-        {},
-        reinterpret_cast<void**>(&p));
+    // Converted on the GPU if a LUT is close enough to the transform
+    auto converted            = convertColorSpaceOnGpu(image, colorSpaces.at(colorSpace));
+    const bool convertedOnGpu = converted != nullptr;
+    if (convertedOnGpu)
+        image = converted.get();
 
-    if (err != vk::Result::eSuccess)
+    const void* pInput = mComputeCommandBuffer->recordImageSave(image);
+    if (!pInput)
     {
-        CS_LOG_WARNING("Failed to map memory for vertex buffer.");
+        CS_LOG_WARNING("Failed to map memory.");
+        mImagePool->release(std::move(converted));
+        return false;
     }
 
-    QMatrix4x4 m = mProjection;
+    mComputeCommandBuffer->submitImageSave();
 
-    QMatrix4x4 rotation;
-    rotation.setToIdentity();
+    auto result = mDevice.waitIdle();
+    Q_UNUSED(result);
 
-    QMatrix4x4 translation;
-    translation.setToIdentity();
-    translation.translate(mPositionX, mPositionY, mPositionZ);
+    const vk::Format format = image->getFormat();
 
-    QMatrix4x4 scale;
-    scale.setToIdentity();
-    scale.scale(mScaleXY, mScaleXY, mScaleXY);
+    const uint32_t numChannels = getNumChannels(format);
+    const bool isHalf          = getBytesPerPixel(format) / numChannels == 2;
+
+    OIIO::ImageSpec spec(
+        image->getWidth(),
+        image->getHeight(),
+        numChannels,
+        isHalf ? OIIO::TypeDesc::HALF : OIIO::TypeDesc::FLOAT);
+    const ImageBuf mapped(spec, const_cast<void*>(pInput));
+
+    // The pixels have been copied out of it
+    mImagePool->release(std::move(converted));
+
+    ImageBuf part;
+    part.copy(
+        OIIO::ImageBufAlgo::cut(
+            mapped,
+            OIIO::ROI(rect.left(), rect.right() + 1, rect.top(), rect.bottom() + 1)),
+        OIIO::TypeDesc::FLOAT);
+
+    // Masks are shown as gray
+    if (part.nchannels() == 1)
+    {
+        int channelorder[]    = {0, 0, 0, -1};
+        float channelvalues[] = {0 /*ignore*/, 0 /*ignore*/, 0 /*ignore*/, 1.0};
+
+        part = OIIO::ImageBufAlgo::channels(part, 4, channelorder, channelvalues);
+    }
+
+    if (!convertedOnGpu)
+        transformColorSpace("linear", colorSpaces.at(colorSpace), part);
+
+    return OIIO::ImageBufAlgo::paste(destination, position.x(), position.y(), 0, 0, part);
+}
+
+void VulkanRenderer::createRenderPass()
+{
+    vk::CommandBuffer cb = mWindow->currentCommandBuffer();
+
+    const QSize sz = mWindow->swapChainImageSize();
+
+    // Clear background
+    vk::ClearDepthStencilValue clearDS = {1, 0};
+    vk::ClearValue clearValues[2];
+    clearValues[0].color        = clearColor;
+    clearValues[1].depthStencil = clearDS;
+
+    vk::RenderPassBeginInfo rpBeginInfo;
+    rpBeginInfo.renderPass               = mWindow->defaultRenderPass();
+    rpBeginInfo.framebuffer              = mWindow->currentFramebuffer();
+    rpBeginInfo.renderArea.extent.width  = sz.width();
+    rpBeginInfo.renderArea.extent.height = sz.height();
+    rpBeginInfo.clearValueCount          = 2;
+    rpBeginInfo.pClearValues             = clearValues;
+
+    cb.beginRenderPass(rpBeginInfo, vk::SubpassContents::eInline);
 
-    m = m * translation * scale;
+    // The vertex buffer stays mapped, the slot of this
+    // frame is not used by the frames still in flight
+    const int frame = mWindow->currentFrame();
+    quint8* pData   = static_cast<quint8*>(mVertexBufferAllocation.getMappedData());
 
-    memcpy(p, m.constData(), 16 * sizeof(float));
-    mDevice.unmapMemory(*mVertexBufferMemory);
+    updateGraphicsDescriptors(frame);
+
+    memcpy(pData + mVertexOffsets[frame], vertexData, sizeof(vertexData));
+
+    const QMatrix4x4 m = getViewMatrix();
+
+    memcpy(pData + mUniformBufferInfo[frame].offset, m.constData(), 16 * sizeof(float));
 
     // Choose to either display RGB or Alpha
     vk::Pipeline* pl;
@@ -859,11 +1435,10 @@ void VulkanRenderer::createRenderPass()
         vk::PipelineBindPoint::eGraphics,
         *mGraphicsPipelineLayout,
         0,
-        *mGraphicsDescriptorSet.at(mWindow->currentFrame()),
+        *mGraphicsDescriptorSet.at(frame),
         {});
 
-    vk::DeviceSize vbOffset = 0;
-    cb.bindVertexBuffers(0, 1, &mVertexBuffer.get(), &vbOffset);
+    cb.bindVertexBuffers(0, 1, &mVertexBuffer.get(), &mVertexOffsets[frame]);
 
     //negative viewport
     vk::Viewport viewport;
@@ -886,248 +1461,729 @@ void VulkanRenderer::createRenderPass()
     cb.endRenderPass();
 }
 
+QMatrix4x4 VulkanRenderer::getViewMatrix() const
+{
+    QMatrix4x4 translation;
+    translation.setToIdentity();
+    translation.translate(mPositionX, mPositionY, mPositionZ);
+
+    QMatrix4x4 scale;
+    scale.setToIdentity();
+    scale.scale(mScaleXY, mScaleXY, mScaleXY);
+
+    return mProjection * translation * scale;
+}
+
+QRectF VulkanRenderer::getVisibleRegion() const
+{
+    // Corners of the window in the space of the quad
+    const QMatrix4x4 inverse = getViewMatrix().inverted();
+    const QPointF a          = inverse.map(QPointF(-1.0, -1.0));
+    const QPointF b          = inverse.map(QPointF(1.0, 1.0));
+
+    // The quad is 0.004 units per pixel around the center of the image,
+    // see updateVertexData(). Its y axis points up, that of the image down.
+    const qreal unitsPerPixel = 0.004;
+
+    return QRectF(
+        QPointF(a.x() / unitsPerPixel, -a.y() / unitsPerPixel),
+        QPointF(b.x() / unitsPerPixel, -b.y() / unitsPerPixel)).normalized();
+}
+
+int VulkanRenderer::getMaxTileSize() const
+{
+    vk::DeviceSize heapSize = 0;
+    auto memoryProperties   = mPhysicalDevice.getMemoryProperties();
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        const auto& heap = memoryProperties.memoryHeaps[i];
+        if (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            heapSize = std::max(heapSize, heap.size);
+    }
+
+    // Square tiles of the biggest format the results have
+    const double pixels = static_cast<double>(heapSize) /
+                          (tileMemoryDivisor * getBytesPerPixel(globalImageFormat));
+    const int size = static_cast<int>(std::sqrt(pixels)) / workGroupSize * workGroupSize;
+
+    const int maxDimension = mPhysicalDevice.getProperties().limits.maxImageDimension2D;
+
+    return std::min(size, maxDimension);
+}
+
+float VulkanRenderer::getFittingScale(const QSize& size) const
+{
+    const int maxSize = getMaxTileSize();
+    const int longest = std::max(size.width(), size.height());
+
+    float scale = 1.0f;
+    while (maxSize > 0 && longest * scale > maxSize)
+        scale *= 0.5f;
+
+    return scale;
+}
+
+QSize VulkanRenderer::getImageFileSize(const QString& path)
+{
+    auto input = OIIO::ImageInput::open(path.toStdString());
+    if (!input)
+        return QSize();
+
+    const OIIO::ImageSpec& spec = input->spec();
+
+    return QSize(spec.width, spec.height);
+}
+
 void VulkanRenderer::setViewerPushConstants(const QString& s)
 {
     mViewerPushConstants = unpackPushConstants(s);
 }
 
-void VulkanRenderer::processReadNode( [[maybe_unused]] NodeBase* node)
-{
-    //    auto parts = node->getAllPropertyValues().split(",");
-    //    int index = parts[parts.size() - 2].toInt();
-    //    if ( index < 0 )
-    //        index = 0;
-    //    QString path = parts[index];
-    //    int colorSpace = parts.last().toInt();
-
-    //    QFileInfo checkFile(path);
-
-    //    if(path != "" && checkFile.exists() && checkFile.isFile())
-    //    {
-    //        mImagePath = path;
-
-    //        // Create texture
-    //        if (!createImageFromFile(mImagePath, colorSpace))
-    //            CS_LOG_WARNING("Failed to create texture");
-
-    //        mTmpCacheImage = std::unique_ptr<CsImage>(
-    //                    new CsImage(mWindow,
-    //                                &mDevice,
-    //                                &mPhysicalDevice,
-    //                                mCpuImage->xend(),
-    //                                mCpuImage->yend(),
-    //                                false,
-    //                                "Tmp Cache Image"));
-
-    //        // Create render target
-    //        if (!createComputeRenderTarget(mCpuImage->xend(), mCpuImage->yend()))
-    //            CS_LOG_WARNING("Failed to create compute render target.");
+bool VulkanRenderer::processReadTask(RenderTaskRead* task)
+{
+    std::unique_lock<std::recursive_mutex> lock(mMutex);
+
+    // The same file has been loaded before
+    if (getTaskImage(task))
+        return true;
+
+    const QString& path = task->getPath();
+
+    QFileInfo checkFile(path);
+
+    if (path.isEmpty() || !checkFile.exists() || !checkFile.isFile())
+        return false;
+
+    vk::Pipeline pipeline;
+    CsImage* colorSpaceLut = nullptr;
+    auto tmpImage          = uploadImageFromFile(task, pipeline, colorSpaceLut, lock);
+    if (!tmpImage)
+    {
+        CS_LOG_WARNING("Failed to create texture");
+        return false;
+    }
+
+    const QSize size(tmpImage->getWidth(), tmpImage->getHeight());
+
+    // Create render target
+    const vk::Format format = getImageFormat(task);
+    const bool isCached     = isCachedResult(task, size);
+    if (isCached)
+    {
+        if (!createComputeRenderTarget(size.width(), size.height(), format))
+            CS_LOG_WARNING("Failed to create compute render target.");
+    }
+    else
+    {
+        mComputeRenderTarget = createTransientImage(task, size, format, false);
+    }
+
+    // The whole file is loaded anyway
+    const QRect region(QPoint(0, 0), size);
+
+    mFrameGraph->addDispatch(
+        pipeline,
+        tmpImage.get(),
+        colorSpaceLut,
+        mComputeRenderTarget.get(),
+        task->getSettings(),
+        region);
+    mComputeRenderTarget->setValidRegion(region);
+
+    // Only needed until the recorded commands have run
+    mFrameGraph->keepAlive(std::move(tmpImage));
 
-    //        updateComputeDescriptors(mTmpCacheImage.get(), nullptr, mComputeRenderTarget.get());
-
-    //        mComputeCommandBuffer->recordImageLoad(
-    //                    mLoadImageStaging.get(),
-    //                    mTmpCacheImage.get(),
-    //                    mComputeRenderTarget.get(),
-    //                    &mPipelines[NodeType::eRead].get());
-
-    //        mComputeCommandBuffer->submitImageLoad();
-
-    //        node->setCachedImage(std::move(mComputeRenderTarget));
-
-    //        // Delete the staging image
-    //        auto result = mDevice.waitIdle();
-    //        Q_UNUSED(result);
-
-    //        mLoadImageStaging = nullptr;
-    //    }
-    //    else
-    //    {
-    //        node->flushCache();
-    //    }
-}
-
-void VulkanRenderer::processNode(
-     [[maybe_unused]] NodeBase* node,
-     [[maybe_unused]] CsImage* inputImageBack,
-     [[maybe_unused]] CsImage* inputImageFront,
-     [[maybe_unused]] const QSize targetSize)
-{
-    //    auto result = mDevice.waitIdle();
-
-    //    fillSettingsBuffer(node);
-
-    //    if (!createComputeRenderTarget(targetSize.width(), targetSize.height()))
-    //        CS_LOG_WARNING("Failed to create compute render target.");
-
-    //    // Tells the shader if we have a mask on the front input
-    //    mSettingsBuffer->appendValue(0.0);
-    //    if (inputImageFront)
-    //    {
-    //        mSettingsBuffer->incrementLastValue();
-    //    }
-
-    //    // TODO: This is a workaround for generative nodes without input
-    //    // but needs to be fixed
-    //    if (!inputImageBack)
-    //    {
-    //        mTmpCacheImage = std::unique_ptr<CsImage>(
-    //                    new CsImage(mWindow,
-    //                                &mDevice,
-    //                                &mPhysicalDevice,
-    //                                targetSize.width(),
-    //                                targetSize.height(),
-    //                                false,
-    //                                "Tmp Cache Image"));
-    //        inputImageBack = mTmpCacheImage.get();
-    //    }
-
-    //    auto pipeline = mPipelines[node->getType()].get();
-
-    //    auto nodeType = node->getType();
-
-    //    if (nodeType == NodeType::eShader || nodeType == NodeType::eIsf)
-    //    {
-    //        if (node->getShaderCode().size() != 0)
-    //        {
-    //            mShaderUser = createShaderFromCode(node->getShaderCode());
-
-    //            mComputePipelineUser = createComputePipeline(mShaderUser.get());
-
-    //            pipeline = mComputePipelineUser.get();
-    //        }
-    //        else
-    //        {
-    //            pipeline = mComputePipelineNoop.get();
-    //        }
-    //    }
-
-    //    int numShaderPasses = getPropertiesForType(node->getType()).numShaderPasses;
-    //    int currentShaderPass = 1;
-
-    //    if (numShaderPasses == 1)
-    //    {
-    //        updateComputeDescriptors(inputImageBack, inputImageFront, mComputeRenderTarget.get());
-
-    //        mComputeCommandBuffer->recordGeneric(
-    //                    inputImageBack,
-    //                    inputImageFront,
-    //                    mComputeRenderTarget.get(),
-    //                    pipeline,
-    //                    numShaderPasses,
-    //                    currentShaderPass);
-
-    //        mComputeCommandBuffer->submitGeneric();
-
-    //        mWindow->requestUpdate();
-
-    //        result = mDevice.waitIdle();
-
-    //        node->setCachedImage(std::move(mComputeRenderTarget));
-    //    }
-    //    else
-    //    {
-    //        for (int i = 1; i <= numShaderPasses; ++i)
-    //        {
-    //            // TODO: Shorten this
-    //            if (currentShaderPass == 1)
-    //            {
-    //                // First pass of multipass shader
-    //                mSettingsBuffer->appendValue(0.0);
-
-    //                updateComputeDescriptors(inputImageBack, inputImageFront, mComputeRenderTarget.get());
-
-    //                mComputeCommandBuffer->recordGeneric(
-    //                            inputImageBack,
-    //                            inputImageFront,
-    //                            mComputeRenderTarget.get(),
-    //                            pipeline,
-    //                            numShaderPasses,
-    //                            currentShaderPass);
-
-    //                mComputeCommandBuffer->submitGeneric();
-    //            }
-    //            else if (currentShaderPass <= numShaderPasses)
-    //            {
-    //                // Subsequent passes
-    //                mSettingsBuffer->incrementLastValue();
-
-    //                if (!createComputeRenderTarget(targetSize.width(), targetSize.height()))
-    //                    CS_LOG_WARNING("Failed to create compute render target.");
-
-    //                updateComputeDescriptors(node->getCachedImage(), inputImageFront, mComputeRenderTarget.get());
-
-    //                mComputeCommandBuffer->recordGeneric(
-    //                            node->getCachedImage(),
-    //                            inputImageFront,
-    //                            mComputeRenderTarget.get(),
-    //                            pipeline,
-    //                            numShaderPasses,
-    //                            currentShaderPass);
-
-    //                mComputeCommandBuffer->submitGeneric();
-    //            }
-    //            currentShaderPass++;
-
-    //            result = mDevice.waitIdle();
-
-    //            node->setCachedImage(std::move(mComputeRenderTarget));
-    //        }
-
-    //        mWindow->requestUpdate();
-    //    }
-}
-
-void VulkanRenderer::displayNode( [[maybe_unused]] const NodeBase* node)
-{
-    //    if(CsImage* image = node->getCachedImage())
-    //    {
-    //        // Execute a NoOp shader on the node
-    //        mClearScreen = false;
-
-    //        updateVertexData(image->getWidth(), image->getHeight());
-    //        createVertexBuffer();
-
-    //        if (!createComputeRenderTarget(image->getWidth(), image->getHeight()))
-    //            CS_LOG_WARNING("Failed to create compute render target.");
-
-    //        CsImage* upstreamImage = nullptr;
-    //        if (node->getUpstreamNodeBack())
-    //            upstreamImage = node->getUpstreamNodeBack()->getCachedImage();
-    //        if (!upstreamImage)
-    //            upstreamImage = image;
-
-    //        updateGraphicsDescriptors(image, upstreamImage);
-    //        updateComputeDescriptors(image, nullptr, mComputeRenderTarget.get());
-
-    //        mComputeCommandBuffer->recordGeneric(
-    //                    image,
-    //                    nullptr,
-    //                    mComputeRenderTarget.get(),
-    //                    *mComputePipelineNoop,
-    //                    1,
-    //                    1);
-
-    //        mComputeCommandBuffer->submitGeneric();
-
-    //        mWindow->requestUpdate();
-    //    }
-    //    else
-    //    {
-    //        CS_LOG_INFO("Clearing screen");
-    //        doClearScreen();
-    //    }
+    storeTaskImage(task, std::move(mComputeRenderTarget), isCached);
+
+    return true;
+}
+
+bool VulkanRenderer::processTask(RenderTask* task)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    // Rendered along with the last task of its chain
+    if (mFusedTasks.count(task))
+        return true;
+
+    auto fused = mFusedChains.find(task);
+    if (fused != mFusedChains.end())
+        return processFusedChain(fused->second.first, fused->second.second);
+
+    CsImage* inputImageBack  = getTaskImage(task->getInput(0));
+    CsImage* inputImageFront = getTaskImage(task->getInput(1));
+
+    // Same inputs and settings as a result we still have,
+    // it might only lack the part that is needed now
+    if (CsImage* image = getTaskImage(task))
+    {
+        const QRegion missing =
+            QRegion(getTaskRegion(task, QSize(image->getWidth(), image->getHeight()))) -
+            image->getValidRegion();
+
+        if (missing.isEmpty())
+            return true;
+
+        // Passes in between would need more than the missing part.
+        // An image the viewer may still be sampling is not touched.
+        if (inputImageBack && task->getNumShaderPasses() == 1 && !isDrawnByFramesInFlight(image))
+        {
+            mFrameGraph->addDispatch(
+                getTaskPipeline(task),
+                inputImageBack,
+                inputImageFront,
+                image,
+                task->getSettings(),
+                missing);
+
+            image->setValidRegion(image->getValidRegion() + missing);
+
+            return true;
+        }
+
+        // Rendered anew below into another image,
+        // which replaces this one in the cache
+    }
+
+    QSize targetSize;
+    if (inputImageBack)
+        targetSize = QSize(inputImageBack->getWidth(), inputImageBack->getHeight());
+    else if (inputImageFront)
+        targetSize = QSize(inputImageFront->getWidth(), inputImageFront->getHeight());
+    else
+        return false;
+
+    return processNode(task, inputImageBack, inputImageFront, targetSize);
+}
+
+bool VulkanRenderer::isDrawnByFramesInFlight(const CsImage* image) const
+{
+    return image->getLastUse() + mConcurrentFrameCount > mFrameCount;
+}
+
+CsImage* VulkanRenderer::getTaskImage(const RenderTask* task)
+{
+    if (!task)
+        return nullptr;
+
+    // Results from before the precision was changed don't count
+    if (CsImage* image = mImageCache->get(task->getHash()))
+        return image->getFormat() == getImageFormat(task) ? image : nullptr;
+
+    auto it = mTransientResults.find(task->getHash());
+    if (it != mTransientResults.end())
+        return it->second;
+
+    return nullptr;
+}
+
+QRect VulkanRenderer::getTaskRegion(const RenderTask* task, const QSize& size) const
+{
+    const QRect image(QPoint(0, 0), size);
+
+    const QRectF& region = task->getRegion();
+    if (!mHasDispatchBase || region.isNull())
+        return image;
+
+    const qreal scale = task->getProxyScale();
+    const QRectF pixels(
+        region.x() * scale + size.width() / 2.0,
+        region.y() * scale + size.height() / 2.0,
+        region.width() * scale,
+        region.height() * scale);
+
+    return alignToWorkGroups(pixels.toAlignedRect() & image) & image;
+}
+
+bool VulkanRenderer::isCachedResult(const RenderTask* task, const QSize& size) const
+{
+    // What the viewer shows is always kept
+    const RenderTask* result = mCurrentJob ? mCurrentJob->getResult() : nullptr;
+    if (!result || task == result || task == result->getInput(0))
+        return true;
+
+    return mImageCache->hasRoomFor(
+        static_cast<uint64_t>(size.width()) * size.height() *
+        getBytesPerPixel(getImageFormat(task)));
+}
+
+int VulkanRenderer::getLastUse(const RenderTask* task) const
+{
+    const int lastUse = mCurrentJob->getLastUse(task);
+
+    auto it = mFusedLastUses.find(task);
+    if (it != mFusedLastUses.end())
+        return std::max(lastUse, it->second);
+
+    return lastUse;
+}
+
+std::unique_ptr<CsImage> VulkanRenderer::createTransientImage(
+    const RenderTask* task,
+    const QSize& size,
+    const vk::Format format,
+    const bool isTemporary)
+{
+    // A result lives until the last task reading it,
+    // a temporary image only while its task is executed
+    const int firstUse = mCurrentJob->getIndex(task);
+    const int lastUse  = isTemporary ? firstUse : getLastUse(task);
+
+    return mTransientMemory->createImage(
+        size.width(),
+        size.height(),
+        format,
+        firstUse,
+        lastUse,
+        isTemporary ? "Tmp Cache Image" : "Transient Result");
+}
+
+void VulkanRenderer::storeTaskImage(
+    const RenderTask* task,
+    std::unique_ptr<CsImage> image,
+    const bool isCached)
+{
+    if (isCached)
+    {
+        mImageCache->insert(task->getHash(), std::move(image));
+        return;
+    }
+
+    mTransientResults[task->getHash()] = image.get();
+    mFrameGraph->keepAlive(std::move(image));
+}
+
+void VulkanRenderer::beginEvaluation(const RenderJob& job)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    mCurrentJob = &job;
+
+    mImageCache->beginEpoch();
+
+    mFrameGraph->begin();
+
+    planFusion(job);
+}
+
+void VulkanRenderer::planFusion(const RenderJob& job)
+{
+    // The viewer shows the result along with its back input,
+    // and what is on screen now has to stay until it is replaced
+    const RenderTask* result = job.getResult();
+
+    auto hasResult   = [this](const RenderTask* task) { return getTaskImage(task) != nullptr; };
+    auto needsResult = [this, result](const RenderTask* task)
+    {
+        return task == result || task == result->getInput(0) ||
+               mDisplayedImages.contains(task->getHash());
+    };
+
+    for (auto& chain : findPointwiseChains(job, hasResult, needsResult, maxNumSettings))
+    {
+        vk::Pipeline pipeline = getFusedPipeline(chain);
+        if (!pipeline)
+            continue;
+
+        for (size_t i = 0; i + 1 < chain.size(); ++i)
+            mFusedTasks.insert(chain[i]);
+
+        const RenderTask* input = chain.front()->getInput(0);
+        const int lastIndex     = job.getIndex(chain.back());
+        mFusedLastUses[input]   = std::max(mFusedLastUses[input], lastIndex);
+
+        mFusedChains[chain.back()] = { std::move(chain), pipeline };
+    }
+}
+
+bool VulkanRenderer::endEvaluation()
+{
+    std::unique_lock<std::recursive_mutex> lock(mMutex);
+
+    mFusedChains.clear();
+    mFusedTasks.clear();
+    mFusedLastUses.clear();
+
+    bool success = mFrameGraph->submitWithoutWaiting();
+
+    // The viewer goes on drawing while the GPU works on the job,
+    // only frames with images the job uses wait for it
+    lock.unlock();
+    if (!mFrameGraph->wait())
+        success = false;
+    lock.lock();
+
+    mFrameGraph->reset();
+
+    // Nothing recorded uses the pipelines of deleted nodes anymore
+    mPipelineRegistry->purge();
+
+    // The transient images have been destroyed by the submission
+    mTransientResults.clear();
+    mTransientMemory->reset();
+
+    mCurrentJob = nullptr;
+
+    return success;
+}
+
+void VulkanRenderer::setImageCacheBudget(const uint64_t bytes)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    mImageCache->setBudget(bytes);
+}
+
+void VulkanRenderer::setImagePrecision(const ImagePrecision precision)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    mImagePrecision = precision;
+}
+
+void VulkanRenderer::setColorLutSize(const int size)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    mColorLutSize = size;
+}
+
+void VulkanRenderer::setColorOptimization(const OCIO::OptimizationFlags optimization)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    mColorOptimization = optimization;
+}
+
+void VulkanRenderer::setDisplayedTask(const RenderTask* task)
+{
+    for (auto& key : mDisplayedImages)
+        mImageCache->unpin(key);
+
+    mDisplayedImages.clear();
+
+    if (task)
+    {
+        mDisplayedImages.push_back(task->getHash());
+
+        if (task->getInput(0))
+            mDisplayedImages.push_back(task->getInput(0)->getHash());
+    }
+
+    for (auto& key : mDisplayedImages)
+        mImageCache->pin(key);
+}
+
+bool VulkanRenderer::processNode(
+    RenderTask* task,
+    CsImage* inputImageBack,
+    CsImage* inputImageFront,
+    const QSize targetSize)
+{
+    const std::vector<float>& settings = task->getSettings();
+
+    // TODO: This is a workaround for generative nodes without input
+    // but needs to be fixed
+    if (!inputImageBack)
+    {
+        auto tmpImage  = createTransientImage(task, targetSize, getImageFormat(task), true);
+        inputImageBack = tmpImage.get();
+        mFrameGraph->keepAlive(std::move(tmpImage));
+    }
+
+    vk::Pipeline pipeline = getTaskPipeline(task);
+
+    int numShaderPasses = task->getNumShaderPasses();
+
+    const vk::Format format = getImageFormat(task);
+    const bool isCached     = isCachedResult(task, targetSize);
+
+    // The last pass renders the region that is needed, the ones before
+    // it as much more as the next one reads around its pixels
+    const QRect image(QPoint(0, 0), targetSize);
+    const int margin = task->getInputMargin();
+
+    std::vector<QRect> regions(numShaderPasses);
+    regions.back() = getTaskRegion(task, targetSize);
+    for (int i = numShaderPasses - 2; i >= 0; --i)
+    {
+        regions[i] =
+            alignToWorkGroups(regions[i + 1].adjusted(-margin, -margin, margin, margin) & image) &
+            image;
+    }
+
+    if (numShaderPasses == 1)
+    {
+        if (isCached)
+        {
+            if (!createComputeRenderTarget(targetSize.width(), targetSize.height(), format))
+                CS_LOG_WARNING("Failed to create compute render target.");
+        }
+        else
+        {
+            mComputeRenderTarget = createTransientImage(task, targetSize, format, false);
+        }
+
+        mFrameGraph->addDispatch(
+            pipeline,
+            inputImageBack,
+            inputImageFront,
+            mComputeRenderTarget.get(),
+            settings,
+            regions.back());
+        mComputeRenderTarget->setValidRegion(regions.back());
+
+        storeTaskImage(task, std::move(mComputeRenderTarget), isCached);
+    }
+    else
+    {
+        // Subsequent passes read the result of the previous one
+        std::unique_ptr<CsImage> previousPass;
+
+        for (int i = 0; i < numShaderPasses; ++i)
+        {
+            const bool isLastPass = i == numShaderPasses - 1;
+
+            if (isLastPass && isCached)
+            {
+                if (!createComputeRenderTarget(
+                        targetSize.width(), targetSize.height(), format))
+                    CS_LOG_WARNING("Failed to create compute render target.");
+            }
+            else
+            {
+                mComputeRenderTarget =
+                    createTransientImage(task, targetSize, format, !isLastPass);
+            }
+
+            mFrameGraph->addDispatch(
+                pipeline,
+                previousPass ? previousPass.get() : inputImageBack,
+                inputImageFront,
+                mComputeRenderTarget.get(),
+                settings,
+                regions[i],
+                false,
+                i);
+            mComputeRenderTarget->setValidRegion(regions[i]);
+
+            if (previousPass)
+                mFrameGraph->keepAlive(std::move(previousPass));
+
+            previousPass = std::move(mComputeRenderTarget);
+        }
+
+        storeTaskImage(task, std::move(previousPass), isCached);
+    }
+
+    return true;
+}
+
+bool VulkanRenderer::processFusedChain(const PointwiseChain& chain, const vk::Pipeline pipeline)
+{
+    RenderTask* task    = chain.back();
+    CsImage* inputImage = getTaskImage(chain.front()->getInput(0));
+    if (!inputImage)
+        return false;
+
+    const QSize targetSize(inputImage->getWidth(), inputImage->getHeight());
+
+    const vk::Format format = getImageFormat(task);
+    const bool isCached     = isCachedResult(task, targetSize);
+    if (isCached)
+    {
+        if (!createComputeRenderTarget(targetSize.width(), targetSize.height(), format))
+            CS_LOG_WARNING("Failed to create compute render target.");
+    }
+    else
+    {
+        mComputeRenderTarget = createTransientImage(task, targetSize, format, false);
+    }
+
+    const QRect region = getTaskRegion(task, targetSize);
+
+    // A grading stack is one lookup instead of a function per task
+    const bool isLut = mColorLutSize > 1 && isColorChain(chain) &&
+                       applyColorLut(chain, inputImage, mComputeRenderTarget.get(), region);
+    if (!isLut)
+    {
+        const std::vector<float> settings = getFusedSettings(chain);
+        mFrameGraph->addDispatch(
+            pipeline,
+            inputImage,
+            nullptr,
+            mComputeRenderTarget.get(),
+            settings,
+            region,
+            usesPushConstants(settings));
+    }
+    mComputeRenderTarget->setValidRegion(region);
+
+    storeTaskImage(task, std::move(mComputeRenderTarget), isCached);
+
+    return true;
+}
+
+bool VulkanRenderer::applyColorLut(
+    const PointwiseChain& chain,
+    CsImage* const inputImage,
+    CsImage* const outputImage,
+    const QRect& region)
+{
+    const QString size = QString::number(mColorLutSize);
+
+    vk::Pipeline apply =
+        getGeneratedPipeline("lut-apply:" + size, generateLutApplyShader(mColorLutSize));
+    if (!apply)
+        return false;
+
+    // Baked again only when a setting has changed
+    const QByteArray key = getColorLutKey(chain, mColorLutSize);
+    CsImage* lut         = mImageCache->get(key);
+    if (!lut)
+    {
+        const QString signature = QString::fromLatin1(getFusedSignature(chain).toHex());
+
+        vk::Pipeline bake = getGeneratedPipeline(
+            "lut-bake:" + size + ":" + signature,
+            generateLutBakeShader(chain, mColorLutSize));
+        vk::Pipeline check = getGeneratedPipeline(
+            "lut-error:" + size + ":" + signature,
+            generateLutErrorShader(chain, mColorLutSize));
+        if (!bake || !check)
+            return false;
+
+        const std::vector<float> settings = getFusedSettings(chain);
+
+        // The input is bound because the shaders expect an image there
+        auto image = mImagePool->acquire(
+            mColorLutSize * mColorLutSize, mColorLutSize, false, globalImageFormat, "Color LUT");
+        const QRect lutRegion(0, 0, image->getWidth(), image->getHeight());
+        mFrameGraph->addDispatch(
+            bake, inputImage, nullptr, image.get(), settings, lutRegion, usesPushConstants(settings));
+        image->setValidRegion(lutRegion);
+
+        auto errors = mImagePool->acquire(
+            lutErrorImageSize, lutErrorImageSize, false, globalImageFormat, "Color LUT Error");
+        mFrameGraph->addDispatch(
+            check,
+            inputImage,
+            image.get(),
+            errors.get(),
+            settings,
+            QRect(0, 0, lutErrorImageSize, lutErrorImageSize),
+            usesPushConstants(settings));
+
+        // Read back with the job, logged once it has finished
+        const int numTasks = static_cast<int>(chain.size());
+        const int lutSize  = mColorLutSize;
+        mFrameGraph->addReadback(
+            errors.get(),
+            [numTasks, lutSize](const char* data)
+            {
+                const float* errors = reinterpret_cast<const float*>(data);
+
+                float maxError = 0.0f;
+                for (int i = 0; i < lutErrorImageSize * lutErrorImageSize; ++i)
+                {
+                    for (int c = 0; c < 3; ++c)
+                        maxError = std::max(maxError, errors[i * 4 + c]);
+                }
+
+                CS_LOG_INFO(QString("Baked %1 color transforms into a LUT of %2^3, largest error %3")
+                                .arg(numTasks)
+                                .arg(lutSize)
+                                .arg(maxError));
+            });
+        mFrameGraph->keepAlive(std::move(errors));
+
+        mImageCache->insert(key, std::move(image));
+        lut = mImageCache->get(key);
+        if (!lut)
+            return false;
+    }
+
+    mFrameGraph->addDispatch(apply, inputImage, lut, outputImage, {}, region);
+
+    return true;
+}
+
+void VulkanRenderer::displayTask(const RenderTask* task)
+{
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+    if (CsImage* image = getTaskImage(task))
+    {
+        mClearScreen = false;
+
+        // A proxy is shown at the size of the full image
+        const float scale = task->getProxyScale();
+        updateVertexData(
+            static_cast<int>(std::lround(image->getWidth() / scale)),
+            static_cast<int>(std::lround(image->getHeight() / scale)));
+
+        CsImage* upstreamImage = getTaskImage(task->getInput(0));
+        if (!upstreamImage)
+            upstreamImage = image;
+
+        setDisplayedTask(task);
+
+        // The cached images are sampled directly, each frame
+        // points its descriptors at them when it is recorded
+        mDrawnImages = { image, upstreamImage };
+        for (int i = 0; i < mConcurrentFrameCount; ++i)
+            mGraphicsDescriptorIsStale[i] = true;
+
+        requestWindowUpdate();
+    }
+    else
+    {
+        CS_LOG_INFO("Clearing screen");
+        doClearScreen();
+    }
 }
 
 void VulkanRenderer::doClearScreen()
 {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
     mClearScreen = true;
 
-    mWindow->requestUpdate();
+    mDrawnImages.clear();
+    setDisplayedTask(nullptr);
+
+    requestWindowUpdate();
 }
 
 void VulkanRenderer::startNextFrame()
 {
+    // The render thread is busy with the GPU, try again a bit later.
+    // QVulkanWindow allows calling frameReady() after we return.
+    std::unique_lock<std::recursive_mutex> lock(mMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        QTimer::singleShot(1, mWindow, [this]() { startNextFrame(); });
+        return;
+    }
+
+    // The job changes the layout of the images it uses and may
+    // write to them, the frame has to wait until it is done
+    for (auto image : mDrawnImages)
+    {
+        if (mFrameGraph->isUsing(image))
+        {
+            lock.unlock();
+            QTimer::singleShot(1, mWindow, [this]() { startNextFrame(); });
+            return;
+        }
+    }
+
+    // QVulkanWindow has waited for the fence of the
+    // frame that used the same resources before
+    mFrameCount++;
+    if (mFrameCount > static_cast<uint64_t>(mConcurrentFrameCount))
+        mImagePool->setCompletedFrame(mFrameCount - mConcurrentFrameCount);
+
     if (mClearScreen)
     {
         const QSize sz = mWindow->swapChainImageSize();
@@ -1154,12 +2210,20 @@ void VulkanRenderer::startNextFrame()
     }
     else
     {
+        for (auto image : mDrawnImages)
+            image->setLastUse(mFrameCount);
+
         createRenderPass();
     }
 
     mWindow->frameReady();
 }
 
+void VulkanRenderer::requestWindowUpdate()
+{
+    QMetaObject::invokeMethod(mWindow, &QWindow::requestUpdate, Qt::QueuedConnection);
+}
+
 void VulkanRenderer::logicalDeviceLost()
 {
     emit mWindow->deviceLost();
@@ -1172,13 +2236,13 @@ void VulkanRenderer::translate(float dx, float dy)
     mPositionX += 6.0 * dx / sz.width();
     mPositionY += 2.0 * -dy / sz.height();
 
-    mWindow->requestUpdate();
+    requestWindowUpdate();
 }
 
 void VulkanRenderer::scale(float s)
 {
     mScaleXY = s;
-    mWindow->requestUpdate();
+    requestWindowUpdate();
     emit mWindow->requestZoomTextUpdate(s);
 }
 
@@ -1194,31 +2258,43 @@ void VulkanRenderer::releaseResources()
 
 void VulkanRenderer::shutdown()
 {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
      [[maybe_unused]] auto result = mDevice.waitIdle();
 
-    mLoadImageStaging    = nullptr;
-    mTmpCacheImage       = nullptr;
+    RenderTask::setBackend(nullptr);
+
+    auto stats = mAllocator->getStats();
+    CS_LOG_INFO("Device memory: " + QString::number(stats.usedBytes >> 20) + " of " +
+                QString::number(stats.allocatedBytes >> 20) + " MB used in " +
+                QString::number(stats.numBlocks) + " blocks, fragmentation " +
+                QString::number(stats.fragmentation, 'f', 2));
+
+    savePipelineCache();
+
+    mDisplayedImages.clear();
+    mDrawnImages.clear();
+    mImageCache = nullptr;
+    mImagePool  = nullptr;
+    mFrameGraph          = nullptr;
+    mTransientMemory     = nullptr;
     mComputeRenderTarget = nullptr;
     mSettingsBuffer      = nullptr;
-    //    for(auto& pl : mPipelines)
-    //        mDevice.destroy(*pl.second);
-    mDevice.destroy(*mComputePipelineNoop);
-    mDevice.destroy(*mComputePipelineUser);
+    mPipelines.clear();
+    mPipelineRegistry = nullptr;
     mDevice.destroy(*mGraphicsPipelineRGB);
     mDevice.destroy(*mGraphicsPipelineAlpha);
     mDevice.destroy(*mPipelineCache);
     mDevice.destroy(*mDescriptorPool);
-    //    for(auto& sh : mShaders)
-    //        mDevice.destroy(*sh.second);
-    mDevice.destroy(*mShaderUser);
     mDevice.destroy(*mGraphicsPipelineLayout);
     mDevice.destroy(*mComputePipelineLayout);
     mDevice.destroy(*mGraphicsDescriptorSetLayout);
     mDevice.destroy(*mComputeDescriptorSetLayout);
     mComputeCommandBuffer = nullptr;
     mDevice.destroy(*mSampler);
-    mDevice.free(*mVertexBufferMemory);
     mDevice.destroy(*mVertexBuffer);
+    mVertexBufferAllocation = CsAllocation();
+    mAllocator              = nullptr;
 
     result = mDevice.waitIdle();
 }
@@ -21,6 +21,10 @@
 #define VULKANRENDERER_H
 
 #include <array>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <QImage>
 #include <QVulkanWindow>
@@ -31,12 +35,26 @@
 #include <OpenImageIO/imagebufalgo.h>
 
 #include "renderconfig.h"
-//#include "../nodegraph/nodedefinitions.h"
-//#include "../nodegraph/nodebase.h"
+#include "../shadercompiler/SpvShaderCompiler.h"
 #include "../windowmanager.h"
+#include "renderbackend.h"
+#include "rendertask.h"
+#include "rendertaskread.h"
+#include "colorlut.h"
+#include "colorprocessorcache.h"
+#include "colorspacelut.h"
 #include "cscommandbuffer.h"
+#include "csframegraph.h"
 #include "csimage.h"
+#include "csimagecache.h"
+#include "csimagepool.h"
+#include "csmemoryallocator.h"
 #include "cssettingsbuffer.h"
+#include "cstransientmemory.h"
+#include "imageupload.h"
+#include "pipelineregistry.h"
+#include "pointwisefusion.h"
+#include "renderjob.h"
 
 namespace OCIO = OCIO_NAMESPACE;
 
@@ -47,7 +65,7 @@ class VulkanWindow;
 namespace Cascade::Renderer
 {
 
-class VulkanRenderer : public QVulkanWindowRenderer
+class VulkanRenderer : public QVulkanWindowRenderer, public RenderBackend
 {
 public:
     static VulkanRenderer& getInstance();
@@ -56,18 +74,47 @@ public:
 
     void setUp(VulkanWindow* w);
 
-    void processReadNode(NodeBase* node);
-    void processNode(
-        NodeBase* node,
-        CsImage* inputImageBack,
-        CsImage* inputImageFront,
-        const QSize targetSize);
+    // RenderBackend
+    bool processReadTask(RenderTaskRead* task) override;
+    bool processTask(RenderTask* task) override;
+
+    // The result of a task, nullptr if it has not been rendered
+    CsImage* getTaskImage(const RenderTask* task);
+
+    // Call before rendering a graph so that the images
+    // needed by it don't get evicted from the cache.
+    // The tasks are recorded until endEvaluation() submits them.
+    void beginEvaluation(const RenderJob& job) override;
+    bool endEvaluation() override;
+
+    void setImageCacheBudget(const uint64_t bytes);
+
+    // Storage of the results of tasks that don't ask for a precision
+    void setImagePrecision(const ImagePrecision precision);
+
+    // Chains of color transforms are baked into a 3D LUT with this many
+    // texels along each axis, 0 renders them exactly
+    void setColorLutSize(const int size);
+
+    // How far OCIO may simplify the color space conversions on the CPU,
+    // lossless keeps them exact, good is faster and close enough
+    void setColorOptimization(const OCIO::OptimizationFlags optimization);
+
     bool saveImageToDisk(
         CsImage* const inputImage,
         const QString& path,
         const QMap<std::string, std::string>& attributes,
         const int colorSpace);
-    void displayNode(const NodeBase* node);
+    // Copies a part of the result of a task to the CPU, converted from linear
+    // to the color space and pasted into the destination at the position
+    bool copyTaskImage(
+        const RenderTask* task,
+        const QRect& rect,
+        ImageBuf& destination,
+        const QPoint& position,
+        const int colorSpace);
+
+    void displayTask(const RenderTask* task);
     void doClearScreen();
     void setDisplayMode(const DisplayMode mode);
 
@@ -80,6 +127,21 @@ public:
     void translate(float dx, float dy);
     void scale(float s);
 
+    // The part of the image the viewer shows, in pixels
+    // of the full resolution image relative to its center
+    QRectF getVisibleRegion() const;
+
+    // The largest tile the device renders at once, limited by
+    // the image dimensions it supports and by its memory
+    int getMaxTileSize() const;
+
+    // Proxy scale at which an image of this size can be rendered at once
+    float getFittingScale(const QSize& size) const;
+
+    // Width and height of an image file without reading its pixels,
+    // empty if it can't be opened
+    static QSize getImageFileSize(const QString& path);
+
     void shutdown();
 
     ~VulkanRenderer();
@@ -95,7 +157,9 @@ private:
     void createSampler();
     void createDescriptorPool();
     void createGraphicsDescriptors();
+    // Starts from the cache of the last session if it fits the device
     void createGraphicsPipelineCache();
+    void savePipelineCache();
     void createGraphicsPipelineLayout();
     void createGraphicsPipeline(vk::UniquePipeline& pl, const QString& fragShaderPath);
 
@@ -103,28 +167,95 @@ private:
     void releaseSwapChainResources() override;
     void releaseResources() override;
 
-    void loadShadersFromDisk();
-    void createComputePipelines();
-    vk::UniquePipeline createComputePipeline(const vk::ShaderModule& shaderModule);
+    vk::UniquePipeline createComputePipeline(
+        const vk::ShaderModule& shaderModule,
+        const std::vector<uint32_t>& specialization = {});
+    // Creates the pipeline for a shader the first time it is needed.
+    // A shader with its GLSL source next to it, like :/shaders/blur.comp
+    // for :/shaders/blur_comp.spv, is compiled from that instead.
+    vk::Pipeline getComputePipeline(
+        const QString& shaderPath,
+        const std::vector<uint32_t>& specialization = {});
+    // The shader code of the task or else the one at its shader path,
+    // specialized for the task
+    vk::Pipeline getTaskPipeline(const RenderTask* task);
+    // Compiles the shader of a chain the first time it is needed,
+    // a null handle if that fails
+    vk::Pipeline getFusedPipeline(const PointwiseChain& chain);
+    vk::Pipeline getGeneratedPipeline(const QString& key, const QString& shader);
 
     // Load image
-    bool createImageFromFile(const QString& path, const int colorSpace);
-    bool writeLinearImage(float* imgStart, QSize imgSize, std::unique_ptr<CsImage>& image);
+    // Decodes the file band by band into the staging memory of the frame
+    // graph and records the copies to the returned image. It is in the
+    // depth of the file if nothing has to be converted on the CPU.
+    // The read pipeline turns it into float and converts the colors with
+    // the color space LUT, which has to be bound as the front input.
+    // A scale below 1 loads a smaller version for proxy renders,
+    // with a tile only that part of the file is read.
+    // The lock is released while the file is decoded.
+    std::unique_ptr<CsImage> uploadImageFromFile(
+        RenderTaskRead* task,
+        vk::Pipeline& readPipeline,
+        CsImage*& colorSpaceLut,
+        std::unique_lock<std::recursive_mutex>& lock);
 
     // Compute setup
     void createComputePipelineLayout();
     void createQueryPool();
 
+    // Which image formats the device can use for the results
+    void checkImageFormats();
+
     // Recurring compute
+    static std::vector<uint32_t> readShaderFile(const QString& name);
     vk::UniqueShaderModule createShaderFromFile(const QString& name);
-    vk::UniqueShaderModule createShaderFromCode(const std::vector<unsigned int>& code);
+    vk::UniqueShaderModule createShaderFromCode(std::vector<uint32_t> code);
+
+    bool createComputeRenderTarget(uint32_t width, uint32_t height, const vk::Format format);
+
+    vk::Format getImageFormat(const RenderTask* task) const;
+
+    // The part of the result of a task that is rendered, in pixels of an
+    // image of the given size. Rounded out to whole work groups.
+    QRect getTaskRegion(const RenderTask* task, const QSize& size) const;
+
+    // Whether the result of a task goes into the cache. The others
+    // share transient memory and only live until the job is done.
+    bool isCachedResult(const RenderTask* task, const QSize& size) const;
+    // Index of the last task in the job that reads the result of a task
+    int getLastUse(const RenderTask* task) const;
+    std::unique_ptr<CsImage> createTransientImage(
+        const RenderTask* task,
+        const QSize& size,
+        const vk::Format format,
+        const bool isTemporary);
+    void storeTaskImage(
+        const RenderTask* task,
+        std::unique_ptr<CsImage> image,
+        const bool isCached);
+    // Frames in flight may still draw the image, frames started
+    // later wait for the job, see startNextFrame()
+    bool isDrawnByFramesInFlight(const CsImage* image) const;
+
+    bool processNode(
+        RenderTask* task,
+        CsImage* inputImageBack,
+        CsImage* inputImageFront,
+        const QSize targetSize);
 
-    bool createComputeRenderTarget(uint32_t width, uint32_t height);
+    // Finds the chains of pointwise tasks in the job that are rendered by one shader
+    void planFusion(const RenderJob& job);
+    bool processFusedChain(const PointwiseChain& chain, const vk::Pipeline pipeline);
+    // Renders a chain of color transforms with its LUT, bakes it if
+    // the settings have changed. False if the shaders are not available.
+    bool applyColorLut(
+        const PointwiseChain& chain,
+        CsImage* const inputImage,
+        CsImage* const outputImage,
+        const QRect& region);
 
     void createComputeDescriptors();
-    void updateGraphicsDescriptors(
-        const CsImage* const outputImage,
-        const CsImage* const upstreamImage);
+    void updateGraphicsDescriptors(const int frame);
     void updateComputeDescriptors(
         const CsImage* const inputImageBack,
         const CsImage* const inputImageFront,
@@ -133,11 +264,25 @@ private:
     // Has to be called in startNextFrame()
     void createRenderPass();
 
+    QMatrix4x4 getViewMatrix() const;
+
+    // Size of the quad the result is shown on, in pixels of the full image
     void updateVertexData(const int w, const int h);
 
+    // Safe to call from the render thread
+    void requestWindowUpdate();
+
+    void setDisplayedTask(const RenderTask* task);
+
     void transformColorSpace(const QString& from, const QString& to, ImageBuf& image);
 
-    void fillSettingsBuffer(const NodeBase* node);
+    // Baked from the OCIO transform and uploaded by the frame graph the
+    // first time, nullptr if the LUT isn't close enough to the transform
+    CsImage* getColorSpaceLut(const QString& from, const QString& to, ColorSpaceLutDomain& domain);
+
+    // A linear image converted to the color space, nullptr if
+    // it has to be done on the CPU. Waits for the conversion.
+    std::unique_ptr<CsImage> convertColorSpaceOnGpu(CsImage* const image, const QString& to);
 
     void logicalDeviceLost() override;
 
@@ -145,15 +290,20 @@ private:
     vk::Device mDevice;
     vk::PhysicalDevice mPhysicalDevice;
 
+    std::unique_ptr<CsMemoryAllocator> mAllocator;
+
+    CsAllocation mVertexBufferAllocation;
     vk::UniqueBuffer mVertexBuffer;
-    vk::UniqueDeviceMemory mVertexBufferMemory;
     vk::DescriptorBufferInfo mUniformBufferInfo[QVulkanWindow::MAX_CONCURRENT_FRAME_COUNT];
+    vk::DeviceSize mVertexOffsets[QVulkanWindow::MAX_CONCURRENT_FRAME_COUNT];
+    bool mGraphicsDescriptorIsStale[QVulkanWindow::MAX_CONCURRENT_FRAME_COUNT] = {};
 
     vk::UniqueDescriptorPool mDescriptorPool;
     vk::UniqueDescriptorSetLayout mGraphicsDescriptorSetLayout;
     std::vector<vk::UniqueDescriptorSet> mGraphicsDescriptorSet;
 
     vk::UniquePipelineCache mPipelineCache;
+    QString mPipelineCachePath;
     vk::UniquePipelineLayout mGraphicsPipelineLayout;
     vk::UniquePipeline mGraphicsPipelineRGB;
     vk::UniquePipeline mGraphicsPipelineAlpha;
@@ -161,14 +311,9 @@ private:
 
     vk::UniqueSampler mSampler;
 
-    vk::UniquePipeline mComputePipelineNoop;
-    vk::UniqueShaderModule mShaderUser;
-    vk::UniquePipeline mComputePipelineUser;
 
     QSize mCurrentRenderSize;
 
-    std::unique_ptr<ImageBuf> mCpuImage;
-    QString mImagePath;
 
     int mConcurrentFrameCount;
 
@@ -187,18 +332,62 @@ private:
     DisplayMode mDisplayMode = DisplayMode::eRgb;
 
     std::unique_ptr<CsCommandBuffer> mComputeCommandBuffer;
+    std::unique_ptr<CsFrameGraph> mFrameGraph;
 
     vk::UniquePipelineLayout mComputePipelineLayout;
     vk::UniquePipeline mComputePipeline;
     vk::UniqueDescriptorSetLayout mComputeDescriptorSetLayout;
     vk::UniqueDescriptorSet mComputeDescriptorSet;
 
-    std::unique_ptr<CsImage> mLoadImageStaging;
-    std::unique_ptr<CsImage> mTmpCacheImage;
     std::unique_ptr<CsImage> mComputeRenderTarget;
 
-    //std::map<NodeType, vk::UniqueShaderModule>  mShaders;
-    //std::map<NodeType, vk::UniquePipeline>      mPipelines;
+    std::unique_ptr<PipelineRegistry> mPipelineRegistry;
+    // Pipelines of the registry by shader path or key of a
+    // generated shader, null if it could not be compiled
+    std::map<QString, vk::Pipeline> mPipelines;
+
+    // Compiles the shaders of fused chains
+    SpvCompiler mCompiler;
+
+    ImagePrecision mImagePrecision = ImagePrecision::eFull;
+    // Whether the shaders can be patched to work on any image format,
+    // otherwise everything is rgba32f like they declare it
+    bool mHasFormatlessStorage = false;
+    vk::Format mMaskFormat     = vk::Format::eR16G16B16A16Sfloat;
+    // Indexed by UploadDepth, float is always there
+    std::array<bool, 4> mHasUploadDepth = { false, false, false, true };
+
+    // Whether dispatches can start at an offset,
+    // otherwise the whole image is always rendered
+    bool mHasDispatchBase = false;
+
+    std::unique_ptr<CsImagePool> mImagePool;
+    std::unique_ptr<CsImageCache> mImageCache;
+
+    // State of the job that is being recorded
+    const RenderJob* mCurrentJob = nullptr;
+    std::unique_ptr<CsTransientMemory> mTransientMemory;
+    std::unordered_map<QByteArray, CsImage*> mTransientResults;
+
+    // Chains of the job by their last task, the others in them get no result
+    std::unordered_map<const RenderTask*, std::pair<PointwiseChain, vk::Pipeline>> mFusedChains;
+    std::unordered_set<const RenderTask*> mFusedTasks;
+    // Inputs of chains, they are read when the last task of the chain is executed
+    std::unordered_map<const RenderTask*, int> mFusedLastUses;
+
+    int mColorLutSize = 0;
+
+    // Everything that uses the device or the compute resources holds this,
+    // so the render thread and the GUI thread don't use them at the same time
+    std::recursive_mutex mMutex;
+
+    // The images on screen must not be evicted
+    QByteArrayList mDisplayedImages;
+
+    // What the graphics pipeline samples and the number of the frame
+    // being recorded, tells the pool when released images are free
+    std::vector<CsImage*> mDrawnImages;
+    uint64_t mFrameCount = 0;
 
     // TODO: Move this out of here
     std::vector<float> mViewerPushConstants = {0.0f, 0.5f, 0.0f, 1.0f, 1.0f};
@@ -206,6 +395,10 @@ private:
     std::unique_ptr<CsSettingsBuffer> mSettingsBuffer;
 
     OCIO::ConstConfigRcPtr mOcioConfig;
+    ColorProcessorCache mColorProcessors;
+    OCIO::OptimizationFlags mColorOptimization = OCIO::OPTIMIZATION_GOOD;
+    // Whether the LUT of a conversion is close enough to use it
+    std::map<QByteArray, bool> mColorSpaceLutIsExact;
 };
 
 } // end namespace Cascade::Renderer
@@ -19,12 +19,26 @@
 
 #include "rendermanager.h"
 
+#include <algorithm>
+
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
 
 #include "uientities/uientity.h"
 #include "uientities/fileboxentity.h"
+#include "nodegraph/node.h"
+#include "nodegraph/nodedatamodel.h"
+#include "nodegraph/nodegraphview.h"
+#include "renderer/renderjob.h"
+#include "renderer/rendertaskread.h"
+#include "renderer/renderthread.h"
+#include "renderer/tiledwriter.h"
+#include "renderer/tileplanner.h"
 #include "renderer/vulkanrenderer.h"
+#include "log.h"
 #include "popupmessages.h"
+#include "preferencesmanager.h"
 
 namespace Cascade {
 
@@ -35,82 +49,212 @@ RenderManager& RenderManager::getInstance()
     return instance;
 }
 
-//void RenderManager::setUp(VulkanRenderer *r, NodeGraph* ng)
-//{
-//    mRenderer = r;
-//    mNodeGraph = ng;
+RenderManager::RenderManager() {}
 
-//    mWindowManager = &WindowManager::getInstance();
-//}
+RenderManager::~RenderManager() {}
+
+void RenderManager::setUp(VulkanRenderer* r, NodeGraph::NodeGraphView* ng)
+{
+    mRenderer  = r;
+    mNodeGraph = ng;
+
+    RenderTask::setBackend(mRenderer);
+
+    auto budget = PreferencesManager::getInstance().getGeneralPreference(
+        "gpu-cache-budget-mb", QString::number(defaultImageCacheBudget / (1024 * 1024)));
+    mRenderer->setImageCacheBudget(budget.toULongLong() * 1024 * 1024);
+
+    // Half float is plenty for images that come from 8 bit files,
+    // nodes that need more ask for it themselves
+    auto precision = PreferencesManager::getInstance().getGeneralPreference(
+        "image-precision", "half");
+    mRenderer->setImagePrecision(
+        precision == "full" ? ImagePrecision::eFull : ImagePrecision::eHalf);
+
+    // While a property is dragged the graph is rendered at 1/2 or 1/4
+    // of the resolution, or whatever keeps up with the frame time
+    auto proxy = PreferencesManager::getInstance().getGeneralPreference(
+        "proxy-scale", "auto");
+    mProxyScale = proxy == "auto" ? 0.0f : 1.0f / std::max(1, proxy.toInt());
+    mProxyFrameTime = PreferencesManager::getInstance().getGeneralPreference(
+        "proxy-frame-time-ms", QString::number(defaultProxyFrameTime)).toInt();
+
+    // Chains of color nodes can be baked into a LUT of 33 or 65 texels
+    // per axis, it is off by default so they are rendered exactly
+    auto lutSize = PreferencesManager::getInstance().getGeneralPreference(
+        "color-lut-size", "0");
+    mRenderer->setColorLutSize(lutSize.toInt() > 1 ? lutSize.toInt() : 0);
+
+    // Color space conversions on the CPU can be kept exact,
+    // by default OCIO may simplify them where it is close enough
+    auto colorOptimization = PreferencesManager::getInstance().getGeneralPreference(
+        "color-optimization", "good");
+    mRenderer->setColorOptimization(
+        colorOptimization == "lossless" ? OCIO::OPTIMIZATION_LOSSLESS : OCIO::OPTIMIZATION_GOOD);
+
+    mRenderThread = std::make_unique<RenderThread>(mRenderer);
+    mRenderThread->start();
+
+    connect(mNodeGraph, &NodeGraph::NodeGraphView::nodeDisplayRequested,
+            this, &RenderManager::handleNodeDisplayRequest);
+    connect(mNodeGraph, &NodeGraph::NodeGraphView::editingStarted,
+            this, &RenderManager::handleEditingStarted);
+    connect(mNodeGraph, &NodeGraph::NodeGraphView::editingFinished,
+            this, &RenderManager::handleEditingFinished);
+}
+
+void RenderManager::shutdown()
+{
+    if (mRenderThread)
+        mRenderThread->stop();
+}
 
 void RenderManager::updateViewerPushConstants(const QString &s)
 {
     mRenderer->setViewerPushConstants(s);
 }
 
-//void RenderManager::handleNodeDisplayRequest(NodeBase* node)
-//{
-//    auto props = getPropertiesForType(node->getType());
+void RenderManager::handleNodeDisplayRequest(NodeGraph::Node* node)
+{
+    if (!mRenderThread)
+        return;
 
-//    auto viewerMode = mWindowManager->getViewerMode();
+    if (!node || !node->nodeDataModel()->getRenderTask())
+    {
+        submitClearScreen();
+        return;
+    }
 
-//    mRenderer->setDisplayMode(DisplayMode::eRgb);
+    auto model = mNodeGraph->getModel();
 
-//    if (viewerMode == ViewerMode::eFrontRgb)
-//    {
-//        if (props.frontInputTrait == FrontInputTrait::eAlwaysClear)
-//        {
-//            mRenderer->doClearScreen();
-//        }
-//        else if (props.frontInputTrait == FrontInputTrait::eRenderUpstreamOrClear)
-//        {
-//            displayNode(node->getUpstreamNodeFront());
-//        }
-//    }
-//    else if (viewerMode == ViewerMode::eBackRgb)
-//    {
-//        if (props.backInputTrait == BackInputTrait::eAlwaysClear)
-//        {
-//            mRenderer->doClearScreen();
-//        }
-//        else if (props.backInputTrait == BackInputTrait::eRenderUpstreamOrClear)
-//        {
-//            displayNode(node->getUpstreamNodeBack());
-//        }
-//    }
-//    else if (viewerMode == ViewerMode::eInputAlpha)
-//    {
-//        if (props.alphaInputTrait == AlphaInputTrait::eAlwaysClear)
-//        {
-//            mRenderer->doClearScreen();
-//        }
-//        else if (props.alphaInputTrait == AlphaInputTrait::eRenderUpstreamOrClear)
-//        {
-//            mRenderer->setDisplayMode(DisplayMode::eAlpha);
-//            displayNode(node->getUpstreamNodeFront());
-//        }
-//    }
-//    else if (viewerMode == ViewerMode::eOutputRgb || viewerMode == ViewerMode::eOutputAlpha)
-//    {
-//        NodeBase* nodeToDisplay = node;
+    // Only the nodes that changed since the last request need new tasks
+    model->evaluate(*node);
 
-//        if (viewerMode == ViewerMode::eOutputAlpha)
-//        {
-//            mRenderer->setDisplayMode(DisplayMode::eAlpha);
-//        }
-//        if (props.rgbOutputTrait == OutputTrait::eRenderUpstreamIfFrontDisconnected)
-//        {
-//            if (!node->getUpstreamNodeFront())
-//            {
-//                if (node->getUpstreamNodeBack())
-//                {
-//                    nodeToDisplay = node->getUpstreamNodeBack();
-//                }
-//            }
-//        }
-//        displayNode(nodeToDisplay);
-//    }
-//}
+    const bool isProxy = mIsEditing;
+    float scale        = isProxy ? getProxyScale() : 1.0f;
+
+    auto upstream = model->getUpstreamNodes(*node);
+
+    // Images the device can't render at once are shown at
+    // a fraction of their size, saving renders them in tiles
+    for (auto& n : upstream)
+    {
+        if (auto read = dynamic_cast<RenderTaskRead*>(n->nodeDataModel()->getRenderTask()))
+            scale = std::min(scale, mRenderer->getFittingScale(getFileSize(read->getPath())));
+    }
+
+    // The job gets the whole chain, results that are still
+    // in the cache are not computed again
+    auto job = std::make_unique<RenderJob>("viewer", scale);
+    for (auto& n : upstream)
+    {
+        if (auto task = n->nodeDataModel()->getRenderTask())
+            job->addTask(task);
+    }
+
+    // Parts of the image outside of the viewer don't have to be rendered
+    job->setRegion(mRenderer->getVisibleRegion());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    job->setFinishedCallback([this, timer, isProxy](RenderTask* result)
+    {
+        if (isProxy)
+            mProxyRenderTime = timer.elapsed();
+
+        mRenderer->displayTask(result);
+    });
+
+    mRenderThread->submit(std::move(job));
+}
+
+void RenderManager::saveNodeToFile(
+    NodeGraph::Node* node,
+    const QString& path,
+    const QMap<std::string, std::string>& attributes,
+    const int colorSpace)
+{
+    if (!mRenderThread || !node || !node->nodeDataModel()->getRenderTask())
+        return;
+
+    auto model = mNodeGraph->getModel();
+
+    model->evaluate(*node);
+
+    auto upstream = model->getUpstreamNodes(*node);
+
+    auto createJob = [&upstream](const QString& target)
+    {
+        auto job = std::make_unique<RenderJob>(target);
+        for (auto& n : upstream)
+        {
+            if (auto task = n->nodeDataModel()->getRenderTask())
+                job->addTask(task);
+        }
+        return job;
+    };
+
+    // Tiles overlap by as much as the nodes read around their pixels
+    const QSize size = getResultSize(node->nodeDataModel()->getRenderTask());
+    const int halo   = createJob(path)->getHalo();
+
+    const std::vector<Tile> tiles = planTiles(size, mRenderer->getMaxTileSize(), halo);
+
+    auto writer = std::make_shared<TiledWriter>(path, size, attributes);
+    if (tiles.empty() || !writer->isGood())
+    {
+        CS_LOG_WARNING("Could not render " + path + " in tiles.");
+        executeMessageBox(MESSAGEBOX_FILE_SAVE_PROBLEM);
+        return;
+    }
+
+    const int saveIndex = mNumSaves++;
+
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        const Tile tile   = tiles[i];
+        const bool isLast = i + 1 == tiles.size();
+
+        // Every tile is a target of its own, so they don't replace each other,
+        // neither do the tiles of an earlier save of the same path
+        auto job = createJob(
+            QString("file:%1:%2:%3").arg(saveIndex).arg(path).arg(i));
+        job->setTile(tile.source);
+
+        job->setFinishedCallback([this, writer, tile, isLast, colorSpace](RenderTask* result)
+        {
+            if (tile.target.left() == 0)
+                writer->beginRow(tile.target.top(), tile.target.height());
+
+            // The halo is only needed for rendering the tile
+            const QRect rect = tile.target.translated(-tile.source.topLeft());
+
+            if (writer->isGood() &&
+                !mRenderer->copyTaskImage(
+                    result, rect, writer->getRow(), QPoint(tile.target.x(), 0), colorSpace))
+            {
+                CS_LOG_WARNING("Could not render a tile of " + writer->getPath());
+                writer->abort();
+            }
+
+            if (tile.isLastInRow)
+                writer->endRow();
+
+            if (isLast)
+            {
+                const bool success = writer->isGood();
+                QMetaObject::invokeMethod(this, [success]()
+                {
+                    executeMessageBox(
+                        success ? MESSAGEBOX_FILE_SAVE_SUCCESS : MESSAGEBOX_FILE_SAVE_PROBLEM);
+                }, Qt::QueuedConnection);
+            }
+        });
+
+        mRenderThread->submit(std::move(job));
+    }
+}
 
 //void RenderManager::handleNodeFileSaveRequest(
 //        NodeBase* node,
@@ -154,73 +298,75 @@ void RenderManager::updateViewerPushConstants(const QString &s)
 
 void RenderManager::handleClearScreenRequest()
 {
-    mRenderer->doClearScreen();
+    if (mRenderThread)
+        submitClearScreen();
 }
 
-//void RenderManager::displayNode(NodeBase* node)
-//{
-//    if (node && node->canBeRendered())
-//    {
-//        if (renderNodes(node))
-//            mRenderer->displayNode(node);
-//        else
-//            mRenderer->doClearScreen();
-//    }
-//    else
-//    {
-//        mRenderer->doClearScreen();
-//    }
-//}
+void RenderManager::handleEditingStarted()
+{
+    mIsEditing = true;
+}
 
-//bool RenderManager::renderNodes(NodeBase *node)
-//{
-//    bool allNodesRendered = true;
+void RenderManager::handleEditingFinished()
+{
+    // The graph view requests the full resolution render
+    mIsEditing = false;
+}
 
-//    std::vector<NodeBase*> nodes;
-//    node->getAllUpstreamNodes(nodes);
+float RenderManager::getProxyScale()
+{
+    if (mProxyScale > 0.0f)
+        return mProxyScale;
 
-//    foreach(NodeBase* n, nodes)
-//    {
-//        if (n->canBeRendered())
-//            renderNode(n);
-//        else
-//            allNodesRendered = false;
-//    }
+    // Halving the scale quarters the work, so it only goes
+    // up again when there is plenty of time left
+    const qint64 time = mProxyRenderTime.exchange(-1);
+    if (time > mProxyFrameTime && mAutoProxyScale > minProxyScale)
+        mAutoProxyScale *= 0.5f;
+    else if (time >= 0 && time * 4 < mProxyFrameTime && mAutoProxyScale < 0.5f)
+        mAutoProxyScale *= 2.0f;
 
-//    return allNodesRendered;
-//}
+    return mAutoProxyScale;
+}
 
-//void RenderManager::renderNode(NodeBase *node)
-//{
-//    // Read node
-//    if (node->getType() == NodeType::eRead && node->getNeedsUpdate())
-//    {
-//        if (node->canBeRendered())
-//        {
-//            mRenderer->processReadNode(node);
-//        }
-//    }
-//    // All other nodes
-//    else if (node->getUpstreamNodeBack() && node->getNeedsUpdate())
-//    {
-//        CsImage* inputImageBack = nullptr;
-//        CsImage* inputImageFront = nullptr;
+QSize RenderManager::getResultSize(const RenderTask* task)
+{
+    while (task && !dynamic_cast<const RenderTaskRead*>(task))
+        task = task->getInput(0) ? task->getInput(0) : task->getInput(1);
 
-//        inputImageBack = node->getUpstreamNodeBack()->getCachedImage();
+    if (!task)
+        return QSize();
 
-//        // A node that has a front and back image
-//        if(node->getUpstreamNodeFront() && node->getUpstreamNodeFront()->getCachedImage())
-//        {
-//            inputImageFront = node->getUpstreamNodeFront()->getCachedImage();
-//            mRenderer->processNode(node, inputImageBack, inputImageFront, node->getTargetSize());
-//        }
-//        // A node without a front image
-//        else if (inputImageBack)
-//        {
-//            mRenderer->processNode(node, inputImageBack, nullptr, node->getTargetSize());
-//        }
-//    }
-//    emit nodeHasBeenRendered(node);
-//}
+    return getFileSize(static_cast<const RenderTaskRead*>(task)->getPath());
+}
+
+QSize RenderManager::getFileSize(const QString& path)
+{
+    // A file written again under the same name can have another size
+    const QFileInfo info(path);
+    const QString key =
+        QString("%1:%2:%3").arg(path).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+
+    auto it = mFileSizes.find(key);
+    if (it != mFileSizes.end())
+        return it.value();
+
+    // Files that can't be opened yet are tried again next time
+    const QSize size = VulkanRenderer::getImageFileSize(path);
+    if (!size.isEmpty())
+        mFileSizes.insert(key, size);
+
+    return size;
+}
+
+void RenderManager::submitClearScreen()
+{
+    // Goes through the thread as well, so a render
+    // that is still running doesn't show up afterwards
+    auto job = std::make_unique<RenderJob>("viewer");
+    job->setFinishedCallback([this](RenderTask*) { mRenderer->doClearScreen(); });
+
+    mRenderThread->submit(std::move(job));
+}
 
 } // namespace Cascade
@@ -20,16 +20,30 @@
 #ifndef RENDERMANAGER_H
 #define RENDERMANAGER_H
 
+#include <atomic>
+#include <memory>
+
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QSize>
 
 //#include "nodegraph/nodebase.h"
 //#include "nodegraph/nodedefinitions.h"
 
 namespace Cascade::Renderer
 {
+    class RenderTask;
+    class RenderThread;
     class VulkanRenderer;
 }
 
+namespace Cascade::NodeGraph
+{
+    class Node;
+    class NodeGraphView;
+}
+
 namespace Cascade {
 
 using namespace Renderer;
@@ -45,18 +59,59 @@ public:
     RenderManager(RenderManager const&) = delete;
     void operator=(RenderManager const&) = delete;
 
-    //void setUp(VulkanRenderer* r, NodeGraph* ng);
+    void setUp(VulkanRenderer* r, NodeGraph::NodeGraphView* ng);
 
     void updateViewerPushConstants(const QString& s);
 
+    // Renders the node in tiles that fit on the device and streams
+    // them into the file, so images of any size can be saved
+    void saveNodeToFile(
+        NodeGraph::Node* node,
+        const QString& path,
+        const QMap<std::string, std::string>& attributes,
+        const int colorSpace);
+
+    // Stops the render thread, has to be called before the renderer shuts down
+    void shutdown();
+
 private:
-    RenderManager() {}
-//    void displayNode(NodeBase* node);
-//    bool renderNodes(NodeBase* node);
-//    void renderNode(NodeBase* node);
+    RenderManager();
+    ~RenderManager();
+
+    void submitClearScreen();
+
+    // Scale of the next render while a property is dragged
+    float getProxyScale();
+
+    // Size of the full resolution result of a task, that of the
+    // file read at its back input or, if there is none, its front one
+    QSize getResultSize(const RenderTask* task);
+
+    // Size of an image file, read once per version of the file
+    QSize getFileSize(const QString& path);
+
+    VulkanRenderer* mRenderer = nullptr;
+    NodeGraph::NodeGraphView* mNodeGraph = nullptr;
+
+    std::unique_ptr<RenderThread> mRenderThread;
+
+    // Renders are previews at a lower resolution while this is set
+    bool mIsEditing = false;
+
+    // From the preferences, 0 chooses the scale to match the frame time
+    float mProxyScale     = 0.0f;
+    int mProxyFrameTime   = 0;
+    float mAutoProxyScale = 0.5f;
+
+    // Milliseconds the last proxy render took, -1 if it has been used.
+    // Written by the render thread.
+    std::atomic<qint64> mProxyRenderTime = -1;
+
+    // By path, size and modification time of the file
+    QHash<QString, QSize> mFileSizes;
 
-    VulkanRenderer* mRenderer;
-    //NodeGraph* mNodeGraph;
+    // Gives the tiles of every save targets of their own
+    int mNumSaves = 0;
 
     //WindowManager* mWindowManager;
 
@@ -64,7 +119,7 @@ signals:
     //void nodeHasBeenRendered(Cascade::NodeBase* node);
 
 public slots:
-//    void handleNodeDisplayRequest(Cascade::NodeBase* node);
+    void handleNodeDisplayRequest(Cascade::NodeGraph::Node* node);
 //    void handleNodeFileSaveRequest(
 //            Cascade::NodeBase* node,
 //            const QString& path,
@@ -72,6 +127,8 @@ public slots:
 //            const bool isBatch,
 //            const bool isLast);
     void handleClearScreenRequest();
+    void handleEditingStarted();
+    void handleEditingFinished();
 };
 
 } // namespace Cascade
@@ -1,6 +1,7 @@
 ﻿#include "SpvShaderCompiler.h"
 
 #include <iostream>
+#include <mutex>
 
 #ifdef _WIN32
     #include "glslang/Public/ShaderLang.h"
@@ -18,11 +19,16 @@ struct SpvCompiler::Impl
 {
 	Impl()
 	{
-		// Initialize GLSL
-		if (!glslang::InitializeProcess())
+		// Initialize GLSL once for all compilers, which can then
+		// be used on different threads at the same time
+		static std::once_flag initialized;
+		std::call_once(initialized, []()
 		{
-			throw std::runtime_error("Failed to initialize glslang.");
-		}
+			if (!glslang::InitializeProcess())
+			{
+				throw std::runtime_error("Failed to initialize glslang.");
+			}
+		});
 	};
 
 	std::string getFilePath(const std::string& s);
@@ -343,4 +349,9 @@ std::string SpvCompiler::getError()
 	return impl->error;
 }
 
+std::string SpvCompiler::getVersion()
+{
+	return std::string(glslang::GetGlslVersionString()) + " " + glslang::GetEsslVersionString();
+}
+
 
@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 
+// Not thread-safe itself, but each thread can have its own compiler
 class SpvCompiler {
 public:
     SpvCompiler();
@@ -15,6 +16,9 @@ public:
     std::vector<unsigned int> getSpirV();
     std::string getError();
 
+    // Changes when glslang does, so compiled code can be kept
+    static std::string getVersion();
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -132,6 +132,8 @@ bool Slider::eventFilter(QObject *watched, QEvent *event)
         if(mouseEvent->button() == Qt::LeftButton)
         {
             mIsDragging = true;
+            emit dragStarted();
+
             // factor for scaling pixels into value of slider
             double factorPixelsToValue = mSlider->maximum() / static_cast<double>(this->size().width());
             mSlider->setValue( static_cast<int>(mouseEvent->x() *factorPixelsToValue));
@@ -149,6 +151,7 @@ bool Slider::eventFilter(QObject *watched, QEvent *event)
         if(mouseEvent->button() == Qt::LeftButton)
         {
             mIsDragging = false;
+            emit dragFinished();
         }
     }
 
@@ -65,6 +65,10 @@ private:
 signals:
     void valueChanged();
 
+    // The value is changed by dragging until dragFinished()
+    void dragStarted();
+    void dragFinished();
+
 private slots:
     void handleSliderValueChanged();
     void handleSpinBoxValueChanged();
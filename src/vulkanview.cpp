@@ -22,6 +22,7 @@
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QLoggingCategory>
+#include <QVersionNumber>
 
 #include "viewerstatusbar.h"
 #include "renderer/vulkanrenderer.h"
@@ -48,6 +49,11 @@ VulkanView::VulkanView(ViewerStatusBar* statusBar, QWidget *parent)
         dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
     VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
 
+    // The renderer needs Vulkan 1.1 to render only what is visible,
+    // a loader without vkEnumerateInstanceVersion only knows 1.0
+    if (VULKAN_HPP_DEFAULT_DISPATCHER.vkEnumerateInstanceVersion)
+        mInstance.setApiVersion(QVersionNumber(1, 1));
+
     if (!mInstance.create())
     {
         executeMessageBox(MESSAGEBOX_FAILED_INITIALIZATION);
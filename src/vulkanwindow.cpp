@@ -84,6 +84,8 @@ void VulkanWindow::handleZoomResetRequest()
 {
     mZoomFactor = 1.0;
     mRenderer->scale(1.0);
+
+    emit viewChanged();
 }
 
 void VulkanWindow::mousePressEvent(QMouseEvent* e)
@@ -105,6 +107,8 @@ void VulkanWindow::mouseMoveEvent(QMouseEvent* e)
         float dy = e->pos().y() - mLastPos.y();
 
         mRenderer->translate(dx, dy);
+
+        emit viewChanged();
     }
     mLastPos = e->pos();
 }
@@ -124,6 +128,8 @@ void VulkanWindow::wheelEvent(QWheelEvent* e)
     mZoomFactor = mZoomFactor > mMinZoom ? mZoomFactor : mMinZoom;
     mZoomFactor = mZoomFactor < mMaxZoom ? mZoomFactor : mMaxZoom;
     mRenderer->scale(mZoomFactor);
+
+    emit viewChanged();
 }
 
 VulkanWindow::~VulkanWindow()
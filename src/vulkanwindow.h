@@ -69,6 +69,9 @@ signals:
     void requestZoomTextUpdate(float f);
     void renderTargetHasBeenCreated(int w, int h);
 
+    // What part of the image is visible has changed
+    void viewChanged();
+
 public slots:
     void handleZoomResetRequest();
 
@@ -27,25 +27,59 @@ VERSION = $${VERSION_MAJOR}.$${VERSION_MINOR}.$${VERSION_BUILD}
 
 HEADERS += \
         testheader.h \
+    tst_barrierplanner.h \
+        tst_colorlut.h \
+        tst_colorspacelut.h \
     tst_filespropertymodel.h \
+        tst_imageupload.h \
+        tst_isfshadercache.h \
         tst_node.h \
         tst_nodegraphdatamodel.h \
         tst_nodegraphview.h \
+        tst_pipelinecachefile.h \
+        tst_pointwisefusion.h \
+        tst_rangeallocator.h \
+        tst_rendertask.h \
         tst_slider.h \
+        tst_spirvutility.h \
+        tst_tileplanner.h \
+        ../../src/isfshadercache.h \
         ../../src/log.h \
         ../../src/ui/slider.h \
+        ../../src/renderer/barrierplanner.h \
+        ../../src/renderer/colorlut.h \
+        ../../src/renderer/colorspacelut.h \
+        ../../src/renderer/imageupload.h \
+        ../../src/renderer/pipelinecachefile.h \
+        ../../src/renderer/pointwisefusion.h \
+        ../../src/renderer/rangeallocator.h \
+        ../../src/renderer/renderbackend.h \
+        ../../src/renderer/renderjob.h \
         ../../src/renderer/rendertask.h \
         ../../src/renderer/rendertaskread.h \
+        ../../src/renderer/spirvutility.h \
+        ../../src/renderer/tileplanner.h \
         $$files(../../src/nodegraph/*.h,          true) \
         $$files(../../src/nodegraph/nodes/*.h,    true) \
         $$files(../../src/properties/*.h,         true) \
 
 SOURCES += \
         main.cpp \
+        ../../src/isfshadercache.cpp \
         ../../src/log.cpp \
         ../../src/ui/slider.cpp \
+        ../../src/renderer/barrierplanner.cpp \
+        ../../src/renderer/colorlut.cpp \
+        ../../src/renderer/colorspacelut.cpp \
+        ../../src/renderer/imageupload.cpp \
+        ../../src/renderer/pipelinecachefile.cpp \
+        ../../src/renderer/pointwisefusion.cpp \
+        ../../src/renderer/rangeallocator.cpp \
+        ../../src/renderer/renderjob.cpp \
         ../../src/renderer/rendertask.cpp \
         ../../src/renderer/rendertaskread.cpp \
+        ../../src/renderer/spirvutility.cpp \
+        ../../src/renderer/tileplanner.cpp \
         $$files(../../src/nodegraph/*.cpp,        true) \
         $$files(../../src/properties/*.cpp,       true) \
 
@@ -1,8 +1,19 @@
+#include "tst_barrierplanner.h"
+#include "tst_colorlut.h"
+#include "tst_colorspacelut.h"
 #include "tst_filespropertymodel.h".h "
+#include "tst_imageupload.h"
+#include "tst_isfshadercache.h"
 #include "tst_node.h"
 #include "tst_nodegraphdatamodel.h"
 #include "tst_nodegraphview.h"
+#include "tst_pipelinecachefile.h"
+#include "tst_pointwisefusion.h"
+#include "tst_rangeallocator.h"
+#include "tst_rendertask.h"
 #include "tst_slider.h"
+#include "tst_spirvutility.h"
+#include "tst_tileplanner.h"
 
 #include <QApplication>
 
@@ -0,0 +1,73 @@
+#ifndef TST_BARRIERPLANNER_H
+#define TST_BARRIERPLANNER_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/barrierplanner.h"
+
+using Cascade::Renderer::BarrierPlanner;
+using Cascade::Renderer::ImageAccess;
+
+class BarrierPlannerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mInput  = mPlanner.addImage(ImageAccess::eSampled);
+        mFirst  = mPlanner.addImage(ImageAccess::eUndefined);
+        mSecond = mPlanner.addImage(ImageAccess::eUndefined);
+    }
+
+    void TearDown() override {}
+
+    BarrierPlanner mPlanner;
+    int mInput;
+    int mFirst;
+    int mSecond;
+};
+
+TEST_F(BarrierPlannerTest, chainOfPasses)
+{
+    auto transitions = mPlanner.addPass(
+        { { mInput, ImageAccess::eShaderRead }, { mFirst, ImageAccess::eShaderWrite } });
+
+    ASSERT_EQ(transitions.size(), 2u);
+
+    // The next pass reads what the first one wrote
+    transitions = mPlanner.addPass(
+        { { mFirst, ImageAccess::eShaderRead }, { mSecond, ImageAccess::eShaderWrite } });
+
+    ASSERT_EQ(transitions.size(), 2u);
+    EXPECT_EQ(transitions.at(0).image, mFirst);
+    EXPECT_EQ(transitions.at(0).from, ImageAccess::eShaderWrite);
+    EXPECT_EQ(transitions.at(0).to, ImageAccess::eShaderRead);
+}
+
+TEST_F(BarrierPlannerTest, readAfterReadNeedsNoBarrier)
+{
+    mPlanner.addPass(
+        { { mInput, ImageAccess::eShaderRead }, { mFirst, ImageAccess::eShaderWrite } });
+
+    auto transitions = mPlanner.addPass(
+        { { mInput, ImageAccess::eShaderRead }, { mSecond, ImageAccess::eShaderWrite } });
+
+    ASSERT_EQ(transitions.size(), 1u);
+    EXPECT_EQ(transitions.at(0).image, mSecond);
+}
+
+TEST_F(BarrierPlannerTest, finishLeavesEverythingSampled)
+{
+    mPlanner.addPass(
+        { { mInput, ImageAccess::eShaderRead }, { mFirst, ImageAccess::eShaderWrite } });
+
+    auto transitions = mPlanner.finish(ImageAccess::eSampled);
+
+    ASSERT_EQ(transitions.size(), 2u);
+    EXPECT_EQ(mPlanner.getAccess(mInput), ImageAccess::eSampled);
+    EXPECT_EQ(mPlanner.getAccess(mFirst), ImageAccess::eSampled);
+
+    // The unused image is left alone
+    EXPECT_EQ(mPlanner.getAccess(mSecond), ImageAccess::eUndefined);
+}
+
+#endif // TST_BARRIERPLANNER_H
@@ -0,0 +1,77 @@
+#ifndef TST_COLORLUT_H
+#define TST_COLORLUT_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/colorlut.h"
+#include "../../src/renderer/rendertaskread.h"
+
+using Cascade::Renderer::generateLutApplyShader;
+using Cascade::Renderer::generateLutBakeShader;
+using Cascade::Renderer::getColorLutKey;
+using Cascade::Renderer::isColorChain;
+using Cascade::Renderer::PointwiseChain;
+using Cascade::Renderer::RenderTask;
+using Cascade::Renderer::RenderTaskRead;
+
+// Lifts the colors, the alpha stays as it is
+class LiftTask : public RenderTaskRead
+{
+public:
+    explicit LiftTask(const float lift = 0.1f)
+    {
+        mSettings = { lift };
+    }
+
+    std::unique_ptr<RenderTask> clone() const override
+    {
+        return std::make_unique<LiftTask>(*this);
+    }
+
+    QString getPointwiseFunction() const override
+    {
+        return "vec4 apply(vec4 pixel)\n{\n    return vec4(pixel.rgb + setting(0), pixel.a);\n}";
+    }
+
+    bool isColorTransform() const override
+    {
+        return true;
+    }
+};
+
+TEST(ColorLutTest, onlyColorTransformsMakeColorChain)
+{
+    LiftTask lift;
+    RenderTaskRead read;
+
+    EXPECT_TRUE(isColorChain({ &lift, &lift }));
+    EXPECT_FALSE(isColorChain({ &lift, &read }));
+    EXPECT_FALSE(isColorChain({}));
+}
+
+TEST(ColorLutTest, keyChangesWithSettings)
+{
+    LiftTask first(0.1f);
+    LiftTask same(0.1f);
+    LiftTask other(0.2f);
+
+    EXPECT_EQ(getColorLutKey({ &first, &first }, 33), getColorLutKey({ &first, &same }, 33));
+    EXPECT_NE(getColorLutKey({ &first, &first }, 33), getColorLutKey({ &first, &other }, 33));
+    EXPECT_NE(getColorLutKey({ &first, &first }, 33), getColorLutKey({ &first, &first }, 65));
+}
+
+TEST(ColorLutTest, shadersUseLutSize)
+{
+    LiftTask lift;
+
+    const QString bake = generateLutBakeShader({ &lift, &lift }, 33);
+    EXPECT_TRUE(bake.contains("const int lutSize = 33;"));
+    EXPECT_TRUE(bake.contains("applyChain("));
+
+    // Applying the LUT doesn't depend on the chain
+    const QString apply = generateLutApplyShader(65);
+    EXPECT_TRUE(apply.contains("const int lutSize = 65;"));
+    EXPECT_FALSE(apply.contains("applyChain("));
+}
+
+#endif // TST_COLORLUT_H
@@ -0,0 +1,138 @@
+#ifndef TST_COLORSPACELUT_H
+#define TST_COLORSPACELUT_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "testheader.h"
+
+#include "../../src/renderer/colorspacelut.h"
+
+using Cascade::Renderer::bakeColorSpaceLut;
+using Cascade::Renderer::ColorSpaceLutDomain;
+using Cascade::Renderer::ColorTransform;
+using Cascade::Renderer::colorSpaceLutSize;
+using Cascade::Renderer::colorSpaceLutTolerance;
+using Cascade::Renderer::generateColorSpaceLutShader;
+using Cascade::Renderer::getColorSpaceLutError;
+using Cascade::Renderer::getColorSpaceLutSignature;
+
+namespace
+{
+
+// Like the exponent transforms of the gamma color spaces
+void applyGamma(float* pixels, const int numPixels)
+{
+    for (int i = 0; i < numPixels; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            pixels[i * 4 + c] = std::pow(std::max(pixels[i * 4 + c], 0.0f), 2.2f);
+    }
+}
+
+// Stays at the ends of the domain outside of it
+void applyClampedGamma(float* pixels, const int numPixels)
+{
+    for (int i = 0; i < numPixels; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            pixels[i * 4 + c] = std::pow(std::clamp(pixels[i * 4 + c], 0.0f, 1.0f), 2.2f);
+    }
+}
+
+// Every channel depends on all of them, like a matrix
+void applySaturation(float* pixels, const int numPixels)
+{
+    for (int i = 0; i < numPixels; ++i)
+    {
+        float* pixel     = pixels + i * 4;
+        const float luma  = (pixel[0] + pixel[1] + pixel[2]) / 3.0f;
+        for (int c = 0; c < 3; ++c)
+            pixel[c] = luma + (pixel[c] - luma) * 1.5f;
+    }
+}
+
+} // namespace
+
+TEST(ColorSpaceLutTest, texelsAreSpreadOverTheDomain)
+{
+    const ColorTransform identity = [](float*, const int) {};
+
+    ColorSpaceLutDomain domain;
+    domain.min = -0.125f;
+    domain.max = 1.125f;
+
+    const std::vector<float> lut = bakeColorSpaceLut(identity, domain, 6);
+    ASSERT_EQ(lut.size(), 24u);
+    EXPECT_FLOAT_EQ(lut.at(0), -0.125f);
+    EXPECT_FLOAT_EQ(lut.at(4), 0.125f);
+    EXPECT_FLOAT_EQ(lut.at(22), 1.125f);
+
+    domain.isLog = true;
+    domain.min   = -2.0f;
+    domain.max   = 3.0f;
+
+    const std::vector<float> logLut = bakeColorSpaceLut(identity, domain, 6);
+    EXPECT_FLOAT_EQ(logLut.at(0), 0.25f);
+    EXPECT_FLOAT_EQ(logLut.at(21), 8.0f);
+}
+
+TEST(ColorSpaceLutTest, curvesAreCloseEnough)
+{
+    ColorSpaceLutDomain domain;
+    domain.min = 0.0f;
+    domain.max = 1.0f;
+
+    const std::vector<float> lut = bakeColorSpaceLut(applyClampedGamma, domain, colorSpaceLutSize);
+
+    EXPECT_LT(getColorSpaceLutError(lut, applyClampedGamma, domain), colorSpaceLutTolerance);
+}
+
+TEST(ColorSpaceLutTest, valuesOutsideTheDomainAreTooFarOff)
+{
+    ColorSpaceLutDomain domain;
+    domain.min = 0.0f;
+    domain.max = 1.0f;
+
+    const std::vector<float> lut = bakeColorSpaceLut(applyGamma, domain, colorSpaceLutSize);
+
+    EXPECT_GT(getColorSpaceLutError(lut, applyGamma, domain), colorSpaceLutTolerance);
+
+    // Negative values and highlights of linear images
+    const ColorTransform identity = [](float*, const int) {};
+
+    ColorSpaceLutDomain linear;
+    linear.isLog = true;
+    linear.min   = -15.0f;
+    linear.max   = 6.0f;
+
+    const std::vector<float> linearLut = bakeColorSpaceLut(identity, linear, colorSpaceLutSize);
+
+    EXPECT_GT(getColorSpaceLutError(linearLut, identity, linear), colorSpaceLutTolerance);
+}
+
+TEST(ColorSpaceLutTest, mixedChannelsAreTooFarOff)
+{
+    ColorSpaceLutDomain domain;
+
+    const std::vector<float> lut = bakeColorSpaceLut(applySaturation, domain, colorSpaceLutSize);
+
+    EXPECT_GT(getColorSpaceLutError(lut, applySaturation, domain), colorSpaceLutTolerance);
+}
+
+TEST(ColorSpaceLutTest, shaderDependsOnDomain)
+{
+    ColorSpaceLutDomain uniform;
+    ColorSpaceLutDomain log;
+    log.isLog = true;
+    log.min   = -15.0f;
+    log.max   = 6.0f;
+
+    EXPECT_NE(getColorSpaceLutSignature(uniform, 4096), getColorSpaceLutSignature(log, 4096));
+    EXPECT_NE(getColorSpaceLutSignature(uniform, 4096), getColorSpaceLutSignature(uniform, 1024));
+
+    EXPECT_TRUE(generateColorSpaceLutShader(log, 4096).contains("log2("));
+    EXPECT_FALSE(generateColorSpaceLutShader(uniform, 4096).contains("log2("));
+}
+
+#endif // TST_COLORSPACELUT_H
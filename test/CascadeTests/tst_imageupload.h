@@ -0,0 +1,34 @@
+#ifndef TST_IMAGEUPLOAD_H
+#define TST_IMAGEUPLOAD_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/imageupload.h"
+
+using Cascade::Renderer::generateReadShader;
+using Cascade::Renderer::getUploadPixelSize;
+using Cascade::Renderer::UploadDepth;
+
+TEST(ImageUploadTest, pixelsAreUploadedInTheirDepth)
+{
+    EXPECT_EQ(getUploadPixelSize(UploadDepth::eUInt8), 4);
+    EXPECT_EQ(getUploadPixelSize(UploadDepth::eUInt16), 8);
+    EXPECT_EQ(getUploadPixelSize(UploadDepth::eHalf), 8);
+    EXPECT_EQ(getUploadPixelSize(UploadDepth::eFloat), 16);
+}
+
+TEST(ImageUploadTest, readShaderMatchesDepth)
+{
+    EXPECT_TRUE(generateReadShader(UploadDepth::eUInt8, 4).contains("rgba8)"));
+    EXPECT_TRUE(generateReadShader(UploadDepth::eUInt16, 4).contains("rgba16)"));
+    EXPECT_TRUE(generateReadShader(UploadDepth::eHalf, 4).contains("rgba16f)"));
+}
+
+TEST(ImageUploadTest, missingChannelsAreFilled)
+{
+    EXPECT_TRUE(generateReadShader(UploadDepth::eUInt8, 1).contains("rgba.rrr, 1.0"));
+    EXPECT_TRUE(generateReadShader(UploadDepth::eUInt8, 3).contains("rgba.a = 1.0"));
+    EXPECT_FALSE(generateReadShader(UploadDepth::eUInt8, 4).contains("rgba.a = 1.0"));
+}
+
+#endif // TST_IMAGEUPLOAD_H
@@ -0,0 +1,74 @@
+#ifndef TST_ISFSHADERCACHE_H
+#define TST_ISFSHADERCACHE_H
+
+#include "testheader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "../../src/isfshadercache.h"
+
+using Cascade::ISFShaderCache;
+
+class ISFShaderCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mEntry.properties = QJsonDocument::fromJson("{\"CATEGORIES\":[\"Blur\"]}");
+        mEntry.spirV      = { 0x07230203, 0x00010000, 1, 2, 3 };
+
+        mKey = ISFShaderCache::getKey("shader", 1, "glslang 11");
+    }
+
+    void TearDown() override {}
+
+    QTemporaryDir mDir;
+    ISFShaderCache::Entry mEntry;
+    QByteArray mKey;
+};
+
+TEST_F(ISFShaderCacheTest, roundTrip)
+{
+    ISFShaderCache cache(mDir.path() + "/isf");
+    ASSERT_TRUE(cache.store(mKey, mEntry));
+
+    ISFShaderCache::Entry loaded;
+    ASSERT_TRUE(cache.load(mKey, loaded));
+    EXPECT_EQ(loaded.properties, mEntry.properties);
+    EXPECT_EQ(loaded.spirV, mEntry.spirV);
+}
+
+TEST_F(ISFShaderCacheTest, damagedFileIsIgnored)
+{
+    ISFShaderCache cache(mDir.path());
+    ASSERT_TRUE(cache.store(mKey, mEntry));
+
+    const QStringList files = QDir(mDir.path()).entryList(QDir::Files);
+    ASSERT_EQ(files.size(), 1);
+
+    QFile file(mDir.path() + "/" + files.first());
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    QByteArray data = file.readAll();
+    data[data.size() - 30] = ~data[data.size() - 30];
+    file.seek(0);
+    file.write(data);
+    file.close();
+
+    ISFShaderCache::Entry loaded;
+    EXPECT_FALSE(cache.load(mKey, loaded));
+}
+
+TEST_F(ISFShaderCacheTest, changesInvalidateKey)
+{
+    ISFShaderCache cache(mDir.path());
+    ASSERT_TRUE(cache.store(mKey, mEntry));
+
+    ISFShaderCache::Entry loaded;
+    EXPECT_FALSE(cache.load(ISFShaderCache::getKey("shader ", 1, "glslang 11"), loaded));
+    EXPECT_FALSE(cache.load(ISFShaderCache::getKey("shader", 2, "glslang 11"), loaded));
+    EXPECT_FALSE(cache.load(ISFShaderCache::getKey("shader", 1, "glslang 12"), loaded));
+}
+
+#endif // TST_ISFSHADERCACHE_H
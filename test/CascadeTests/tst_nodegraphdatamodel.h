@@ -5,6 +5,7 @@
 
 #include "../../src/nodegraph/nodegraphscene.h"
 #include "../../src/nodegraph/nodegraphdatamodel.h"
+#include "../../src/nodegraph/nodes/testnodedatamodel.h"
 
 using namespace Cascade::NodeGraph;
 
@@ -31,4 +32,83 @@ TEST_F(NodeGraphDataModelTest, checkThatDataWasCreated)
     ASSERT_NE(mModel->getData(), nullptr);
 }
 
+class NodeGraphEvaluationTest : public NodeGraphDataModelTest
+{
+protected:
+    void SetUp() override
+    {
+        NodeGraphDataModelTest::SetUp();
+
+        mNode1 = &mModel->createNode(std::make_unique<TestNodeDataModel>());
+        mNode2 = &mModel->createNode(std::make_unique<TestNodeDataModel>());
+        mNode3 = &mModel->createNode(std::make_unique<TestNodeDataModel>());
+        mNode4 = &mModel->createNode(std::make_unique<TestNodeDataModel>());
+
+        // node1 --> node2 --> node3
+        //                     node4
+
+        mModel->createConnection(*mNode2, 0, *mNode1, 0);
+        mModel->createConnection(*mNode3, 0, *mNode2, 0);
+    }
+
+    Node* mNode1;
+    Node* mNode2;
+    Node* mNode3;
+    Node* mNode4;
+};
+
+TEST_F(NodeGraphEvaluationTest, evaluateRendersUpstreamNodesInOrder)
+{
+    auto rendered = mModel->evaluate(*mNode3);
+
+    std::vector<Node*> expected = { mNode1, mNode2, mNode3 };
+
+    ASSERT_EQ(rendered, expected);
+    ASSERT_FALSE(mNode3->nodeDataModel()->isDirty());
+    ASSERT_TRUE(mNode4->nodeDataModel()->isDirty());
+}
+
+TEST_F(NodeGraphEvaluationTest, secondEvaluateRendersNothing)
+{
+    mModel->evaluate(*mNode3);
+
+    ASSERT_TRUE(mModel->evaluate(*mNode3).empty());
+}
+
+TEST_F(NodeGraphEvaluationTest, propertyChangeOnlyRendersDownstreamNodes)
+{
+    mModel->evaluate(*mNode3);
+
+    auto prop = dynamic_cast<IntPropertyModel*>(mNode2->nodeDataModel()->getPropertyModels()[1]);
+    ASSERT_NE(nullptr, prop);
+    prop->setValue(prop->getData()->getValue() + 1);
+
+    ASSERT_FALSE(mNode1->nodeDataModel()->isDirty());
+    ASSERT_TRUE(mNode2->nodeDataModel()->isDirty());
+    ASSERT_TRUE(mNode3->nodeDataModel()->isDirty());
+
+    auto rendered = mModel->evaluate(*mNode3);
+
+    std::vector<Node*> expected = { mNode2, mNode3 };
+
+    ASSERT_EQ(rendered, expected);
+}
+
+TEST_F(NodeGraphEvaluationTest, deletingConnectionInvalidatesDownstream)
+{
+    mModel->evaluate(*mNode3);
+
+    auto connections = mNode3->nodeState().connections(PortType::In, 0);
+    mModel->deleteConnection(*connections.begin()->second);
+
+    ASSERT_FALSE(mNode2->nodeDataModel()->isDirty());
+    ASSERT_TRUE(mNode3->nodeDataModel()->isDirty());
+
+    auto rendered = mModel->evaluate(*mNode3);
+
+    std::vector<Node*> expected = { mNode3 };
+
+    ASSERT_EQ(rendered, expected);
+}
+
 #endif // TST_NODEGRAPHDATAMODEL_H
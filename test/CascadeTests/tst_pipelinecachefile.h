@@ -0,0 +1,72 @@
+#ifndef TST_PIPELINECACHEFILE_H
+#define TST_PIPELINECACHEFILE_H
+
+#include "testheader.h"
+
+#include <cstring>
+
+#include "../../src/renderer/pipelinecachefile.h"
+
+using Cascade::Renderer::getPipelineCacheFileName;
+using Cascade::Renderer::packPipelineCache;
+using Cascade::Renderer::PipelineCacheId;
+using Cascade::Renderer::unpackPipelineCache;
+
+class PipelineCacheFileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mId.vendorId      = 0x10de;
+        mId.deviceId      = 0x2204;
+        mId.driverVersion = 0x12345678;
+        mId.uuid          = QByteArray(16, 'u');
+
+        // The header the driver writes, then what it has cached
+        const uint32_t header[] = { 32, 1, mId.vendorId, mId.deviceId };
+        mData = QByteArray(reinterpret_cast<const char*>(header), sizeof(header));
+        mData += mId.uuid;
+        mData += QByteArray(100, 'p');
+    }
+
+    void TearDown() override {}
+
+    PipelineCacheId mId;
+    QByteArray mData;
+};
+
+TEST_F(PipelineCacheFileTest, roundTrip)
+{
+    EXPECT_EQ(unpackPipelineCache(packPipelineCache(mData), mId), mData);
+}
+
+TEST_F(PipelineCacheFileTest, damagedFileIsIgnored)
+{
+    QByteArray file = packPipelineCache(mData);
+    file[file.size() - 1] = 'x';
+    EXPECT_TRUE(unpackPipelineCache(file, mId).isEmpty());
+
+    EXPECT_TRUE(unpackPipelineCache(packPipelineCache(mData).left(40), mId).isEmpty());
+    EXPECT_TRUE(unpackPipelineCache(QByteArray(), mId).isEmpty());
+}
+
+TEST_F(PipelineCacheFileTest, otherDeviceIsIgnored)
+{
+    PipelineCacheId other = mId;
+    other.deviceId        = 0x2206;
+    EXPECT_TRUE(unpackPipelineCache(packPipelineCache(mData), other).isEmpty());
+
+    other      = mId;
+    other.uuid = QByteArray(16, 'v');
+    EXPECT_TRUE(unpackPipelineCache(packPipelineCache(mData), other).isEmpty());
+}
+
+TEST_F(PipelineCacheFileTest, newDriverGetsFileOfItsOwn)
+{
+    PipelineCacheId updated = mId;
+    updated.driverVersion   = 0x12345679;
+
+    EXPECT_NE(getPipelineCacheFileName(mId), getPipelineCacheFileName(updated));
+}
+
+#endif // TST_PIPELINECACHEFILE_H
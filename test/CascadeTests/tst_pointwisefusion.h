@@ -0,0 +1,192 @@
+#ifndef TST_POINTWISEFUSION_H
+#define TST_POINTWISEFUSION_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/pointwisefusion.h"
+#include "../../src/renderer/rendertaskread.h"
+
+using Cascade::Renderer::findPointwiseChains;
+using Cascade::Renderer::generateFusedShader;
+using Cascade::Renderer::getFusedSettings;
+using Cascade::Renderer::getFusedSignature;
+using Cascade::Renderer::PointwiseChain;
+using Cascade::Renderer::RenderJob;
+using Cascade::Renderer::RenderTask;
+using Cascade::Renderer::RenderTaskRead;
+using Cascade::Renderer::usesPushConstants;
+
+// Looks only at the pixel it writes
+class GainTask : public RenderTaskRead
+{
+public:
+    explicit GainTask(const std::vector<float>& settings = { 2.0f })
+    {
+        mSettings = settings;
+    }
+
+    std::unique_ptr<RenderTask> clone() const override
+    {
+        return std::make_unique<GainTask>(*this);
+    }
+
+    QString getPointwiseFunction() const override
+    {
+        return "vec4 apply(vec4 pixel)\n{\n    return pixel * setting(0);\n}";
+    }
+};
+
+class PointwiseFusionTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mFirst.setInputs({ &mRead });
+        mSecond.setInputs({ &mFirst });
+        mThird.setInputs({ &mSecond });
+    }
+
+    void TearDown() override {}
+
+    std::unique_ptr<RenderJob> createJob()
+    {
+        auto job = std::make_unique<RenderJob>("viewer");
+        job->addTask(&mRead);
+        job->addTask(&mFirst);
+        job->addTask(&mSecond);
+        job->addTask(&mThird);
+        return job;
+    }
+
+    static bool nothing(const RenderTask*)
+    {
+        return false;
+    }
+
+    RenderTaskRead mRead;
+    GainTask mFirst;
+    GainTask mSecond;
+    GainTask mThird;
+};
+
+TEST_F(PointwiseFusionTest, fusesWholeChain)
+{
+    auto job    = createJob();
+    auto chains = findPointwiseChains(*job, nothing, nothing, 128);
+
+    auto& tasks = job->getTasks();
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains.front(), PointwiseChain({ tasks[1].get(), tasks[2].get(), tasks[3].get() }));
+}
+
+TEST_F(PointwiseFusionTest, viewedTaskEndsChain)
+{
+    auto job    = createJob();
+    auto viewed = job->getTasks()[2].get();
+
+    auto chains = findPointwiseChains(
+        *job, nothing, [viewed](const RenderTask* task) { return task == viewed; }, 128);
+
+    // The task after it would be a chain of its own
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains.front().back(), viewed);
+    EXPECT_EQ(chains.front().size(), 2u);
+}
+
+TEST_F(PointwiseFusionTest, renderedTasksAreLeftOut)
+{
+    auto job  = createJob();
+    auto done = job->getTasks()[1].get();
+
+    auto chains = findPointwiseChains(
+        *job, [done](const RenderTask* task) { return task == done; }, nothing, 128);
+
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains.front().front(), job->getTasks()[2].get());
+}
+
+TEST_F(PointwiseFusionTest, sharedResultEndsChain)
+{
+    GainTask branch;
+    branch.setInputs({ &mFirst });
+
+    auto job = createJob();
+    job->addTask(&branch);
+
+    // The first one is read twice, so it needs a result of its own
+    auto chains = findPointwiseChains(*job, nothing, nothing, 128);
+
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains.front().front(), job->getTasks()[2].get());
+}
+
+TEST_F(PointwiseFusionTest, settingsHaveToFit)
+{
+    auto job    = createJob();
+    auto chains = findPointwiseChains(*job, nothing, nothing, 2);
+
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains.front().size(), 2u);
+}
+
+TEST_F(PointwiseFusionTest, signatureIgnoresValues)
+{
+    GainTask other({ 0.5f });
+    other.setInputs({ &mSecond });
+
+    auto job    = createJob();
+    auto chains = findPointwiseChains(*job, nothing, nothing, 128);
+
+    RenderJob changed("viewer");
+    changed.addTask(&mRead);
+    changed.addTask(&mFirst);
+    changed.addTask(&mSecond);
+    changed.addTask(&other);
+    auto otherChains = findPointwiseChains(changed, nothing, nothing, 128);
+
+    ASSERT_EQ(chains.size(), 1u);
+    ASSERT_EQ(otherChains.size(), 1u);
+    EXPECT_EQ(getFusedSignature(chains.front()), getFusedSignature(otherChains.front()));
+    EXPECT_EQ(getFusedSettings(otherChains.front()), std::vector<float>({ 2.0f, 2.0f, 0.5f }));
+}
+
+TEST_F(PointwiseFusionTest, sameFunctionIsDefinedOnce)
+{
+    auto job    = createJob();
+    auto chains = findPointwiseChains(*job, nothing, nothing, 128);
+    ASSERT_EQ(chains.size(), 1u);
+
+    const QString shader = generateFusedShader(chains.front());
+
+    EXPECT_EQ(shader.count("#define apply"), 1);
+    EXPECT_EQ(shader.count("pixel = stage0(pixel);"), 3);
+    EXPECT_TRUE(shader.contains("settingsOffset = 2;"));
+}
+
+TEST_F(PointwiseFusionTest, fewSettingsArePushed)
+{
+    auto job    = createJob();
+    auto chains = findPointwiseChains(*job, nothing, nothing, 128);
+    ASSERT_EQ(chains.size(), 1u);
+
+    EXPECT_TRUE(usesPushConstants(getFusedSettings(chains.front())));
+    EXPECT_TRUE(generateFusedShader(chains.front()).contains("layout(push_constant)"));
+
+    // More than fit into push constants
+    GainTask big(std::vector<float>(40, 1.0f));
+    big.setInputs({ &mRead });
+    GainTask after;
+    after.setInputs({ &big });
+
+    RenderJob bigJob("viewer");
+    bigJob.addTask(&mRead);
+    bigJob.addTask(&big);
+    bigJob.addTask(&after);
+    auto bigChains = findPointwiseChains(bigJob, nothing, nothing, 128);
+    ASSERT_EQ(bigChains.size(), 1u);
+
+    EXPECT_FALSE(usesPushConstants(getFusedSettings(bigChains.front())));
+    EXPECT_TRUE(generateFusedShader(bigChains.front()).contains("binding = 3"));
+}
+
+#endif // TST_POINTWISEFUSION_H
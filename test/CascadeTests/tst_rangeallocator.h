@@ -0,0 +1,74 @@
+#ifndef TST_RANGEALLOCATOR_H
+#define TST_RANGEALLOCATOR_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/rangeallocator.h"
+
+using Cascade::Renderer::RangeAllocator;
+
+TEST(RangeAllocatorTest, respectsAlignment)
+{
+    RangeAllocator ranges(1024);
+
+    uint64_t first  = 0;
+    uint64_t second = 0;
+
+    ASSERT_TRUE(ranges.allocate(10, 1, first));
+    ASSERT_TRUE(ranges.allocate(100, 256, second));
+
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(second, 256u);
+    EXPECT_EQ(ranges.getUsedSize(), 110u);
+}
+
+TEST(RangeAllocatorTest, usesSmallestFreeRange)
+{
+    RangeAllocator ranges(1000);
+
+    uint64_t a, b, c, d;
+    ranges.allocate(300, 1, a);
+    ranges.allocate(100, 1, b);
+    ranges.allocate(100, 1, c);
+    ranges.allocate(100, 1, d);
+
+    // Leaves a hole of 300 and one of 100 next to the 400 at the end
+    ranges.free(a);
+    ranges.free(c);
+
+    uint64_t offset = 0;
+    ASSERT_TRUE(ranges.allocate(100, 1, offset));
+    EXPECT_EQ(offset, c);
+}
+
+TEST(RangeAllocatorTest, mergesFreedRanges)
+{
+    RangeAllocator ranges(300);
+
+    uint64_t a, b, c;
+    ranges.allocate(100, 1, a);
+    ranges.allocate(100, 1, b);
+    ranges.allocate(100, 1, c);
+
+    ranges.free(a);
+    ranges.free(c);
+    EXPECT_EQ(ranges.getNumFreeRanges(), 2);
+
+    ranges.free(b);
+    EXPECT_EQ(ranges.getNumFreeRanges(), 1);
+    EXPECT_EQ(ranges.getLargestFreeRange(), 300u);
+    EXPECT_TRUE(ranges.isEmpty());
+}
+
+TEST(RangeAllocatorTest, failsWhenFull)
+{
+    RangeAllocator ranges(256);
+
+    uint64_t offset = 0;
+    ASSERT_TRUE(ranges.allocate(200, 1, offset));
+
+    EXPECT_FALSE(ranges.allocate(100, 1, offset));
+    EXPECT_EQ(ranges.getNumAllocations(), 1);
+}
+
+#endif // TST_RANGEALLOCATOR_H
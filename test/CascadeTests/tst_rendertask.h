@@ -0,0 +1,299 @@
+#ifndef TST_RENDERTASK_H
+#define TST_RENDERTASK_H
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "testheader.h"
+
+#include "../../src/properties/propertydata.h"
+#include "../../src/renderer/renderjob.h"
+#include "../../src/renderer/rendertaskread.h"
+
+using Cascade::Properties::FilesPropertyData;
+using Cascade::Properties::IntPropertyData;
+using Cascade::Renderer::RenderJob;
+using Cascade::Renderer::RenderTask;
+using Cascade::Renderer::RenderTaskRead;
+
+class RenderTaskTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mFiles.append({ "/this/is/path/1" });
+    }
+
+    void TearDown() override {}
+
+    FilesPropertyData mFiles;
+    IntPropertyData mInt = IntPropertyData("Test int", 0, 100, 1, 40);
+    RenderTaskRead mTask1;
+    RenderTaskRead mTask2;
+};
+
+TEST_F(RenderTaskTest, sameDataGivesSameHash)
+{
+    mTask1.updateHash("Read", { &mFiles, &mInt });
+    mTask2.updateHash("Read", { &mFiles, &mInt });
+
+    EXPECT_FALSE(mTask1.getHash().isEmpty());
+    EXPECT_EQ(mTask1.getHash(), mTask2.getHash());
+}
+
+TEST_F(RenderTaskTest, changedValueChangesHash)
+{
+    mTask1.updateHash("Read", { &mFiles, &mInt });
+
+    mInt.setValue(41);
+    mTask2.updateHash("Read", { &mFiles, &mInt });
+
+    EXPECT_NE(mTask1.getHash(), mTask2.getHash());
+
+    // Going back to the old value gives the old hash
+    mInt.setValue(40);
+    mTask2.updateHash("Read", { &mFiles, &mInt });
+
+    EXPECT_EQ(mTask1.getHash(), mTask2.getHash());
+}
+
+TEST_F(RenderTaskTest, hashDependsOnInputs)
+{
+    RenderTaskRead upstream;
+    upstream.updateHash("Read", { &mFiles });
+
+    mTask1.updateHash("Read", { &mInt });
+
+    mTask2.setInputs({ &upstream });
+    mTask2.updateHash("Read", { &mInt });
+
+    EXPECT_NE(mTask1.getHash(), mTask2.getHash());
+}
+
+TEST_F(RenderTaskTest, rewrittenFileChangesHash)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    const QString path = dir.filePath("image.exr");
+
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("first");
+    file.close();
+
+    FilesPropertyData files;
+    files.append({ path });
+
+    mTask1.updateHash("Read", { &files });
+    mTask1.initialize({ &files });
+
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("second version");
+    file.close();
+
+    mTask2.updateHash("Read", { &files });
+    mTask2.initialize({ &files });
+
+    EXPECT_NE(mTask1.getHash(), mTask2.getHash());
+}
+
+TEST_F(RenderTaskTest, jobCopiesPointToEachOther)
+{
+    mTask1.updateHash("Read", { &mFiles });
+    mTask2.setInputs({ &mTask1 });
+    mTask2.updateHash("Read", { &mInt });
+
+    RenderJob job("viewer");
+    job.addTask(&mTask1);
+    job.addTask(&mTask2);
+
+    ASSERT_EQ(job.getTasks().size(), 2u);
+
+    auto result = job.getResult();
+    EXPECT_EQ(result, job.getTasks().back().get());
+    EXPECT_EQ(result->getHash(), mTask2.getHash());
+    EXPECT_EQ(result->getInput(0), job.getTasks().front().get());
+}
+
+TEST_F(RenderTaskTest, jobLifetimes)
+{
+    RenderTaskRead third;
+    mTask2.setInputs({ &mTask1 });
+    third.setInputs({ &mTask1, &mTask2 });
+
+    RenderJob job("viewer");
+    job.addTask(&mTask1);
+    job.addTask(&mTask2);
+    job.addTask(&third);
+
+    auto& tasks = job.getTasks();
+
+    EXPECT_EQ(job.getIndex(tasks.at(1).get()), 1);
+    EXPECT_EQ(job.getIndex(&mTask1), -1);
+
+    // Read by both later tasks
+    EXPECT_EQ(job.getLastUse(tasks.at(0).get()), 2);
+    EXPECT_EQ(job.getLastUse(tasks.at(1).get()), 2);
+
+    // Nothing reads the result
+    EXPECT_EQ(job.getLastUse(tasks.at(2).get()), 2);
+}
+
+TEST_F(RenderTaskTest, jobDropsInputsOutsideOfIt)
+{
+    mTask2.setInputs({ &mTask1 });
+
+    RenderJob job("viewer");
+    job.addTask(&mTask2);
+
+    EXPECT_EQ(job.getResult()->getInput(0), nullptr);
+}
+
+TEST_F(RenderTaskTest, proxyHasHashOfItsOwn)
+{
+    mTask1.updateHash("Read", { &mFiles });
+
+    RenderJob full("viewer");
+    full.addTask(&mTask1);
+
+    RenderJob proxy("viewer", 0.5f);
+    proxy.addTask(&mTask1);
+
+    RenderJob smaller("viewer", 0.25f);
+    smaller.addTask(&mTask1);
+
+    EXPECT_EQ(full.getResult()->getHash(), mTask1.getHash());
+    EXPECT_EQ(proxy.getResult()->getProxyScale(), 0.5f);
+    EXPECT_NE(proxy.getResult()->getHash(), mTask1.getHash());
+    EXPECT_NE(proxy.getResult()->getHash(), smaller.getResult()->getHash());
+
+    // Back to full resolution gives the original result
+    proxy.getResult()->setProxyScale(1.0f);
+    EXPECT_EQ(proxy.getResult()->getHash(), mTask1.getHash());
+}
+
+TEST_F(RenderTaskTest, regionGrowsUpstream)
+{
+    RenderTaskRead third;
+    mTask2.setInputs({ &mTask1 });
+    third.setInputs({ &mTask2 });
+
+    RenderJob job("viewer");
+    job.addTask(&mTask1);
+    job.addTask(&mTask2);
+    job.addTask(&third);
+
+    const QRectF visible(-100.0, -50.0, 200.0, 100.0);
+    job.setRegion(visible);
+
+    auto& tasks = job.getTasks();
+
+    // Every task renders whole work groups, so its input is needed further out
+    const qreal m = workGroupSize;
+    EXPECT_EQ(tasks.at(2)->getRegion(), visible);
+    EXPECT_EQ(tasks.at(1)->getRegion(), visible.adjusted(-m, -m, m, m));
+    EXPECT_EQ(tasks.at(0)->getRegion(), visible.adjusted(-2 * m, -2 * m, 2 * m, 2 * m));
+}
+
+TEST_F(RenderTaskTest, nullRegionMeansEverything)
+{
+    mTask2.setInputs({ &mTask1 });
+
+    RenderJob job("viewer");
+    job.addTask(&mTask1);
+    job.addTask(&mTask2);
+    job.setRegion(QRectF());
+
+    EXPECT_TRUE(job.getTasks().front()->getRegion().isNull());
+}
+
+TEST_F(RenderTaskTest, tileHasHashOfItsOwn)
+{
+    mTask1.updateHash("Read", { &mFiles });
+
+    RenderJob job("file");
+    job.addTask(&mTask1);
+
+    job.setTile(QRect(0, 0, 256, 256));
+    const QByteArray first = job.getResult()->getHash();
+    EXPECT_NE(first, mTask1.getHash());
+
+    job.setTile(QRect(256, 0, 256, 256));
+    EXPECT_NE(job.getResult()->getHash(), first);
+
+    job.setTile(QRect());
+    EXPECT_EQ(job.getResult()->getHash(), mTask1.getHash());
+}
+
+// Reads the pixels next to the ones it renders
+class BlurTask : public RenderTaskRead
+{
+public:
+    std::unique_ptr<RenderTask> clone() const override
+    {
+        return std::make_unique<BlurTask>(*this);
+    }
+
+    int getInputMargin() const override
+    {
+        return 3;
+    }
+};
+
+TEST_F(RenderTaskTest, haloAddsUpMargins)
+{
+    BlurTask first;
+    BlurTask second;
+    first.setInputs({ &mTask1 });
+    second.setInputs({ &first });
+
+    RenderJob job("file");
+    job.addTask(&mTask1);
+    job.addTask(&first);
+    job.addTask(&second);
+
+    EXPECT_EQ(job.getHalo(), 6);
+
+    // A source read by a short and a long branch needs the longer reach
+    mTask2.setInputs({ &mTask1, &second });
+
+    RenderJob merged("file");
+    merged.addTask(&mTask1);
+    merged.addTask(&first);
+    merged.addTask(&second);
+    merged.addTask(&mTask2);
+
+    EXPECT_EQ(merged.getHalo(), 6);
+}
+
+// Has a mode and a radius that are specialization constants
+class SpecializedTask : public RenderTaskRead
+{
+public:
+    SpecializedTask()
+    {
+        mSettings            = { 3.0f, 0.5f, 2.0f };
+        mPixelSettings       = { 2 };
+        mSpecializedSettings = { 2, 0 };
+    }
+
+    std::unique_ptr<RenderTask> clone() const override
+    {
+        return std::make_unique<SpecializedTask>(*this);
+    }
+};
+
+TEST_F(RenderTaskTest, specializationFollowsSettings)
+{
+    SpecializedTask task;
+    EXPECT_EQ(task.getSpecialization(), std::vector<uint32_t>({ 2, 3 }));
+
+    // The radius is in pixels and shrinks with the proxy
+    task.setProxyScale(0.5f);
+    EXPECT_EQ(task.getSpecialization(), std::vector<uint32_t>({ 1, 3 }));
+
+    EXPECT_TRUE(mTask1.getSpecialization().empty());
+}
+
+#endif // TST_RENDERTASK_H
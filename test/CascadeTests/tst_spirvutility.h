@@ -0,0 +1,79 @@
+#ifndef TST_SPIRVUTILITY_H
+#define TST_SPIRVUTILITY_H
+
+#include "testheader.h"
+
+#include "../../src/renderer/spirvutility.h"
+
+using Cascade::Renderer::getPipelineKey;
+using Cascade::Renderer::getShaderKey;
+using Cascade::Renderer::removeStorageImageFormats;
+
+namespace
+{
+
+// OpCapability Shader, a float type, a storage
+// image and a sampled image, both rgba32f
+std::vector<uint32_t> createModule()
+{
+    return {
+        0x07230203, 0x00010000, 0, 4, 0,
+        (2 << 16) | 17, 1,
+        (3 << 16) | 22, 1, 32,
+        (9 << 16) | 25, 2, 1, 1, 0, 0, 0, 2, 1,
+        (9 << 16) | 25, 3, 1, 1, 0, 0, 0, 1, 1 };
+}
+
+} // namespace
+
+TEST(SpirvUtilityTest, storageImagesLoseTheirFormat)
+{
+    auto code = createModule();
+
+    ASSERT_TRUE(removeStorageImageFormats(code));
+
+    // Two capabilities inserted after the existing one
+    ASSERT_EQ(code.size(), createModule().size() + 4);
+    EXPECT_EQ(code.at(7), (2u << 16) | 17);
+    EXPECT_EQ(code.at(8), 55u);
+    EXPECT_EQ(code.at(10), 56u);
+
+    // Storage image format is Unknown, the sampled image is untouched
+    EXPECT_EQ(code.at(22), 0u);
+    EXPECT_EQ(code.at(31), 1u);
+}
+
+TEST(SpirvUtilityTest, patchingTwiceChangesNothing)
+{
+    auto code = createModule();
+    removeStorageImageFormats(code);
+
+    auto patched = code;
+    ASSERT_TRUE(removeStorageImageFormats(code));
+
+    EXPECT_EQ(code, patched);
+}
+
+TEST(SpirvUtilityTest, rejectsInvalidCode)
+{
+    std::vector<uint32_t> code = { 1, 2, 3, 4, 5, 6 };
+
+    EXPECT_FALSE(removeStorageImageFormats(code));
+}
+
+TEST(SpirvUtilityTest, keysFollowCodeAndSpecialization)
+{
+    auto code = createModule();
+    const QByteArray key = getShaderKey(code);
+
+    EXPECT_EQ(getShaderKey(createModule()), key);
+    EXPECT_EQ(getPipelineKey(key, {}), key);
+    EXPECT_EQ(getPipelineKey(key, { 1, 2 }), getPipelineKey(key, { 1, 2 }));
+    EXPECT_NE(getPipelineKey(key, { 1, 2 }), getPipelineKey(key, { 2, 1 }));
+    EXPECT_NE(getPipelineKey(key, { 1, 2 }), key);
+
+    code.back() = 2;
+    EXPECT_NE(getShaderKey(code), key);
+}
+
+#endif // TST_SPIRVUTILITY_H
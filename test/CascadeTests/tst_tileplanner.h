@@ -0,0 +1,58 @@
+#ifndef TST_TILEPLANNER_H
+#define TST_TILEPLANNER_H
+
+#include "testheader.h"
+
+#include <QRegion>
+
+#include "../../src/renderer/tileplanner.h"
+
+using Cascade::Renderer::planTiles;
+
+TEST(TilePlannerTest, targetsCoverImageOnce)
+{
+    const QSize size(1000, 700);
+    auto tiles = planTiles(size, 300, 10);
+
+    QRegion covered;
+    for (auto& tile : tiles)
+    {
+        EXPECT_FALSE(covered.intersects(tile.target));
+        covered += tile.target;
+    }
+    EXPECT_EQ(covered, QRegion(QRect(QPoint(0, 0), size)));
+}
+
+TEST(TilePlannerTest, sourcesIncludeHalo)
+{
+    const QSize size(1000, 700);
+    const QRect image(QPoint(0, 0), size);
+    auto tiles = planTiles(size, 300, 10);
+
+    for (auto& tile : tiles)
+    {
+        EXPECT_EQ(tile.source, tile.target.adjusted(-10, -10, 10, 10) & image);
+        EXPECT_LE(tile.source.width(), 300);
+        EXPECT_LE(tile.source.height(), 300);
+    }
+}
+
+TEST(TilePlannerTest, rowsEndAtRightEdge)
+{
+    auto tiles = planTiles(QSize(1000, 700), 300, 10);
+
+    // Targets are 280 wide, so four per row and three rows
+    ASSERT_EQ(tiles.size(), 12u);
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        EXPECT_EQ(tiles[i].row, static_cast<int>(i / 4));
+        EXPECT_EQ(tiles[i].isLastInRow, i % 4 == 3);
+    }
+}
+
+TEST(TilePlannerTest, noTilesIfHaloIsTooBig)
+{
+    EXPECT_TRUE(planTiles(QSize(1000, 700), 300, 150).empty());
+}
+
+#endif // TST_TILEPLANNER_H